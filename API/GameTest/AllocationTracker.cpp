@@ -0,0 +1,259 @@
+//------------------------------------------------------------------------
+// AllocationTracker.cpp
+//------------------------------------------------------------------------
+#include "stdafx.h"
+#include "AllocationTracker.h"
+#include "DebugUtils.h"
+#include <atomic>
+#include <new>
+#include <stdlib.h>
+#include <windows.h>
+
+static const char* TAG_NAMES[(int)AllocTag::Count] = {
+    "Untagged", "Game", "Galaxy", "Stars", "Render", "UI"
+};
+
+const char* AllocationTracker::GetTagName(AllocTag tag) {
+    return (int)tag < (int)AllocTag::Count ? TAG_NAMES[(int)tag] : "?";
+}
+
+static AllocationTracker::Report lastFrame;
+static AllocationTracker::Report totals;
+static int warmupFrames = 120;
+static int steadyStateAllocatingFrames = 0;
+static int peakFrameAllocations = 0;
+static int frameLimit = 0;
+static char reportPath[MAX_PATH] = "";
+
+#if TRACK_ALLOCATIONS
+
+// Everything here is touched from operator new, so it must not allocate and
+// must be usable before static constructors run.
+struct AtomicTagStats {
+    std::atomic<int> allocations;
+    std::atomic<int> frees;
+    std::atomic<size_t> bytes;
+    std::atomic<long long> liveBytes;
+};
+
+static std::atomic<bool> tagTracking(false);
+static std::atomic<int> currentFrameAllocations(0);
+static std::atomic<size_t> currentFrameBytes(0);
+static AtomicTagStats currentFrameTags[(int)AllocTag::Count];
+static std::atomic<long long> liveBytesByTag[(int)AllocTag::Count];
+static thread_local AllocTag threadTag = AllocTag::Untagged;
+
+// Every block carries its size and tag so frees can be attributed
+struct BlockHeader {
+    size_t size;
+    AllocTag tag;
+};
+static const size_t HEADER_SIZE = 16;
+static_assert(sizeof(BlockHeader) <= HEADER_SIZE, "Block header doesn't fit");
+
+static void* TrackedAlloc(size_t size) {
+    uint8_t* block = static_cast<uint8_t*>(malloc(size + HEADER_SIZE));
+    if (!block) throw std::bad_alloc();
+
+    BlockHeader* header = reinterpret_cast<BlockHeader*>(block);
+    header->size = size;
+    header->tag = threadTag;
+
+    currentFrameAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (tagTracking.load(std::memory_order_relaxed)) {
+        AtomicTagStats& stats = currentFrameTags[(int)header->tag];
+        stats.allocations.fetch_add(1, std::memory_order_relaxed);
+        stats.bytes.fetch_add(size, std::memory_order_relaxed);
+        currentFrameBytes.fetch_add(size, std::memory_order_relaxed);
+        liveBytesByTag[(int)header->tag].fetch_add((long long)size, std::memory_order_relaxed);
+    }
+    return block + HEADER_SIZE;
+}
+
+static void TrackedFree(void* pointer) {
+    if (!pointer) return;
+
+    uint8_t* block = static_cast<uint8_t*>(pointer) - HEADER_SIZE;
+    const BlockHeader* header = reinterpret_cast<const BlockHeader*>(block);
+    if (tagTracking.load(std::memory_order_relaxed)) {
+        currentFrameTags[(int)header->tag].frees.fetch_add(1, std::memory_order_relaxed);
+        liveBytesByTag[(int)header->tag].fetch_sub((long long)header->size, std::memory_order_relaxed);
+    }
+    free(block);
+}
+
+void* operator new(size_t size) { return TrackedAlloc(size); }
+void* operator new[](size_t size) { return TrackedAlloc(size); }
+void operator delete(void* block) noexcept { TrackedFree(block); }
+void operator delete[](void* block) noexcept { TrackedFree(block); }
+void operator delete(void* block, size_t) noexcept { TrackedFree(block); }
+void operator delete[](void* block, size_t) noexcept { TrackedFree(block); }
+
+void AllocationTracker::Enable(bool enable) {
+    tagTracking = enable;
+}
+
+bool AllocationTracker::IsEnabled() {
+    return tagTracking;
+}
+
+void AllocationTracker::BeginFrame() {
+    Report frame;
+    frame.frames = 1;
+    frame.allocations = currentFrameAllocations.exchange(0);
+    frame.bytes = currentFrameBytes.exchange(0);
+    for (int i = 0; i < (int)AllocTag::Count; i++) {
+        TagStats& tag = frame.tags[i];
+        tag.allocations = currentFrameTags[i].allocations.exchange(0);
+        tag.frees = currentFrameTags[i].frees.exchange(0);
+        tag.bytes = currentFrameTags[i].bytes.exchange(0);
+        tag.liveBytes = liveBytesByTag[i].load();
+    }
+    lastFrame = frame;
+
+    totals.frames++;
+    totals.allocations += frame.allocations;
+    totals.bytes += frame.bytes;
+    for (int i = 0; i < (int)AllocTag::Count; i++) {
+        totals.tags[i].allocations += frame.tags[i].allocations;
+        totals.tags[i].frees += frame.tags[i].frees;
+        totals.tags[i].bytes += frame.tags[i].bytes;
+        totals.tags[i].liveBytes = frame.tags[i].liveBytes;
+    }
+
+    if (totals.frames > warmupFrames) {
+        if (frame.allocations > 0) steadyStateAllocatingFrames++;
+        if (frame.allocations > peakFrameAllocations) peakFrameAllocations = frame.allocations;
+    }
+}
+
+int AllocationTracker::GetFrameAllocations() {
+    return lastFrame.allocations;
+}
+
+AllocTag AllocationTracker::SetThreadTag(AllocTag tag) {
+    AllocTag previous = threadTag;
+    threadTag = tag;
+    return previous;
+}
+
+static long long GetLiveBytes(int tag) {
+    return liveBytesByTag[tag].load();
+}
+
+#else
+
+void AllocationTracker::Enable(bool) {
+}
+
+bool AllocationTracker::IsEnabled() {
+    return false;
+}
+
+void AllocationTracker::BeginFrame() {
+    totals.frames++;
+}
+
+int AllocationTracker::GetFrameAllocations() {
+    return -1;
+}
+
+AllocTag AllocationTracker::SetThreadTag(AllocTag) {
+    return AllocTag::Untagged;
+}
+
+static long long GetLiveBytes(int) {
+    return 0;
+}
+
+#endif
+
+const AllocationTracker::Report& AllocationTracker::GetLastFrame() {
+    return lastFrame;
+}
+
+const AllocationTracker::Report& AllocationTracker::GetTotals() {
+    return totals;
+}
+
+void AllocationTracker::SetWarmupFrames(int frames) {
+    warmupFrames = frames;
+}
+
+int AllocationTracker::GetSteadyStateAllocatingFrames() {
+    return steadyStateAllocatingFrames;
+}
+
+int AllocationTracker::GetPeakFrameAllocations() {
+    return peakFrameAllocations;
+}
+
+void AllocationTracker::WriteReport(FILE* out) {
+    fprintf(out, "tracking=%s\n", TRACK_ALLOCATIONS ? (IsEnabled() ? "tags" : "counts") : "off");
+    fprintf(out, "frames=%d\n", totals.frames);
+    fprintf(out, "warmup_frames=%d\n", warmupFrames);
+    fprintf(out, "steady_state_allocating_frames=%d\n", steadyStateAllocatingFrames);
+    fprintf(out, "peak_frame_allocations=%d\n", peakFrameAllocations);
+    fprintf(out, "total_allocations=%d\n", totals.allocations);
+    fprintf(out, "total_bytes=%zu\n", totals.bytes);
+    fprintf(out, "last_frame_allocations=%d\n", lastFrame.allocations);
+    fprintf(out, "last_frame_bytes=%zu\n", lastFrame.bytes);
+
+    fprintf(out, "\n%-10s %12s %12s %14s %14s %12s\n",
+        "tag", "allocs", "frees", "bytes", "live bytes", "last frame");
+    for (int i = 0; i < (int)AllocTag::Count; i++) {
+        // Live bytes are read now, so at exit they are what leaked
+        const TagStats& tag = totals.tags[i];
+        fprintf(out, "%-10s %12d %12d %14zu %14lld %12d\n",
+            TAG_NAMES[i], tag.allocations, tag.frees, tag.bytes, GetLiveBytes(i),
+            lastFrame.tags[i].allocations);
+    }
+}
+
+bool AllocationTracker::ConfigureFromEnvironment() {
+    if (!GetEnvironmentVariableA("GAMETEST_ALLOC_REPORT", reportPath, sizeof(reportPath))) {
+        reportPath[0] = '\0';
+        return false;
+    }
+
+    char value[32];
+    if (GetEnvironmentVariableA("GAMETEST_ALLOC_FRAMES", value, sizeof(value))) {
+        frameLimit = atoi(value);
+    }
+    if (GetEnvironmentVariableA("GAMETEST_ALLOC_WARMUP", value, sizeof(value))) {
+        warmupFrames = atoi(value);
+    }
+
+#if TRACK_ALLOCATIONS
+    Enable(true);
+    return true;
+#else
+    // Nothing would be counted and the steady state check would pass
+    DebugPrint("AllocationTracker: GAMETEST_ALLOC_REPORT needs TRACK_ALLOCATIONS defined to 1\n");
+    return false;
+#endif
+}
+
+bool AllocationTracker::IsConfigured() {
+    return reportPath[0] != '\0';
+}
+
+// A run that can't count ends on its first frame
+bool AllocationTracker::IsFrameLimitReached() {
+    if (!TRACK_ALLOCATIONS && IsConfigured()) return true;
+    return frameLimit > 0 && totals.frames >= frameLimit;
+}
+
+void AllocationTracker::WriteConfiguredReport() {
+    if (reportPath[0] != '\0') {
+        WriteReport(reportPath);
+    }
+}
+
+bool AllocationTracker::WriteReport(const char* path) {
+    FILE* out = nullptr;
+    if (fopen_s(&out, path, "w") != 0 || !out) return false;
+    WriteReport(out);
+    fclose(out);
+    return true;
+}
@@ -0,0 +1,100 @@
+//------------------------------------------------------------------------
+// AllocationTracker.h
+//------------------------------------------------------------------------
+#ifndef ALLOCATION_TRACKER_H
+#define ALLOCATION_TRACKER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <stdio.h>
+
+// Hooks the global operator new/delete to count heap allocations per frame
+// and, once enabled, per tag with byte totals. Steady state gameplay should
+// read zero. Replacing operator new affects every allocation in the
+// process, so the hooks are opt in: define TRACK_ALLOCATIONS to 1 in the
+// project's preprocessor definitions to compile them in.
+#ifndef TRACK_ALLOCATIONS
+#define TRACK_ALLOCATIONS 0
+#endif
+
+// What the current thread is allocating for, see AllocationScope
+enum class AllocTag : uint8_t {
+    Untagged,
+    Game,
+    Galaxy,
+    Stars,
+    Render,
+    UI,
+    Count
+};
+
+class AllocationTracker {
+public:
+    struct TagStats {
+        int allocations = 0;
+        int frees = 0;
+        size_t bytes = 0;           // Bytes allocated
+        long long liveBytes = 0;    // Allocated minus freed, run totals only
+    };
+
+    struct Report {
+        int frames = 0;
+        int allocations = 0;
+        size_t bytes = 0;
+        TagStats tags[(int)AllocTag::Count];
+    };
+
+    // Tag and byte tracking, off by default. Frame allocation counts are
+    // always kept while the hooks are compiled in. Enable before anything
+    // is allocated for exact live byte counts.
+    static void Enable(bool enable);
+    static bool IsEnabled();
+
+    // Ends the current frame's count and starts the next one
+    static void BeginFrame();
+
+    // Allocations made during the last complete frame, -1 if not tracking
+    static int GetFrameAllocations();
+    static const Report& GetLastFrame();
+    static const Report& GetTotals();
+
+    // Frames after the warmup that still allocated, for enforcing an
+    // allocation free steady state
+    static void SetWarmupFrames(int frames);
+    static int GetSteadyStateAllocatingFrames();
+    static int GetPeakFrameAllocations();
+
+    static AllocTag SetThreadTag(AllocTag tag);   // Returns the previous tag
+    static const char* GetTagName(AllocTag tag);
+
+    // Plain text report of the run totals and the last frame
+    static void WriteReport(FILE* out);
+    static bool WriteReport(const char* path);
+
+    // Headless runs, e.g. in CI:
+    //   GAMETEST_ALLOC_REPORT  report file written at exit, enables tracking
+    //   GAMETEST_ALLOC_FRAMES  quit after this many frames, failing the run
+    //                          if any frame after the warmup allocated
+    //   GAMETEST_ALLOC_WARMUP  frames ignored by the steady state check
+    // ConfigureFromEnvironment returns false for a configured run when the
+    // hooks aren't compiled in, and that run's frame limit is reached at once.
+    static bool ConfigureFromEnvironment();
+    static bool IsConfigured();
+    static bool IsFrameLimitReached();
+    static void WriteConfiguredReport();
+};
+
+// Tags allocations made on this thread for the lifetime of the scope
+class AllocationScope {
+public:
+    explicit AllocationScope(AllocTag tag) : previous(AllocationTracker::SetThreadTag(tag)) {}
+    ~AllocationScope() { AllocationTracker::SetThreadTag(previous); }
+
+private:
+    AllocationScope(const AllocationScope&) = delete;
+    AllocationScope& operator=(const AllocationScope&) = delete;
+
+    AllocTag previous;
+};
+
+#endif
@@ -8,17 +8,22 @@
 #include <windows.h>
 #include <stdio.h>
 #include <assert.h>
+#include <algorithm>
+#include <iterator>
 
 //-----------------------------------------------------------------------------
 
 #include "app.h"
 #include "AppSettings.h"
 #include "SimpleSprite.h"
+#include "SpriteBatch.h"
+#include "TextureManager.h"
+#include <GLStateCache.h>
 
-#include "../stb_image/stb_image.h"
 #include "../glut/include/GL/freeglut_ext.h"
 
-std::map<std::string, CSimpleSprite::sTextureDef > CSimpleSprite::m_textures;
+std::unordered_map<CSimpleSprite::sSheetKey, std::weak_ptr<CSimpleSprite::sSheet>, CSimpleSprite::sSheetKeyHash> CSimpleSprite::m_sheets;
+size_t CSimpleSprite::m_sheetsPruneSize = 64;
 
 //-----------------------------------------------------------------------------
 CSimpleSprite::CSimpleSprite(const char *fileName, const unsigned int nColumns, const unsigned int nRows)
@@ -27,7 +32,8 @@ CSimpleSprite::CSimpleSprite(const char *fileName, const unsigned int nColumns,
 {
 	if (LoadTexture(fileName))
 	{
-		CalculateUVs();
+		m_width = m_texWidth * (1.0f / m_nColumns);
+		m_height = m_texHeight * (1.0f / m_nRows);
 		m_points[0] = -(m_width / 2.0f);
 		m_points[1] = -(m_height / 2.0f);
 		m_points[2] = m_width / 2.0f;
@@ -37,6 +43,11 @@ CSimpleSprite::CSimpleSprite(const char *fileName, const unsigned int nColumns,
 		m_points[6] = -(m_width / 2.0f);
 		m_points[7] = m_height / 2.0f;
 	}
+	else
+	{
+		m_sheet = GetSheet(-1, m_nColumns, m_nRows, 0.0f, 0.0f, 1.0f, 1.0f);
+	}
+	m_uvcoords = &m_sheet->m_uvs[0];
 }
 
 void CSimpleSprite::Update(const float dt)
@@ -44,43 +55,93 @@ void CSimpleSprite::Update(const float dt)
     if (m_currentAnim >= 0)
     {
         m_animTime += dt/1000.0f;
-        sAnimation &anim = m_animations[m_currentAnim];
-        float duration = anim.m_speed * anim.m_frames.size();
+        const sAnimation &anim = m_sheet->m_animations[m_currentAnim];
 
         //Looping around if reached the end of animation
-        if (m_animTime > duration)
+        if (m_animTime >= anim.m_duration)
+        {
+            m_animTime = fmodf(m_animTime, anim.m_duration);
+        }
+        unsigned int frame = (unsigned int)( m_animTime / anim.m_speed );
+        if (frame >= anim.m_frames.size())
         {
-            m_animTime = fmodf(m_animTime, duration);
+            frame = (unsigned int)anim.m_frames.size() - 1;     // fmodf can round up to the duration
         }
-        int frame = (int)( m_animTime / anim.m_speed );
-        SetFrame(anim.m_frames[frame]);        
+        SetFrame(anim.m_frames[frame]);
     }
 }
 
-void CSimpleSprite::CalculateUVs()
+// Builds the corners of every frame once, in the order Draw walks m_points
+std::shared_ptr<CSimpleSprite::sSheet> CSimpleSprite::GetSheet(const int textureId, const unsigned int nColumns,
+    const unsigned int nRows, const float u0, const float v0, const float u1, const float v1)
 {
-    float u = 1.0f / m_nColumns;
-    float v = 1.0f / m_nRows;
-    int row = m_frame / m_nColumns;
-    int column = m_frame % m_nColumns;
+    sSheetKey key = { textureId, nColumns, nRows };
+    auto found = m_sheets.find(key);
+    std::shared_ptr<sSheet> sheet = found != m_sheets.end() ? found->second.lock() : nullptr;
+    // A name re-registered as an atlas region needs a table of its own
+    if (sheet && sheet->m_regionU0 == u0 && sheet->m_regionV0 == v0 && sheet->m_regionU1 == u1 && sheet->m_regionV1 == v1)
+    {
+        return sheet;
+    }
+
+    // Sheets go when their last sprite does, but their keys stay until here.
+    // Pruning only when the map has doubled keeps it amortised.
+    if (found == m_sheets.end() && m_sheets.size() >= m_sheetsPruneSize)
+    {
+        for (auto it = m_sheets.begin(); it != m_sheets.end();)
+        {
+            it = it->second.expired() ? m_sheets.erase(it) : std::next(it);
+        }
+        m_sheetsPruneSize = std::max<size_t>(64, m_sheets.size() * 2);
+    }
+
+    sheet = std::make_shared<sSheet>();
+    sheet->m_nColumns = nColumns;
+    sheet->m_nRows = nRows;
+    sheet->m_regionU0 = u0;
+    sheet->m_regionV0 = v0;
+    sheet->m_regionU1 = u1;
+    sheet->m_regionV1 = v1;
+    sheet->m_uvs.resize(nColumns * nRows * 8);
+
+    float u = 1.0f / nColumns;
+    float v = 1.0f / nRows;
+    for (unsigned int frame = 0; frame < nColumns * nRows; frame++)
+    {
+        int row = frame / nColumns;
+        int column = frame % nColumns;
+        float *uvs = &sheet->m_uvs[frame * 8];
+        uvs[0] = u * column;
+        uvs[1] = v * (float)(row + 1);
 
-    m_width = m_texWidth * u;
-    m_height = m_texHeight * v;
-    m_uvcoords[0] = u * column;
-    m_uvcoords[1] = v * (float)(row+1);
+        uvs[2] = u * (float)(column + 1);
+        uvs[3] = v * (float)(row + 1);
 
-    m_uvcoords[2] = u * (float)(column+1);
-    m_uvcoords[3] = v * (float)(row + 1);
+        uvs[4] = u * (float)(column + 1);
+        uvs[5] = v * row;
 
-    m_uvcoords[4] = u * (float)(column + 1);
-    m_uvcoords[5] = v * row;
+        uvs[6] = u * column;
+        uvs[7] = v * row;
 
-    m_uvcoords[6] = u * column;
-    m_uvcoords[7] = v * row;
+        // Sheets packed into an atlas only cover part of the texture
+        for (int i = 0; i < 8; i += 2)
+        {
+            uvs[i] = u0 + uvs[i] * (u1 - u0);
+            uvs[i + 1] = v0 + uvs[i + 1] * (v1 - v0);
+        }
+    }
+    m_sheets[key] = sheet;
+    return sheet;
 }
 
 void CSimpleSprite::Draw()
-{            
+{
+    GLStateCache gl;
+    Draw(gl);
+}
+
+void CSimpleSprite::Draw(GLStateCache &gl)
+{
 #if APP_USE_VIRTUAL_RES
     float scalex = (m_scale / APP_VIRTUAL_WIDTH) * 2.0f;
     float scaley = (m_scale / APP_VIRTUAL_HEIGHT) * 2.0f;
@@ -98,10 +159,10 @@ void CSimpleSprite::Draw()
     glTranslatef(x, y, 0.0f);   
     glScalef(scalex, scaley, 1.0f);    
     glRotatef(m_angle * 180 / PI, 0.0f, 0.0f, 1.0f);     
-	glColor3f(m_red, m_green, m_blue);
-    glEnable(GL_BLEND);    
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);    
-    glEnable(GL_TEXTURE_2D);
+    gl.Color(m_red, m_green, m_blue);
+    gl.Enable(GL_BLEND);
+    gl.BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    gl.Enable(GL_TEXTURE_2D);
     glBindTexture(GL_TEXTURE_2D, m_texture);
 
     glBegin(GL_QUADS);       
@@ -112,8 +173,26 @@ void CSimpleSprite::Draw()
     }
     glEnd();
     glPopMatrix();
-    glDisable(GL_BLEND);
-    glDisable(GL_TEXTURE_2D);
+    gl.Disable(GL_BLEND);
+    gl.Disable(GL_TEXTURE_2D);
+}
+
+void CSimpleSprite::Draw(CSpriteBatch &batch)
+{
+#if APP_USE_VIRTUAL_RES
+    float scalex = (m_scale / APP_VIRTUAL_WIDTH) * 2.0f;
+    float scaley = (m_scale / APP_VIRTUAL_HEIGHT) * 2.0f;
+#else
+    float scalex = m_scale;
+    float scaley = m_scale;
+#endif
+    float x = m_xpos;
+    float y = m_ypos;
+#if APP_USE_VIRTUAL_RES
+    APP_VIRTUAL_TO_NATIVE_COORDS(x, y);
+#endif
+
+    batch.Add(m_texture, m_points, m_uvcoords, x, y, scalex, scaley, m_angle, m_red, m_green, m_blue);
 }
 
 void CSimpleSprite::SetFrame(const unsigned int f)
@@ -123,7 +202,7 @@ void CSimpleSprite::SetFrame(const unsigned int f)
     {
         m_frame = 0;
     }
-    CalculateUVs();
+    m_uvcoords = &m_sheet->m_uvs[m_frame * 8];
 }
 
 void CSimpleSprite::SetAnimation(const int id)
@@ -138,51 +217,54 @@ void CSimpleSprite::SetAnimation(const int id, const bool playFromBeginning)
     {
         m_animTime = 0.0f;
     }
+    m_currentAnim = (id >= 0 && id < (int)m_animationSlots.size()) ? m_animationSlots[id] : -1;
+}
+
+// Sprites of a sheet usually all define the same animations, so identical
+// ones share an entry
+void CSimpleSprite::CreateAnimation(const unsigned int id, const float speed, const std::vector<int> &frames)
+{
+    std::vector<sAnimation> &animations = m_sheet->m_animations;
+    int index = 0;
+    while (index < (int)animations.size() && (animations[index].m_speed != speed || animations[index].m_frames != frames))
+    {
+        index++;
+    }
+    if (index == (int)animations.size())
+    {
+        sAnimation anim;
+        anim.m_speed = speed;
+        anim.m_duration = speed * frames.size();
+        anim.m_frames = frames;
+        animations.push_back(anim);
+    }
 
-    for (int i = 0; i < m_animations.size(); i++)
+    if (id >= m_animationSlots.size())
     {
-        if (m_animations[i].m_id == id)
-        {
-            m_currentAnim = i;
-            return;
-        }
+        m_animationSlots.resize(id + 1, -1);
     }
-    m_currentAnim = -1;
+    m_animationSlots[id] = index;
 }
 
 bool CSimpleSprite::LoadTexture(const std::string& filename)
 {
-    if (m_textures.find(filename) != m_textures.end())
-    {        
-        sTextureDef &texDef = m_textures[filename];
-        m_texture = texDef.m_textureID;
-        m_texWidth = texDef.m_width;
-        m_texHeight = texDef.m_height;
-		return true;
+    CTextureManager &textures = CTextureManager::GetInstance();
+    m_textureHandle = textures.Acquire(filename);
+    if (!m_textureHandle.IsValid())
+    {
+        return false;
     }
-    
-    //unsigned char *imageData = loadBMPRaw(filename, m_texWidth, m_texHeight, true);
 
-    int channels;
-    unsigned char* imageData = stbi_load(filename.c_str(), &m_texWidth, &m_texHeight, &channels, 4);
+    const CTextureManager::sTexture &texDef = textures.Get(m_textureHandle);
+    m_texture = texDef.m_textureID;
+    m_texWidth = texDef.m_width;
+    m_texHeight = texDef.m_height;
+    m_sheet = GetSheet(m_textureHandle.GetId(), m_nColumns, m_nRows, texDef.m_u0, texDef.m_v0, texDef.m_u1, texDef.m_v1);
+    return true;
+}
 
-    GLuint texture = 0;
-	if (imageData)
-	{
-		glGenTextures(1, &texture);
-		glBindTexture(GL_TEXTURE_2D, texture);
-		glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
-		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);
-
-		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		gluBuild2DMipmaps(GL_TEXTURE_2D, 4, m_texWidth, m_texHeight, GL_RGBA, GL_UNSIGNED_BYTE, imageData);
-        stbi_image_free(imageData);
-		sTextureDef textureDef = { (unsigned int) m_texWidth, (unsigned int) m_texHeight, texture };
-		m_textures[filename] = textureDef;
-		m_texture = texture;
-		return true;
-	}
-	return false;
+void CSimpleSprite::AddTextureRegion(const std::string &fileName, GLuint texture, const unsigned int width, const unsigned int height,
+    const float u0, const float v0, const float u1, const float v1)
+{
+    CTextureManager::GetInstance().AddRegion(fileName, texture, width, height, u0, v0, u1, v1);
 }
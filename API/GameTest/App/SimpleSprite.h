@@ -6,9 +6,15 @@
 #define _SIMPLESPRITE_H_
 
 #include "../glut/include/GL/freeglut.h"
-#include <map>
 #include <vector>
 #include <string>
+#include <memory>
+#include <unordered_map>
+
+#include "TextureManager.h"
+
+class CSpriteBatch;
+class GLStateCache;
 
 //-----------------------------------------------------------------------------
 // CSimpleSprite
@@ -20,6 +26,11 @@ public:
     CSimpleSprite(const char *fileName, const unsigned int nColumns = 1, const unsigned int nRows = 1);
     void Update(const float dt);
     void Draw();
+    // Sets blend, texture and colour through gl, for code that also draws
+    // through the renderer's state cache. Draw() starts from unknown state.
+    void Draw(GLStateCache &gl);
+    // Queues the sprite in a batch instead of drawing it straight away
+    void Draw(CSpriteBatch &batch);
     void SetPosition(const float x, const float y) { m_xpos = x; m_ypos = y; }   
     void SetAngle(const float a)  { m_angle = a; }
     void SetScale(const float s) { m_scale = s >= 0.0f ? s : 0.0f; }
@@ -32,21 +43,20 @@ public:
     float GetAngle()  const { return m_angle;  }
     float GetScale()  const { return m_scale;  }
     unsigned int GetFrame()  const { return m_frame; }
+    // Texture coordinates of the current frame's corners
+    const float *GetUVs() const { return m_uvcoords; }
 	void SetColor(const float r, const float g, const float b) { m_red = r; m_green = g; m_blue = b; }
 
+    // Makes sprites created from fileName use part of an already loaded texture, like a
+    // sheet packed into a CSpriteAtlas. width and height are the region's size in pixels.
+    static void AddTextureRegion(const std::string &fileName, GLuint texture, const unsigned int width, const unsigned int height,
+        const float u0, const float v0, const float u1, const float v1);
+
     // Note: speed must be > 0, frames must have size >= 1, id must be unique among animations
-    void CreateAnimation(const unsigned int id, const float speed, const std::vector<int> &frames)
-    {
-        sAnimation anim;        
-        anim.m_id = id;
-        anim.m_speed = speed;
-        anim.m_frames = frames;
-        m_animations.push_back(anim);        
-    };
+    void CreateAnimation(const unsigned int id, const float speed, const std::vector<int> &frames);
 
 private:
-    void CalculateUVs();
-    GLuint m_texture;
+    GLuint m_texture = 0;
     float m_xpos = 0.0f;
     float m_ypos = 0.0f;
     float m_width = 0.0f;
@@ -56,33 +66,64 @@ private:
     float m_angle = 0.0f;
     float m_scale = 1.0f;
     float m_points[8];    
-    float m_uvcoords[8];
-    unsigned int m_frame;
+    const float *m_uvcoords;    // Into m_sheet's table
+    unsigned int m_frame = 0;
     unsigned int m_nColumns;
     unsigned int m_nRows;
 	float m_red = 1.0f;
 	float m_green = 1.0f;
 	float m_blue = 1.0f;
-    int   m_currentAnim = -1;
+    int   m_currentAnim = -1;   // Index into m_sheet's animations
     float m_animTime = 0.0f;
+    std::vector<int> m_animationSlots;  // Animation index by id, -1 where there's none
 
+    // Everything about a sprite sheet that doesn't change per sprite. Sprites
+    // from the same texture and grid share one, so a frame change is a table
+    // index and identical animations are stored once.
     struct sAnimation
     {
-        unsigned int m_id = 0;
         float m_speed = 0.0f;
+        float m_duration = 0.0f;
         std::vector<int> m_frames;
     };
-    std::vector<sAnimation> m_animations;
+    struct sSheet
+    {
+        unsigned int m_nColumns;
+        unsigned int m_nRows;
+        float m_regionU0, m_regionV0, m_regionU1, m_regionV1;   // Part of the texture the sheet occupies
+        std::vector<float> m_uvs;                               // 8 per frame, fixed once built
+        std::vector<sAnimation> m_animations;
+    };
+    std::shared_ptr<sSheet> m_sheet;
 
-    // Texture management.
-    struct sTextureDef
+    // Sheets by the texture manager's id for the file, -1 for sprites whose
+    // texture didn't load, and grid
+    struct sSheetKey
+    {
+        int m_textureId;
+        unsigned int m_nColumns;
+        unsigned int m_nRows;
+        bool operator==(const sSheetKey &other) const
+        {
+            return m_textureId == other.m_textureId && m_nColumns == other.m_nColumns && m_nRows == other.m_nRows;
+        }
+    };
+    struct sSheetKeyHash
     {
-        unsigned int m_width;
-        unsigned int m_height;
-        GLuint m_textureID;
+        size_t operator()(const sSheetKey &key) const
+        {
+            return std::hash<uint64_t>()(((uint64_t)(uint32_t)key.m_textureId << 32) ^ ((uint64_t)key.m_nColumns << 16) ^ key.m_nRows);
+        }
     };
+
+    static std::shared_ptr<sSheet> GetSheet(const int textureId, const unsigned int nColumns, const unsigned int nRows,
+        const float u0, const float v0, const float u1, const float v1);
+    static std::unordered_map<sSheetKey, std::weak_ptr<sSheet>, sSheetKeyHash> m_sheets;
+    static size_t m_sheetsPruneSize;     // Drop expired sheets once the map reaches this
+
+    // Texture management. The handle keeps m_texture loaded for the sprite's lifetime.
     bool LoadTexture(const std::string& filename);
-    static std::map<std::string, sTextureDef> m_textures;    
+    CTextureHandle m_textureHandle;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,314 @@
+///////////////////////////////////////////////////////////////////////////////
+// Filename: SpriteAtlas.cpp
+// Packs sprite sheets into one texture so sprites drawn together share it.
+///////////////////////////////////////////////////////////////////////////////
+//-----------------------------------------------------------------------------
+#include "stdafx.h"
+//-----------------------------------------------------------------------------
+#include <windows.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <algorithm>
+
+#include "SpriteAtlas.h"
+#include "SimpleSprite.h"
+#include "TextureManager.h"
+
+#include "../stb_image/stb_image.h"
+
+// GL 1.2, missing from the Windows headers
+#ifndef GL_TEXTURE_MAX_LEVEL
+#define GL_TEXTURE_MAX_LEVEL 0x813D
+#endif
+
+static const char ATLAS_MAGIC[4] = { 'S', 'A', 'T', 'L' };
+static const uint32_t ATLAS_VERSION = 2;        // 1 had unaligned cells
+
+static int RoundUp(int value, int multiple)
+{
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+int CSpriteAtlas::Pack(const std::vector<sRect> &sizes, const int atlasWidth, const int maxHeight, const int padding,
+    std::vector<sRect> &placed, int &usedHeight)
+{
+    std::vector<int> order(sizes.size());
+    for (int i = 0; i < (int)order.size(); i++)
+    {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return sizes[a].m_height > sizes[b].m_height; });
+
+    placed.assign(sizes.size(), { 0, 0, 0, 0 });
+    usedHeight = 0;
+    int count = 0;
+    int penX = 0, penY = 0, rowHeight = 0;
+    for (int index : order)
+    {
+        int width = sizes[index].m_width + 2 * padding;
+        int height = sizes[index].m_height + 2 * padding;
+        if (width > atlasWidth)
+        {
+            continue;
+        }
+        if (penX + width > atlasWidth)
+        {
+            penX = 0;
+            penY += rowHeight;
+            rowHeight = 0;
+        }
+        if (penY + height > maxHeight)
+        {
+            continue;
+        }
+
+        placed[index] = { penX + padding, penY + padding, sizes[index].m_width, sizes[index].m_height };
+        penX += width;
+        rowHeight = std::max(rowHeight, height);
+        usedHeight = std::max(usedHeight, penY + height);
+        count++;
+    }
+    return count;
+}
+
+bool CSpriteAtlas::AddFile(const std::string &fileName)
+{
+    int width, height, channels;
+    unsigned char *pixels = stbi_load(fileName.c_str(), &width, &height, &channels, 4);
+    if (!pixels)
+    {
+        return false;
+    }
+    AddImage(fileName, width, height, pixels);
+    stbi_image_free(pixels);
+    return true;
+}
+
+void CSpriteAtlas::AddImage(const std::string &name, const int width, const int height, const unsigned char *pixels)
+{
+    sImage image;
+    image.m_name = name;
+    image.m_width = width;
+    image.m_height = height;
+    image.m_pixels.assign(pixels, pixels + width * height * 4);
+    m_images.push_back(std::move(image));
+}
+
+int CSpriteAtlas::Build(const int atlasWidth, const int maxHeight)
+{
+    // Cells, padding included, are whole multiples of CELL_ALIGN, so the
+    // packer lines every cell up on it
+    std::vector<sRect> sizes;
+    for (const sImage &image : m_images)
+    {
+        sizes.push_back({ 0, 0, RoundUp(image.m_width + 2 * PADDING, CELL_ALIGN) - 2 * PADDING,
+            RoundUp(image.m_height + 2 * PADDING, CELL_ALIGN) - 2 * PADDING });
+    }
+    std::vector<sRect> placed;
+    int usedHeight = 0;
+    int count = Pack(sizes, atlasWidth, maxHeight, PADDING, placed, usedHeight);
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    m_width = atlasWidth;
+    m_height = 1;
+    while (m_height < usedHeight)
+    {
+        m_height *= 2;
+    }
+    m_pixels.assign(m_width * m_height * 4, 0);
+    m_regions.clear();
+
+    for (int i = 0; i < (int)m_images.size(); i++)
+    {
+        const sImage &image = m_images[i];
+        sRect &rect = placed[i];
+        if (rect.m_width == 0)
+        {
+            continue;
+        }
+
+        // Copy the image, repeating its edge pixels over the rest of the
+        // cell so filtering at the border, at any level, doesn't pick up
+        // the neighbours
+        for (int y = -PADDING; y < rect.m_height + PADDING; y++)
+        {
+            int sourceY = std::min(std::max(y, 0), image.m_height - 1);
+            for (int x = -PADDING; x < rect.m_width + PADDING; x++)
+            {
+                int sourceX = std::min(std::max(x, 0), image.m_width - 1);
+                const unsigned char *source = &image.m_pixels[(sourceY * image.m_width + sourceX) * 4];
+                unsigned char *target = &m_pixels[((rect.m_y + y) * m_width + rect.m_x + x) * 4];
+                std::copy(source, source + 4, target);
+            }
+        }
+        rect.m_width = image.m_width;
+        rect.m_height = image.m_height;
+        m_regions.push_back({ image.m_name, rect });
+    }
+    m_images.clear();
+
+    RetireTexture();
+    Upload();
+    return count;
+}
+
+// Sprites from the last Build or Load may still be drawing its texture
+void CSpriteAtlas::RetireTexture()
+{
+    if (m_texture)
+    {
+        CTextureManager::GetInstance().RetireTexture(m_texture, GetMipBytes(m_width, m_height));
+        m_texture = 0;
+    }
+}
+
+size_t CSpriteAtlas::GetMipBytes(const int width, const int height)
+{
+    size_t total = 0;
+    for (int level = 0; level < MIP_LEVELS; level++)
+    {
+        total += (size_t)(width >> level) * (height >> level) * 4;
+    }
+    return total;
+}
+
+// Level 0 and the MIP_LEVELS - 1 below it, each box filtered from the one
+// above. Cells are multiples of CELL_ALIGN, so their edges are on even
+// pixels of every level another is filtered from and no 2x2 block spans two.
+void CSpriteAtlas::Upload()
+{
+    glGenTextures(1, &m_texture);
+    glBindTexture(GL_TEXTURE_2D, m_texture);
+    glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, MIP_LEVELS - 1);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_width, m_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, m_pixels.data());
+
+    std::vector<unsigned char> above = m_pixels;
+    std::vector<unsigned char> level;
+    int aboveWidth = m_width, aboveHeight = m_height;
+    for (int i = 1; i < MIP_LEVELS; i++)
+    {
+        int width = aboveWidth / 2, height = aboveHeight / 2;
+        level.resize((size_t)width * height * 4);
+        for (int y = 0; y < height; y++)
+        {
+            const unsigned char *row0 = &above[(size_t)(y * 2) * aboveWidth * 4];
+            const unsigned char *row1 = row0 + aboveWidth * 4;
+            for (int x = 0; x < width; x++)
+            {
+                for (int c = 0; c < 4; c++)
+                {
+                    int sum = row0[x * 8 + c] + row0[x * 8 + 4 + c] + row1[x * 8 + c] + row1[x * 8 + 4 + c];
+                    level[((size_t)y * width + x) * 4 + c] = (unsigned char)((sum + 2) / 4);
+                }
+            }
+        }
+        glTexImage2D(GL_TEXTURE_2D, i, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, level.data());
+        above.swap(level);
+        aboveWidth = width;
+        aboveHeight = height;
+    }
+
+    for (const sRegion &region : m_regions)
+    {
+        const sRect &rect = region.m_rect;
+        CSimpleSprite::AddTextureRegion(region.m_name, m_texture, rect.m_width, rect.m_height,
+            (float)rect.m_x / m_width, (float)rect.m_y / m_height,
+            (float)(rect.m_x + rect.m_width) / m_width, (float)(rect.m_y + rect.m_height) / m_height);
+    }
+}
+
+// Layout: magic, version, width, height, region count, then per region the
+// name length, name and rect, then width * height RGBA pixels
+bool CSpriteAtlas::Save(const char *fileName) const
+{
+    if (m_pixels.empty())
+    {
+        return false;
+    }
+    FILE *out = nullptr;
+    if (fopen_s(&out, fileName, "wb") != 0 || !out)
+    {
+        return false;
+    }
+
+    int32_t header[3] = { m_width, m_height, (int32_t)m_regions.size() };
+    fwrite(ATLAS_MAGIC, sizeof(ATLAS_MAGIC), 1, out);
+    fwrite(&ATLAS_VERSION, sizeof(ATLAS_VERSION), 1, out);
+    fwrite(header, sizeof(header), 1, out);
+    for (const sRegion &region : m_regions)
+    {
+        uint32_t nameLength = (uint32_t)region.m_name.size();
+        int32_t rect[4] = { region.m_rect.m_x, region.m_rect.m_y, region.m_rect.m_width, region.m_rect.m_height };
+        fwrite(&nameLength, sizeof(nameLength), 1, out);
+        fwrite(region.m_name.data(), 1, nameLength, out);
+        fwrite(rect, sizeof(rect), 1, out);
+    }
+    bool written = fwrite(m_pixels.data(), 1, m_pixels.size(), out) == m_pixels.size();
+    return fclose(out) == 0 && written;
+}
+
+bool CSpriteAtlas::Load(const char *fileName)
+{
+    FILE *in = nullptr;
+    if (fopen_s(&in, fileName, "rb") != 0 || !in)
+    {
+        return false;
+    }
+
+    char magic[4];
+    uint32_t version = 0;
+    int32_t header[3];
+    bool valid = fread(magic, sizeof(magic), 1, in) == 1 && memcmp(magic, ATLAS_MAGIC, sizeof(magic)) == 0 &&
+        fread(&version, sizeof(version), 1, in) == 1 && version == ATLAS_VERSION &&
+        fread(header, sizeof(header), 1, in) == 1 && header[0] >= CELL_ALIGN && header[1] >= CELL_ALIGN &&
+        header[0] % CELL_ALIGN == 0 && header[1] % CELL_ALIGN == 0 && header[2] >= 0;
+
+    std::vector<sRegion> regions;
+    for (int i = 0; valid && i < header[2]; i++)
+    {
+        uint32_t nameLength = 0;
+        int32_t rect[4];
+        sRegion region;
+        valid = fread(&nameLength, sizeof(nameLength), 1, in) == 1 && nameLength < MAX_PATH;
+        if (valid)
+        {
+            region.m_name.resize(nameLength);
+            valid = fread(&region.m_name[0], 1, nameLength, in) == nameLength && fread(rect, sizeof(rect), 1, in) == 1;
+        }
+        if (valid)
+        {
+            region.m_rect = { rect[0], rect[1], rect[2], rect[3] };
+            regions.push_back(region);
+        }
+    }
+
+    std::vector<unsigned char> pixels;
+    if (valid)
+    {
+        pixels.resize((size_t)header[0] * header[1] * 4);
+        valid = fread(pixels.data(), 1, pixels.size(), in) == pixels.size();
+    }
+    fclose(in);
+    if (!valid)
+    {
+        return false;
+    }
+
+    RetireTexture();
+    m_width = header[0];
+    m_height = header[1];
+    m_regions = std::move(regions);
+    m_pixels = std::move(pixels);
+    Upload();
+    return true;
+}
@@ -0,0 +1,92 @@
+//-----------------------------------------------------------------------------
+// SpriteAtlas.h
+// Packs sprite sheets into one texture so sprites drawn together share it.
+//-----------------------------------------------------------------------------
+#ifndef _SPRITEATLAS_H_
+#define _SPRITEATLAS_H_
+
+#include "../glut/include/GL/freeglut.h"
+#include <vector>
+#include <string>
+
+//-----------------------------------------------------------------------------
+// CSpriteAtlas
+// Add images by file or from memory, then Build packs them into one texture
+// and registers each with CSimpleSprite under its name. Sprites created after
+// that with the same file name draw from the atlas, so a CSpriteBatch can put
+// them all in one draw. Build can run offline: Save writes the packed sheet
+// and Load brings it back without decoding or packing anything.
+// Each image sits in its own cell aligned to the smallest mip level, so the
+// few levels the atlas has are filtered per region and never blend in the
+// neighbours. The texture lives until exit, or until a later Build or Load
+// hands it to CTextureManager to delete once its sprites are gone.
+//-----------------------------------------------------------------------------
+class CSpriteAtlas
+{
+public:
+    struct sRect
+    {
+        int m_x, m_y;
+        int m_width, m_height;
+    };
+
+    // Shelf packer, usable without GL. Places each size in a sheet atlasWidth
+    // wide, tallest first, in rows from the top, with padding pixels around
+    // each. placed gets the inner rect of each size; ones that would go past
+    // maxHeight get a zero width. Returns how many were placed.
+    static int Pack(const std::vector<sRect> &sizes, const int atlasWidth, const int maxHeight, const int padding,
+        std::vector<sRect> &placed, int &usedHeight);
+
+    bool AddFile(const std::string &fileName);
+    // RGBA pixels, rows top down as stb_image loads them
+    void AddImage(const std::string &name, const int width, const int height, const unsigned char *pixels);
+
+    // Images that don't fit keep loading as their own textures. atlasWidth
+    // and maxHeight should be powers of two, at least CELL_ALIGN. Returns how
+    // many were packed.
+    int Build(const int atlasWidth = 2048, const int maxHeight = 2048);
+
+    bool Save(const char *fileName) const;
+    bool Load(const char *fileName);
+
+    GLuint GetTexture() const { return m_texture; }
+    int GetWidth() const { return m_width; }
+    int GetHeight() const { return m_height; }
+    int GetRegionCount() const { return (int)m_regions.size(); }
+
+    // Mip levels the texture has, level 0 included. Minifying further than
+    // that shimmers instead of blurring.
+    static const int MIP_LEVELS = 4;
+    static const int CELL_ALIGN = 1 << (MIP_LEVELS - 1);
+
+private:
+    // Edge pixels repeated around each image, still one pixel at the
+    // smallest level
+    static const int PADDING = CELL_ALIGN;
+
+    struct sImage
+    {
+        std::string m_name;
+        int m_width, m_height;
+        std::vector<unsigned char> m_pixels;
+    };
+
+    struct sRegion
+    {
+        std::string m_name;
+        sRect m_rect;
+    };
+
+    static size_t GetMipBytes(const int width, const int height);
+    void RetireTexture();
+    void Upload();
+
+    std::vector<sImage> m_images;
+    std::vector<sRegion> m_regions;
+    std::vector<unsigned char> m_pixels;
+    int m_width = 0;
+    int m_height = 0;
+    GLuint m_texture = 0;
+};
+
+#endif
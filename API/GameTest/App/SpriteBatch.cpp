@@ -0,0 +1,129 @@
+///////////////////////////////////////////////////////////////////////////////
+// Filename: SpriteBatch.cpp
+// Collects a frame's sprites and draws them with one vertex array draw per texture.
+///////////////////////////////////////////////////////////////////////////////
+//-----------------------------------------------------------------------------
+#include "stdafx.h"
+//-----------------------------------------------------------------------------
+#include <windows.h>
+#include <math.h>
+#include <algorithm>
+
+#include "SpriteBatch.h"
+#include <GLStateCache.h>
+
+static inline uint8_t ToByte(const float value)
+{
+    return (uint8_t)(std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f);
+}
+
+void CSpriteBatch::Begin()
+{
+    m_vertices.clear();
+    m_spriteRuns.clear();
+    m_runs.clear();
+    m_lastRun = -1;
+}
+
+void CSpriteBatch::Add(GLuint texture, const float points[8], const float uvs[8], const float x, const float y,
+    const float scaleX, const float scaleY, const float angle, const float r, const float g, const float b)
+{
+    // Sprites mostly come in long runs of the same texture and a frame only
+    // uses a handful, so a linear lookup behind a last-used check is enough
+    if (m_lastRun < 0 || m_runs[m_lastRun].m_texture != texture)
+    {
+        m_lastRun = -1;
+        for (int i = 0; i < (int)m_runs.size(); i++)
+        {
+            if (m_runs[i].m_texture == texture)
+            {
+                m_lastRun = i;
+                break;
+            }
+        }
+        if (m_lastRun < 0)
+        {
+            m_lastRun = (int)m_runs.size();
+            m_runs.push_back({ texture, 0, 0 });
+        }
+    }
+    m_runs[m_lastRun].m_count++;
+    m_spriteRuns.push_back(m_lastRun);
+
+    float s = sinf(angle);
+    float c = cosf(angle);
+    uint8_t red = ToByte(r);
+    uint8_t green = ToByte(g);
+    uint8_t blue = ToByte(b);
+    for (int i = 0; i < 8; i += 2)
+    {
+        float px = points[i] * c - points[i + 1] * s;
+        float py = points[i] * s + points[i + 1] * c;
+        m_vertices.push_back({ x + px * scaleX, y + py * scaleY, uvs[i], uvs[i + 1], red, green, blue, 255 });
+    }
+}
+
+void CSpriteBatch::Flush()
+{
+    GLStateCache gl;
+    Flush(gl);
+}
+
+void CSpriteBatch::Flush(GLStateCache &gl)
+{
+    int spriteCount = (int)m_spriteRuns.size();
+    m_stats = sStats();
+    m_stats.m_sprites = spriteCount;
+    m_stats.m_textures = (int)m_runs.size();
+    if (spriteCount == 0)
+    {
+        return;
+    }
+
+    // Counting sort by texture: each run gets a contiguous range of the
+    // sorted array, sprites keep their relative order inside it
+    int first = 0;
+    for (sTextureRun &run : m_runs)
+    {
+        run.m_first = first;
+        first += run.m_count;
+    }
+    m_sorted.resize(m_vertices.size());
+    m_fill.resize(m_runs.size());
+    for (int i = 0; i < (int)m_runs.size(); i++)
+    {
+        m_fill[i] = m_runs[i].m_first;
+    }
+    for (int i = 0; i < spriteCount; i++)
+    {
+        int slot = m_fill[m_spriteRuns[i]]++;
+        std::copy(&m_vertices[i * 4], &m_vertices[i * 4] + 4, &m_sorted[slot * 4]);
+    }
+
+    gl.Enable(GL_BLEND);
+    gl.BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    gl.Enable(GL_TEXTURE_2D);
+
+    const sVertex *data = m_sorted.data();
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(2, GL_FLOAT, sizeof(sVertex), &data->m_x);
+    glTexCoordPointer(2, GL_FLOAT, sizeof(sVertex), &data->m_u);
+    glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(sVertex), &data->m_r);
+
+    for (const sTextureRun &run : m_runs)
+    {
+        glBindTexture(GL_TEXTURE_2D, run.m_texture);
+        glDrawArrays(GL_QUADS, run.m_first * 4, run.m_count * 4);
+        m_stats.m_drawCalls++;
+    }
+
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    // The colour array leaves the current colour undefined
+    gl.InvalidateColor();
+    gl.Disable(GL_BLEND);
+    gl.Disable(GL_TEXTURE_2D);
+}
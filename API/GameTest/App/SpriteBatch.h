@@ -0,0 +1,70 @@
+//-----------------------------------------------------------------------------
+// SpriteBatch.h
+// Collects a frame's sprites and draws them with one vertex array draw per texture.
+//-----------------------------------------------------------------------------
+#ifndef _SPRITEBATCH_H_
+#define _SPRITEBATCH_H_
+
+#include "../glut/include/GL/freeglut.h"
+#include <vector>
+#include <cstdint>
+
+class GLStateCache;
+
+//-----------------------------------------------------------------------------
+// CSpriteBatch
+// Sprites are transformed on the CPU when added. Flush groups them by texture,
+// keeping the order they were added within each texture, and draws each group
+// with a single glDrawArrays. Sprites using different textures can therefore
+// overlap in a different order than they were added; pack sprites that must
+// layer correctly into one atlas (see CSpriteAtlas).
+//-----------------------------------------------------------------------------
+class CSpriteBatch
+{
+public:
+    struct sStats
+    {
+        int m_sprites = 0;
+        int m_textures = 0;
+        int m_drawCalls = 0;
+    };
+
+    void Begin();
+    // points are the corners around the sprite's centre, uvs their texture
+    // coords. The corners are scaled, rotated by angle (radians) and moved to
+    // x, y in the same order CSimpleSprite::Draw applies them.
+    void Add(GLuint texture, const float points[8], const float uvs[8], const float x, const float y,
+        const float scaleX, const float scaleY, const float angle, const float r, const float g, const float b);
+    void Flush();
+    // Sets blend and texture through gl, for code that also draws through
+    // the renderer's state cache. Flush() starts from unknown state.
+    void Flush(GLStateCache &gl);
+
+    // Counts for the last flushed frame
+    const sStats &GetStats() const { return m_stats; }
+
+private:
+    struct sVertex
+    {
+        float m_x, m_y;
+        float m_u, m_v;
+        uint8_t m_r, m_g, m_b, m_a;
+    };
+
+    struct sTextureRun
+    {
+        GLuint m_texture;
+        int m_first;        // First sprite of the run once sorted
+        int m_count;
+    };
+
+    std::vector<sVertex> m_vertices;        // Four per sprite, in the order added
+    std::vector<int> m_spriteRuns;          // Run of each sprite
+    std::vector<sTextureRun> m_runs;
+    std::vector<sVertex> m_sorted;
+    std::vector<int> m_fill;                // Next sorted slot of each run
+    int m_lastRun = -1;
+    sStats m_stats;
+};
+
+#endif
@@ -0,0 +1,534 @@
+///////////////////////////////////////////////////////////////////////////////
+// Filename: TextureContainer.cpp
+// Pre-mipmapped textures on disk, uploaded without decoding anything.
+///////////////////////////////////////////////////////////////////////////////
+//-----------------------------------------------------------------------------
+#include "stdafx.h"
+//-----------------------------------------------------------------------------
+#include <windows.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <algorithm>
+#include <vector>
+
+#include "TextureContainer.h"
+
+#include "../glut/include/GL/freeglut_ext.h"
+
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+typedef void (APIENTRY *CompressedTexImage2DProc)(GLenum target, GLint level, GLenum internalFormat,
+    GLsizei width, GLsizei height, GLint border, GLsizei imageSize, const void *data);
+
+static const char CONTAINER_MAGIC[4] = { 'S', 'T', 'E', 'X' };
+static const char CONTAINER_EXTENSION[] = ".stex";
+
+//-----------------------------------------------------------------------------
+// S3TC blocks. Each covers 4x4 pixels, edge blocks repeat the last row and
+// column. The encoder fits the colour endpoints to the block's bounding box,
+// which is quick and good enough for sprites.
+//-----------------------------------------------------------------------------
+static uint16_t Pack565(const unsigned char *rgb)
+{
+    return (uint16_t)(((rgb[0] >> 3) << 11) | ((rgb[1] >> 2) << 5) | (rgb[2] >> 3));
+}
+
+static void Unpack565(const uint16_t color, unsigned char *rgb)
+{
+    int r = (color >> 11) & 31, g = (color >> 5) & 63, b = color & 31;
+    rgb[0] = (unsigned char)((r << 3) | (r >> 2));
+    rgb[1] = (unsigned char)((g << 2) | (g >> 4));
+    rgb[2] = (unsigned char)((b << 3) | (b >> 2));
+}
+
+static void FetchBlock(const unsigned char *pixels, const int width, const int height, const int blockX, const int blockY,
+    unsigned char block[16][4])
+{
+    for (int y = 0; y < 4; y++)
+    {
+        int sourceY = std::min(blockY * 4 + y, height - 1);
+        for (int x = 0; x < 4; x++)
+        {
+            int sourceX = std::min(blockX * 4 + x, width - 1);
+            memcpy(block[y * 4 + x], &pixels[(sourceY * width + sourceX) * 4], 4);
+        }
+    }
+}
+
+// Four colour blocks need color0 > color1; three colour ones, where index 3
+// is transparent, need color0 <= color1
+static void ColorPalette(const uint16_t color0, const uint16_t color1, const bool fourColors, unsigned char palette[4][4])
+{
+    Unpack565(color0, palette[0]);
+    Unpack565(color1, palette[1]);
+    for (int c = 0; c < 3; c++)
+    {
+        if (fourColors)
+        {
+            palette[2][c] = (unsigned char)((2 * palette[0][c] + palette[1][c]) / 3);
+            palette[3][c] = (unsigned char)((palette[0][c] + 2 * palette[1][c]) / 3);
+        }
+        else
+        {
+            palette[2][c] = (unsigned char)((palette[0][c] + palette[1][c]) / 2);
+            palette[3][c] = 0;
+        }
+    }
+    palette[0][3] = palette[1][3] = palette[2][3] = 255;
+    palette[3][3] = fourColors ? 255 : 0;
+}
+
+static void EncodeColorBlock(const unsigned char block[16][4], const bool punchThrough, unsigned char *out)
+{
+    bool transparent = false;
+    unsigned char low[3] = { 255, 255, 255 }, high[3] = { 0, 0, 0 };
+    for (int i = 0; i < 16; i++)
+    {
+        if (punchThrough && block[i][3] < 128)
+        {
+            transparent = true;
+            continue;
+        }
+        for (int c = 0; c < 3; c++)
+        {
+            low[c] = std::min(low[c], block[i][c]);
+            high[c] = std::max(high[c], block[i][c]);
+        }
+    }
+
+    uint16_t color0 = Pack565(high), color1 = Pack565(low);
+    if (low[0] > high[0])
+    {
+        color0 = color1 = 0;        // Nothing opaque
+    }
+    if (transparent ? color0 > color1 : color0 < color1)
+    {
+        std::swap(color0, color1);
+    }
+    bool fourColors = color0 > color1;
+    unsigned char palette[4][4];
+    ColorPalette(color0, color1, fourColors, palette);
+
+    uint32_t indices = 0;
+    for (int i = 0; i < 16; i++)
+    {
+        int best = 0;
+        if (transparent && block[i][3] < 128)
+        {
+            best = 3;
+        }
+        else if (color0 != color1)
+        {
+            int bestDistance = INT_MAX;
+            for (int p = 0; p < (fourColors ? 4 : 3); p++)
+            {
+                int dr = block[i][0] - palette[p][0], dg = block[i][1] - palette[p][1], db = block[i][2] - palette[p][2];
+                int distance = dr * dr + dg * dg + db * db;
+                if (distance < bestDistance)
+                {
+                    bestDistance = distance;
+                    best = p;
+                }
+            }
+        }
+        indices |= (uint32_t)best << (i * 2);
+    }
+
+    out[0] = (unsigned char)color0;
+    out[1] = (unsigned char)(color0 >> 8);
+    out[2] = (unsigned char)color1;
+    out[3] = (unsigned char)(color1 >> 8);
+    for (int b = 0; b < 4; b++)
+    {
+        out[4 + b] = (unsigned char)(indices >> (b * 8));
+    }
+}
+
+static void DecodeColorBlock(const unsigned char *in, const bool alwaysFourColors, unsigned char block[16][4])
+{
+    uint16_t color0 = (uint16_t)(in[0] | (in[1] << 8));
+    uint16_t color1 = (uint16_t)(in[2] | (in[3] << 8));
+    uint32_t indices = in[4] | (in[5] << 8) | (in[6] << 16) | ((uint32_t)in[7] << 24);
+    unsigned char palette[4][4];
+    ColorPalette(color0, color1, alwaysFourColors || color0 > color1, palette);
+    for (int i = 0; i < 16; i++)
+    {
+        memcpy(block[i], palette[(indices >> (i * 2)) & 3], 4);
+    }
+}
+
+// Eight alpha mode: alpha0 > alpha1 with six steps between them
+static void AlphaPalette(const unsigned char alpha0, const unsigned char alpha1, unsigned char palette[8])
+{
+    palette[0] = alpha0;
+    palette[1] = alpha1;
+    for (int i = 1; i < 7; i++)
+    {
+        palette[i + 1] = alpha0 > alpha1 ? (unsigned char)(((7 - i) * alpha0 + i * alpha1) / 7) : alpha0;
+    }
+}
+
+static void EncodeAlphaBlock(const unsigned char block[16][4], unsigned char *out)
+{
+    unsigned char alpha0 = 0, alpha1 = 255;
+    for (int i = 0; i < 16; i++)
+    {
+        alpha0 = std::max(alpha0, block[i][3]);
+        alpha1 = std::min(alpha1, block[i][3]);
+    }
+    unsigned char palette[8];
+    AlphaPalette(alpha0, alpha1, palette);
+
+    uint64_t indices = 0;
+    for (int i = 0; i < 16 && alpha0 != alpha1; i++)
+    {
+        int best = 0, bestDistance = INT_MAX;
+        for (int p = 0; p < 8; p++)
+        {
+            int distance = abs(block[i][3] - palette[p]);
+            if (distance < bestDistance)
+            {
+                bestDistance = distance;
+                best = p;
+            }
+        }
+        indices |= (uint64_t)best << (i * 3);
+    }
+
+    out[0] = alpha0;
+    out[1] = alpha1;
+    for (int b = 0; b < 6; b++)
+    {
+        out[2 + b] = (unsigned char)(indices >> (b * 8));
+    }
+}
+
+static void DecodeAlphaBlock(const unsigned char *in, unsigned char block[16][4])
+{
+    unsigned char palette[8];
+    if (in[0] > in[1])
+    {
+        AlphaPalette(in[0], in[1], palette);
+    }
+    else
+    {
+        // Six alpha mode, which this encoder doesn't write
+        palette[0] = in[0];
+        palette[1] = in[1];
+        for (int i = 1; i < 5; i++)
+        {
+            palette[i + 1] = (unsigned char)(((5 - i) * in[0] + i * in[1]) / 5);
+        }
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+    uint64_t indices = 0;
+    for (int b = 0; b < 6; b++)
+    {
+        indices |= (uint64_t)in[2 + b] << (b * 8);
+    }
+    for (int i = 0; i < 16; i++)
+    {
+        block[i][3] = palette[(indices >> (i * 3)) & 7];
+    }
+}
+
+static size_t GetBlockBytes(const CTextureContainer::eFormat format)
+{
+    return format == CTextureContainer::FORMAT_BC1 ? 8 : 16;
+}
+
+static size_t GetLevelSize(const CTextureContainer::eFormat format, const int width, const int height)
+{
+    if (format == CTextureContainer::FORMAT_RGBA8)
+    {
+        return (size_t)width * height * 4;
+    }
+    return (size_t)((width + 3) / 4) * ((height + 3) / 4) * GetBlockBytes(format);
+}
+
+static void EncodeLevel(const CTextureContainer::eFormat format, const unsigned char *pixels, const int width, const int height,
+    unsigned char *out)
+{
+    unsigned char block[16][4];
+    size_t blockBytes = GetBlockBytes(format);
+    for (int blockY = 0; blockY < (height + 3) / 4; blockY++)
+    {
+        for (int blockX = 0; blockX < (width + 3) / 4; blockX++)
+        {
+            FetchBlock(pixels, width, height, blockX, blockY, block);
+            if (format == CTextureContainer::FORMAT_BC3)
+            {
+                EncodeAlphaBlock(block, out);
+                EncodeColorBlock(block, false, out + 8);
+            }
+            else
+            {
+                EncodeColorBlock(block, true, out);
+            }
+            out += blockBytes;
+        }
+    }
+}
+
+static void DecodeLevel(const CTextureContainer::eFormat format, const unsigned char *in, const int width, const int height,
+    unsigned char *pixels)
+{
+    unsigned char block[16][4];
+    size_t blockBytes = GetBlockBytes(format);
+    for (int blockY = 0; blockY < (height + 3) / 4; blockY++)
+    {
+        for (int blockX = 0; blockX < (width + 3) / 4; blockX++)
+        {
+            if (format == CTextureContainer::FORMAT_BC3)
+            {
+                DecodeColorBlock(in + 8, true, block);
+                DecodeAlphaBlock(in, block);
+            }
+            else
+            {
+                DecodeColorBlock(in, false, block);
+            }
+            in += blockBytes;
+
+            for (int y = 0; y < 4 && blockY * 4 + y < height; y++)
+            {
+                for (int x = 0; x < 4 && blockX * 4 + x < width; x++)
+                {
+                    memcpy(&pixels[((blockY * 4 + y) * width + blockX * 4 + x) * 4], block[y * 4 + x], 4);
+                }
+            }
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+CTextureContainer::CTextureContainer()
+    : m_file(INVALID_HANDLE_VALUE)
+    , m_mapping(nullptr)
+    , m_view(nullptr)
+    , m_header(nullptr)
+    , m_levels(nullptr)
+{
+}
+
+CTextureContainer::~CTextureContainer()
+{
+    Close();
+}
+
+bool CTextureContainer::Open(const char *fileName)
+{
+    Close();
+
+    m_file = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (m_file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(m_file, &size) || size.QuadPart < (long long)sizeof(sHeader))
+    {
+        Close();
+        return false;
+    }
+
+    m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (m_mapping)
+    {
+        m_view = static_cast<const unsigned char *>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+    }
+    if (!m_view)
+    {
+        Close();
+        return false;
+    }
+
+    // Check every level lies inside the file before anything reads them
+    uint64_t viewSize = (uint64_t)size.QuadPart;
+    m_header = reinterpret_cast<const sHeader *>(m_view);
+    m_levels = reinterpret_cast<const sLevel *>(m_view + sizeof(sHeader));
+    bool valid = memcmp(m_header->m_magic, CONTAINER_MAGIC, 4) == 0 && m_header->m_version == VERSION &&
+        m_header->m_format <= FORMAT_BC3 && m_header->m_levelCount > 0 && m_header->m_levelCount <= 32 &&
+        sizeof(sHeader) + m_header->m_levelCount * sizeof(sLevel) <= viewSize;
+    for (uint32_t i = 0; valid && i < m_header->m_levelCount; i++)
+    {
+        const sLevel &level = m_levels[i];
+        valid = level.m_size == GetLevelSize(GetFormat(), level.m_width, level.m_height) &&
+            level.m_offset <= viewSize && level.m_size <= viewSize - level.m_offset;
+    }
+    if (!valid)
+    {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void CTextureContainer::Close()
+{
+    if (m_view)
+    {
+        UnmapViewOfFile(m_view);
+        m_view = nullptr;
+    }
+    if (m_mapping)
+    {
+        CloseHandle(m_mapping);
+        m_mapping = nullptr;
+    }
+    if (m_file != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(m_file);
+        m_file = INVALID_HANDLE_VALUE;
+    }
+    m_header = nullptr;
+    m_levels = nullptr;
+}
+
+size_t CTextureContainer::GetDataSize() const
+{
+    size_t total = 0;
+    for (int i = 0; i < GetLevelCount(); i++)
+    {
+        total += (size_t)m_levels[i].m_size;
+    }
+    return total;
+}
+
+bool CTextureContainer::IsCompressionSupported()
+{
+    static int supported = -1;
+    if (supported < 0)
+    {
+        const char *extensions = (const char *)glGetString(GL_EXTENSIONS);
+        supported = extensions && strstr(extensions, "GL_EXT_texture_compression_s3tc") &&
+            glutGetProcAddress("glCompressedTexImage2DARB") ? 1 : 0;
+    }
+    return supported == 1;
+}
+
+bool CTextureContainer::Upload() const
+{
+    if (!IsOpen())
+    {
+        return false;
+    }
+
+    eFormat format = GetFormat();
+    CompressedTexImage2DProc compressedTexImage2D = nullptr;
+    if (format != FORMAT_RGBA8 && IsCompressionSupported())
+    {
+        compressedTexImage2D = (CompressedTexImage2DProc)glutGetProcAddress("glCompressedTexImage2DARB");
+    }
+
+    std::vector<unsigned char> unpacked;
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (int i = 0; i < GetLevelCount(); i++)
+    {
+        const sLevel &level = m_levels[i];
+        const unsigned char *data = GetLevelData(i);
+        if (format == FORMAT_RGBA8)
+        {
+            glTexImage2D(GL_TEXTURE_2D, i, GL_RGBA, level.m_width, level.m_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+        }
+        else if (compressedTexImage2D)
+        {
+            GLenum internalFormat = format == FORMAT_BC1 ? GL_COMPRESSED_RGBA_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+            compressedTexImage2D(GL_TEXTURE_2D, i, internalFormat, level.m_width, level.m_height, 0, (GLsizei)level.m_size, data);
+        }
+        else
+        {
+            unpacked.resize((size_t)level.m_width * level.m_height * 4);
+            DecodeLevel(format, data, level.m_width, level.m_height, unpacked.data());
+            glTexImage2D(GL_TEXTURE_2D, i, GL_RGBA, level.m_width, level.m_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, unpacked.data());
+        }
+    }
+    return true;
+}
+
+bool CTextureContainer::Write(const char *fileName, const CTextureLoader::sDecodedImage &image, const eFormat format)
+{
+    if (!image.m_ok || image.m_levels.empty())
+    {
+        return false;
+    }
+
+    sHeader header;
+    memcpy(header.m_magic, CONTAINER_MAGIC, 4);
+    header.m_version = VERSION;
+    header.m_format = format;
+    header.m_width = image.m_width;
+    header.m_height = image.m_height;
+    header.m_levelCount = (uint32_t)image.m_levels.size();
+
+    std::vector<sLevel> levels;
+    std::vector<unsigned char> data;
+    uint64_t offset = sizeof(sHeader) + image.m_levels.size() * sizeof(sLevel);
+    for (const CTextureLoader::sMipLevel &mip : image.m_levels)
+    {
+        sLevel level = { (uint32_t)mip.m_width, (uint32_t)mip.m_height, offset + data.size(),
+            GetLevelSize(format, mip.m_width, mip.m_height) };
+        size_t start = data.size();
+        data.resize(start + (size_t)level.m_size);
+        const unsigned char *pixels = &image.m_pixels[mip.m_offset];
+        if (format == FORMAT_RGBA8)
+        {
+            memcpy(&data[start], pixels, (size_t)level.m_size);
+        }
+        else
+        {
+            EncodeLevel(format, pixels, mip.m_width, mip.m_height, &data[start]);
+        }
+        levels.push_back(level);
+    }
+
+    FILE *out = nullptr;
+    if (fopen_s(&out, fileName, "wb") != 0 || !out)
+    {
+        return false;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, out) == 1 &&
+        fwrite(levels.data(), sizeof(sLevel), levels.size(), out) == levels.size() &&
+        fwrite(data.data(), 1, data.size(), out) == data.size();
+    fclose(out);
+    return ok;
+}
+
+bool CTextureContainer::Convert(const char *sourceFile, const char *targetFile, const eFormat format)
+{
+    CTextureLoader::sDecodedImage image;
+    return CTextureLoader::Decode(sourceFile, image) && Write(targetFile, image, format);
+}
+
+std::string CTextureContainer::GetContainerName(const std::string &sourceFile)
+{
+    size_t dot = sourceFile.find_last_of('.');
+    size_t slash = sourceFile.find_last_of("\\/");
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+    {
+        return sourceFile + CONTAINER_EXTENSION;
+    }
+    return sourceFile.substr(0, dot) + CONTAINER_EXTENSION;
+}
+
+bool CTextureContainer::IsUpToDate(const std::string &containerFile, const std::string &sourceFile)
+{
+    WIN32_FILE_ATTRIBUTE_DATA container, source;
+    if (!GetFileAttributesExA(containerFile.c_str(), GetFileExInfoStandard, &container))
+    {
+        return false;
+    }
+    if (!GetFileAttributesExA(sourceFile.c_str(), GetFileExInfoStandard, &source))
+    {
+        return true;
+    }
+    return CompareFileTime(&container.ftLastWriteTime, &source.ftLastWriteTime) >= 0;
+}
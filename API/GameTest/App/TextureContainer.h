@@ -0,0 +1,97 @@
+//-----------------------------------------------------------------------------
+// TextureContainer.h
+// Pre-mipmapped textures on disk, uploaded without decoding anything.
+//-----------------------------------------------------------------------------
+#ifndef _TEXTURECONTAINER_H_
+#define _TEXTURECONTAINER_H_
+
+#include <windows.h>
+#include "../glut/include/GL/freeglut.h"
+#include <string>
+#include <stdint.h>
+
+#include "TextureLoader.h"
+
+//-----------------------------------------------------------------------------
+// CTextureContainer
+// A .stex file holds a whole mip chain, as RGBA or as S3TC blocks, behind a
+// small header. Open maps the file read only and Upload hands each level to
+// GL straight from the view. Compressed levels go up as they are when the
+// driver has S3TC, otherwise they're unpacked to RGBA first.
+// Layout:
+//   sHeader
+//   sLevel per mip level, largest first
+//   Level data, each level's pixels or blocks in rows
+// Write bakes one from a decoded image; Convert does a source file.
+//-----------------------------------------------------------------------------
+class CTextureContainer
+{
+public:
+    enum eFormat
+    {
+        FORMAT_RGBA8 = 0,
+        FORMAT_BC1 = 1,         // DXT1, 4 bits a pixel, alpha on or off
+        FORMAT_BC3 = 2,         // DXT5, 8 bits a pixel, smooth alpha
+    };
+
+    struct sHeader
+    {
+        char m_magic[4];        // "STEX"
+        uint32_t m_version;
+        uint32_t m_format;
+        uint32_t m_width;       // Of the source image
+        uint32_t m_height;
+        uint32_t m_levelCount;
+    };
+
+    struct sLevel
+    {
+        uint32_t m_width;
+        uint32_t m_height;
+        uint64_t m_offset;
+        uint64_t m_size;
+    };
+
+    static const uint32_t VERSION = 1;
+
+    CTextureContainer();
+    ~CTextureContainer();
+
+    bool Open(const char *fileName);
+    void Close();
+    bool IsOpen() const { return m_view != nullptr; }
+
+    eFormat GetFormat() const { return (eFormat)m_header->m_format; }
+    int GetWidth() const { return (int)m_header->m_width; }
+    int GetHeight() const { return (int)m_header->m_height; }
+    int GetLevelCount() const { return (int)m_header->m_levelCount; }
+    const sLevel &GetLevel(const int level) const { return m_levels[level]; }
+    const unsigned char *GetLevelData(const int level) const { return m_view + m_levels[level].m_offset; }
+    // Bytes of every level, what the texture takes once uploaded
+    size_t GetDataSize() const;
+
+    // Uploads the mip chain into the bound texture. Returns false if it's closed.
+    bool Upload() const;
+
+    static bool Write(const char *fileName, const CTextureLoader::sDecodedImage &image, const eFormat format);
+    static bool Convert(const char *sourceFile, const char *targetFile, const eFormat format);
+    // Name the baked file for a source image takes, its extension swapped for .stex
+    static std::string GetContainerName(const std::string &sourceFile);
+    // False if the container is missing or older than its source, so edits
+    // to an image show up without rebaking. A missing source is fine.
+    static bool IsUpToDate(const std::string &containerFile, const std::string &sourceFile);
+    // True when the driver takes S3TC blocks directly
+    static bool IsCompressionSupported();
+
+private:
+    CTextureContainer(const CTextureContainer &) = delete;
+    CTextureContainer &operator=(const CTextureContainer &) = delete;
+
+    HANDLE m_file;
+    HANDLE m_mapping;
+    const unsigned char *m_view;
+    const sHeader *m_header;
+    const sLevel *m_levels;
+};
+
+#endif
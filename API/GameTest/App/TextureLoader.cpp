@@ -0,0 +1,369 @@
+///////////////////////////////////////////////////////////////////////////////
+// Filename: TextureLoader.cpp
+// Decodes textures on worker threads and uploads them on the GL thread.
+///////////////////////////////////////////////////////////////////////////////
+//-----------------------------------------------------------------------------
+#include "stdafx.h"
+//-----------------------------------------------------------------------------
+#include <windows.h>
+#include <algorithm>
+#include <chrono>
+
+#include "TextureLoader.h"
+
+#include "../stb_image/stb_image.h"
+
+// Shown until the real image arrives
+static const unsigned char PLACEHOLDER_PIXEL[4] = { 128, 128, 128, 255 };
+
+CTextureLoader &CTextureLoader::GetInstance()
+{
+    static CTextureLoader instance;
+    return instance;
+}
+
+CTextureLoader::CTextureLoader()
+{
+}
+
+CTextureLoader::~CTextureLoader()
+{
+    Shutdown();
+}
+
+void CTextureLoader::Initialize(const int threadCount)
+{
+    if (!m_workers.empty())
+    {
+        return;
+    }
+    m_quit = false;
+    for (int i = 0; i < std::max(1, threadCount); i++)
+    {
+        m_workers.emplace_back(&CTextureLoader::WorkerLoop, this);
+    }
+}
+
+// Finishes what's queued so nothing is left half decoded
+void CTextureLoader::Shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+    }
+    m_requestAvailable.notify_all();
+    for (std::thread &worker : m_workers)
+    {
+        worker.join();
+    }
+    m_workers.clear();
+}
+
+void CTextureLoader::WorkerLoop()
+{
+    for (;;)
+    {
+        sRequest request;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_requestAvailable.wait(lock, [this] { return m_quit || !m_requests.empty(); });
+            if (m_requests.empty())
+            {
+                return;
+            }
+            request = std::move(m_requests.front());
+            m_requests.pop_front();
+            if (request.m_texture)
+            {
+                m_decoding.push_back(request.m_request);
+            }
+        }
+
+        sDecodedImage image;
+        image.m_request = request.m_request;
+        image.m_texture = request.m_texture;
+        Decode(request.m_fileName, image);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (image.m_ok)
+        {
+            m_stats.m_decoded++;
+        }
+        else
+        {
+            m_stats.m_failed++;
+        }
+        if (image.m_texture)
+        {
+            // Cancelled while decoding, the texture may already be gone
+            m_decoding.erase(std::find(m_decoding.begin(), m_decoding.end(), image.m_request));
+            auto cancelled = std::find(m_cancelled.begin(), m_cancelled.end(), image.m_request);
+            if (cancelled != m_cancelled.end())
+            {
+                m_cancelled.erase(cancelled);
+            }
+            else
+            {
+                m_uploads.push_back(std::move(image));
+            }
+        }
+        else
+        {
+            m_decoded.push_back(std::move(image));
+        }
+        if (--m_inFlight == 0)
+        {
+            m_decodesDone.notify_all();
+        }
+    }
+}
+
+// Bilinear resize of RGBA pixels, only used to get GL 1.1 power of two sizes
+static void Resize(const unsigned char *source, int sourceWidth, int sourceHeight,
+    unsigned char *target, int targetWidth, int targetHeight)
+{
+    for (int y = 0; y < targetHeight; y++)
+    {
+        float sy = std::max(0.0f, (y + 0.5f) * sourceHeight / targetHeight - 0.5f);
+        int y0 = std::min((int)sy, sourceHeight - 1);
+        int y1 = std::min(y0 + 1, sourceHeight - 1);
+        float fy = sy - y0;
+        for (int x = 0; x < targetWidth; x++)
+        {
+            float sx = std::max(0.0f, (x + 0.5f) * sourceWidth / targetWidth - 0.5f);
+            int x0 = std::min((int)sx, sourceWidth - 1);
+            int x1 = std::min(x0 + 1, sourceWidth - 1);
+            float fx = sx - x0;
+            for (int c = 0; c < 4; c++)
+            {
+                float top = source[(y0 * sourceWidth + x0) * 4 + c] * (1.0f - fx) + source[(y0 * sourceWidth + x1) * 4 + c] * fx;
+                float bottom = source[(y1 * sourceWidth + x0) * 4 + c] * (1.0f - fx) + source[(y1 * sourceWidth + x1) * 4 + c] * fx;
+                target[(y * targetWidth + x) * 4 + c] = (unsigned char)(top * (1.0f - fy) + bottom * fy + 0.5f);
+            }
+        }
+    }
+}
+
+// Nearest power of two, like gluBuild2DMipmaps picks
+static int NearestPowerOfTwo(int size)
+{
+    int power = 1;
+    while (power * 2 <= size)
+    {
+        power *= 2;
+    }
+    return (size - power > power * 2 - size) ? power * 2 : power;
+}
+
+size_t CTextureLoader::GetMipChainBytes(int width, int height)
+{
+    size_t total = 0;
+    for (int w = NearestPowerOfTwo(width), h = NearestPowerOfTwo(height); ; w = std::max(1, w / 2), h = std::max(1, h / 2))
+    {
+        total += (size_t)w * h * 4;
+        if (w == 1 && h == 1)
+        {
+            return total;
+        }
+    }
+}
+
+bool CTextureLoader::Decode(const std::string &fileName, sDecodedImage &image)
+{
+    auto start = std::chrono::steady_clock::now();
+    image.m_fileName = fileName;
+    image.m_ok = false;
+
+    int channels;
+    unsigned char *pixels = stbi_load(fileName.c_str(), &image.m_width, &image.m_height, &channels, 4);
+    if (!pixels)
+    {
+        return false;
+    }
+
+    // Size the whole chain up front, each level a quarter of the last
+    int width = NearestPowerOfTwo(image.m_width);
+    int height = NearestPowerOfTwo(image.m_height);
+    size_t total = 0;
+    image.m_levels.clear();
+    for (int w = width, h = height; ; w = std::max(1, w / 2), h = std::max(1, h / 2))
+    {
+        image.m_levels.push_back({ w, h, total });
+        total += (size_t)w * h * 4;
+        if (w == 1 && h == 1)
+        {
+            break;
+        }
+    }
+    image.m_pixels.resize(total);
+
+    if (width == image.m_width && height == image.m_height)
+    {
+        std::copy(pixels, pixels + (size_t)width * height * 4, image.m_pixels.begin());
+    }
+    else
+    {
+        Resize(pixels, image.m_width, image.m_height, image.m_pixels.data(), width, height);
+    }
+    stbi_image_free(pixels);
+
+    // Box filter each level from the one above it
+    for (size_t level = 1; level < image.m_levels.size(); level++)
+    {
+        const sMipLevel &above = image.m_levels[level - 1];
+        const sMipLevel &current = image.m_levels[level];
+        const unsigned char *source = &image.m_pixels[above.m_offset];
+        unsigned char *target = &image.m_pixels[current.m_offset];
+        for (int y = 0; y < current.m_height; y++)
+        {
+            int y0 = std::min(y * 2, above.m_height - 1);
+            int y1 = std::min(y * 2 + 1, above.m_height - 1);
+            for (int x = 0; x < current.m_width; x++)
+            {
+                int x0 = std::min(x * 2, above.m_width - 1);
+                int x1 = std::min(x * 2 + 1, above.m_width - 1);
+                for (int c = 0; c < 4; c++)
+                {
+                    int sum = source[(y0 * above.m_width + x0) * 4 + c] + source[(y0 * above.m_width + x1) * 4 + c] +
+                        source[(y1 * above.m_width + x0) * 4 + c] + source[(y1 * above.m_width + x1) * 4 + c];
+                    target[(y * current.m_width + x) * 4 + c] = (unsigned char)((sum + 2) / 4);
+                }
+            }
+        }
+    }
+
+    image.m_ok = true;
+    image.m_decodeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+GLuint CTextureLoader::Load(const std::string &fileName, int &width, int &height, uint64_t &request)
+{
+    int channels;
+    if (!stbi_info(fileName.c_str(), &width, &height, &channels))
+    {
+        return 0;
+    }
+
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, PLACEHOLDER_PIXEL);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        request = m_nextRequest++;
+        m_requests.push_back({ fileName, request, texture });
+        m_inFlight++;
+        m_stats.m_queued++;
+    }
+    m_requestAvailable.notify_one();
+    return texture;
+}
+
+void CTextureLoader::QueueDecode(const std::string &fileName)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_requests.push_back({ fileName, m_nextRequest++, 0 });
+        m_inFlight++;
+        m_stats.m_queued++;
+    }
+    m_requestAvailable.notify_one();
+}
+
+void CTextureLoader::WaitForDecodes()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_decodesDone.wait(lock, [this] { return m_inFlight == 0; });
+}
+
+void CTextureLoader::TakeDecoded(std::vector<sDecodedImage> &images)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (sDecodedImage &image : m_decoded)
+    {
+        images.push_back(std::move(image));
+    }
+    m_decoded.clear();
+}
+
+int CTextureLoader::Update(const size_t byteBudget)
+{
+    int uploaded = 0;
+    size_t bytes = 0;
+    while (bytes < byteBudget)
+    {
+        sDecodedImage image;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_uploads.empty())
+            {
+                break;
+            }
+            image = std::move(m_uploads.front());
+            m_uploads.pop_front();
+        }
+        // Failed images keep their placeholder
+        if (!image.m_ok)
+        {
+            continue;
+        }
+
+        glBindTexture(GL_TEXTURE_2D, image.m_texture);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        for (size_t level = 0; level < image.m_levels.size(); level++)
+        {
+            const sMipLevel &mip = image.m_levels[level];
+            glTexImage2D(GL_TEXTURE_2D, (GLint)level, GL_RGBA, mip.m_width, mip.m_height, 0,
+                GL_RGBA, GL_UNSIGNED_BYTE, &image.m_pixels[mip.m_offset]);
+        }
+        bytes += image.m_pixels.size();
+        uploaded++;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.m_uploaded++;
+        m_stats.m_uploadedBytes += image.m_pixels.size();
+    }
+    return uploaded;
+}
+
+void CTextureLoader::Cancel(const uint64_t request)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto it = m_requests.begin(); it != m_requests.end(); ++it)
+    {
+        if (it->m_request == request)
+        {
+            m_requests.erase(it);
+            if (--m_inFlight == 0)
+            {
+                m_decodesDone.notify_all();
+            }
+            return;
+        }
+    }
+    for (auto it = m_uploads.begin(); it != m_uploads.end(); ++it)
+    {
+        if (it->m_request == request)
+        {
+            m_uploads.erase(it);
+            return;
+        }
+    }
+    if (std::find(m_decoding.begin(), m_decoding.end(), request) != m_decoding.end())
+    {
+        m_cancelled.push_back(request);
+    }
+}
+
+CTextureLoader::sStats CTextureLoader::GetStats()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
@@ -0,0 +1,123 @@
+//-----------------------------------------------------------------------------
+// TextureLoader.h
+// Decodes textures on worker threads and uploads them on the GL thread.
+//-----------------------------------------------------------------------------
+#ifndef _TEXTURELOADER_H_
+#define _TEXTURELOADER_H_
+
+#include "../glut/include/GL/freeglut.h"
+#include <vector>
+#include <deque>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <stdint.h>
+
+//-----------------------------------------------------------------------------
+// CTextureLoader
+// Load reads only the image header, creates the texture with a one pixel
+// placeholder and returns straight away. A worker thread decodes the file and
+// builds the whole mip chain on the CPU, then Update, called once a frame on
+// the GL thread, uploads finished chains into the textures Load returned. A
+// sprite made from the texture shows the placeholder until then.
+// The decode half works without GL, for tools and the texture benchmark.
+//-----------------------------------------------------------------------------
+class CTextureLoader
+{
+public:
+    struct sMipLevel
+    {
+        int m_width, m_height;
+        size_t m_offset;            // Into m_pixels
+    };
+
+    // RGBA mip chain, level 0 resized to powers of two for GL 1.1
+    struct sDecodedImage
+    {
+        std::string m_fileName;
+        uint64_t m_request = 0;
+        GLuint m_texture = 0;       // 0 for decode only requests
+        bool m_ok = false;
+        int m_width = 0;            // Size of the file's image
+        int m_height = 0;
+        std::vector<sMipLevel> m_levels;
+        std::vector<unsigned char> m_pixels;
+        double m_decodeMs = 0.0;
+    };
+
+    struct sStats
+    {
+        int m_queued = 0;
+        int m_decoded = 0;
+        int m_uploaded = 0;
+        int m_failed = 0;
+        size_t m_uploadedBytes = 0;
+    };
+
+    static CTextureLoader &GetInstance();
+    CTextureLoader();
+    ~CTextureLoader();
+
+    void Initialize(const int threadCount = DEFAULT_THREADS);
+    void Shutdown();
+    bool IsRunning() const { return !m_workers.empty(); }
+
+    // GL thread. Returns the texture, holding a placeholder for now, the
+    // image's size from its header and the id of the request filling it, or
+    // 0 if the file isn't a readable image.
+    GLuint Load(const std::string &fileName, int &width, int &height, uint64_t &request);
+    // GL thread, once a frame. Uploads finished images until byteBudget bytes
+    // have gone this call, the rest wait for the next. Returns how many.
+    int Update(const size_t byteBudget = DEFAULT_UPLOAD_BUDGET);
+    // GL thread. Drops the pending upload of a request from Load, call it
+    // before deleting a texture that may not have arrived yet. Requests are
+    // numbered rather than found by texture, as GL hands a deleted texture's
+    // name out again.
+    void Cancel(const uint64_t request);
+
+    // Decode without a texture; results wait for TakeDecoded
+    void QueueDecode(const std::string &fileName);
+    // Blocks until every queued decode has finished
+    void WaitForDecodes();
+    void TakeDecoded(std::vector<sDecodedImage> &images);
+
+    // Decodes and builds the mip chain on the calling thread
+    static bool Decode(const std::string &fileName, sDecodedImage &image);
+    // Size of the mip chain Decode builds for an image
+    static size_t GetMipChainBytes(int width, int height);
+
+    sStats GetStats();
+
+private:
+    static const int DEFAULT_THREADS = 2;
+    static const size_t DEFAULT_UPLOAD_BUDGET = 4 * 1024 * 1024;
+
+    struct sRequest
+    {
+        std::string m_fileName;
+        uint64_t m_request;
+        GLuint m_texture;
+    };
+
+    CTextureLoader(const CTextureLoader &) = delete;
+    CTextureLoader &operator=(const CTextureLoader &) = delete;
+
+    void WorkerLoop();
+
+    std::vector<std::thread> m_workers;
+    std::deque<sRequest> m_requests;
+    std::deque<sDecodedImage> m_uploads;        // Waiting for Update
+    std::deque<sDecodedImage> m_decoded;        // Decode only, waiting for TakeDecoded
+    std::vector<uint64_t> m_decoding;           // Texture requests a worker has now
+    std::vector<uint64_t> m_cancelled;          // Of those, ones to drop when done
+    uint64_t m_nextRequest = 1;
+    int m_inFlight = 0;                         // Queued or decoding
+    sStats m_stats;
+    std::mutex m_mutex;
+    std::condition_variable m_requestAvailable;
+    std::condition_variable m_decodesDone;
+    bool m_quit = false;
+};
+
+#endif
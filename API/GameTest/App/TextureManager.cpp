@@ -0,0 +1,450 @@
+///////////////////////////////////////////////////////////////////////////////
+// Filename: TextureManager.cpp
+// Shares sprite textures by file name and frees the ones nothing uses.
+///////////////////////////////////////////////////////////////////////////////
+//-----------------------------------------------------------------------------
+#include "stdafx.h"
+//-----------------------------------------------------------------------------
+#include <windows.h>
+#include <algorithm>
+
+#include "TextureManager.h"
+#include "TextureLoader.h"
+#include "TextureContainer.h"
+
+#include "../stb_image/stb_image.h"
+
+// 64 bit FNV-1a
+static uint64_t HashName(const std::string &name)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (char c : name)
+    {
+        hash ^= (unsigned char)c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+//-----------------------------------------------------------------------------
+CTextureHandle::CTextureHandle(int id)
+    : m_id(id)
+{
+    CTextureManager::GetInstance().AddRef(m_id);
+}
+
+CTextureHandle::CTextureHandle(const CTextureHandle &other)
+    : m_id(other.m_id)
+{
+    if (m_id >= 0)
+    {
+        CTextureManager::GetInstance().AddRef(m_id);
+    }
+}
+
+CTextureHandle &CTextureHandle::operator=(const CTextureHandle &other)
+{
+    if (other.m_id >= 0)
+    {
+        CTextureManager::GetInstance().AddRef(other.m_id);
+    }
+    Reset();
+    m_id = other.m_id;
+    return *this;
+}
+
+CTextureHandle &CTextureHandle::operator=(CTextureHandle &&other)
+{
+    if (this != &other)
+    {
+        Reset();
+        m_id = other.m_id;
+        other.m_id = -1;
+    }
+    return *this;
+}
+
+void CTextureHandle::Reset()
+{
+    if (m_id >= 0)
+    {
+        CTextureManager::GetInstance().Release(m_id);
+        m_id = -1;
+    }
+}
+
+//-----------------------------------------------------------------------------
+CTextureManager &CTextureManager::GetInstance()
+{
+    static CTextureManager instance;
+    return instance;
+}
+
+CTextureManager::CTextureManager()
+{
+}
+
+// The GL context is gone by now, so textures are left to it
+CTextureManager::~CTextureManager()
+{
+}
+
+int CTextureManager::Intern(const std::string &fileName)
+{
+    uint64_t hash = HashName(fileName);
+    auto found = m_hashes.find(hash);
+    if (found != m_hashes.end())
+    {
+        int id = found->second;
+        for (;;)
+        {
+            if (m_entries[id].m_name == fileName)
+            {
+                return id;
+            }
+            if (m_entries[id].m_nextSameHash < 0)
+            {
+                break;
+            }
+            id = m_entries[id].m_nextSameHash;
+        }
+        m_entries[id].m_nextSameHash = (int)m_entries.size();
+    }
+    else
+    {
+        m_hashes[hash] = (int)m_entries.size();
+    }
+    m_entries.push_back(sEntry());
+    m_entries.back().m_name = fileName;
+    return (int)m_entries.size() - 1;
+}
+
+CTextureHandle CTextureManager::Acquire(const std::string &fileName)
+{
+    int id = Intern(fileName);
+    sEntry &entry = m_entries[id];
+    if (entry.m_resident)
+    {
+        m_hits++;
+        return CTextureHandle(id);
+    }
+
+    m_misses++;
+    if (!Load(entry))
+    {
+        return CTextureHandle();
+    }
+    entry.m_resident = true;
+    entry.m_owned = true;
+    m_resident++;
+    m_residentBytes += entry.m_bytes;
+    CTextureHandle handle(id);
+    EvictToBudget();
+    return handle;
+}
+
+bool CTextureManager::Load(sEntry &entry)
+{
+    int width, height;
+    GLuint texture = 0;
+    entry.m_loadRequest = 0;
+
+    // A container baked beside the source is already mipmapped, so it goes
+    // straight from the mapped file to GL. One older than the source is
+    // stale and skipped.
+    CTextureContainer container;
+    std::string containerName = CTextureContainer::GetContainerName(entry.m_name);
+    if (CTextureContainer::IsUpToDate(containerName, entry.m_name) && container.Open(containerName.c_str()))
+    {
+        width = container.GetWidth();
+        height = container.GetHeight();
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);
+        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        container.Upload();
+
+        sTexture textureDef = { texture, (unsigned int)width, (unsigned int)height, 0.0f, 0.0f, 1.0f, 1.0f };
+        entry.m_texture = textureDef;
+        bool compressed = container.GetFormat() != CTextureContainer::FORMAT_RGBA8 && CTextureContainer::IsCompressionSupported();
+        entry.m_bytes = compressed ? container.GetDataSize() : CTextureLoader::GetMipChainBytes(width, height);
+        return true;
+    }
+
+    // With the loader running the texture starts as a placeholder and the
+    // decode and mipmapping happen off the GL thread
+    CTextureLoader &loader = CTextureLoader::GetInstance();
+    if (loader.IsRunning())
+    {
+        texture = loader.Load(entry.m_name, width, height, entry.m_loadRequest);
+        if (!texture)
+        {
+            return false;
+        }
+    }
+    else
+    {
+        int channels;
+        unsigned char *imageData = stbi_load(entry.m_name.c_str(), &width, &height, &channels, 4);
+        if (!imageData)
+        {
+            return false;
+        }
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);
+
+        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        gluBuild2DMipmaps(GL_TEXTURE_2D, 4, width, height, GL_RGBA, GL_UNSIGNED_BYTE, imageData);
+        stbi_image_free(imageData);
+    }
+
+    sTexture textureDef = { texture, (unsigned int)width, (unsigned int)height, 0.0f, 0.0f, 1.0f, 1.0f };
+    entry.m_texture = textureDef;
+    entry.m_bytes = CTextureLoader::GetMipChainBytes(width, height);
+    return true;
+}
+
+void CTextureManager::AddRegion(const std::string &fileName, GLuint texture, const unsigned int width, const unsigned int height,
+    const float u0, const float v0, const float u1, const float v1)
+{
+    int id = Intern(fileName);
+    sEntry &entry = m_entries[id];
+    if (entry.m_resident && entry.m_refs == 0)
+    {
+        Evict(id);
+    }
+    else if (entry.m_resident)
+    {
+        // Sprites made from the old texture still draw it. A loaded one is
+        // deleted once they're gone, a region's texture is its owner's.
+        if (entry.m_owned)
+        {
+            m_retired.push_back({ entry.m_texture.m_textureID, entry.m_loadRequest, entry.m_bytes, { id } });
+            m_retiredBytes += entry.m_bytes;
+        }
+        m_resident--;
+        m_residentBytes -= entry.m_bytes;
+    }
+
+    sTexture region = { texture, width, height, u0, v0, u1, v1 };
+    entry.m_texture = region;
+    entry.m_bytes = 0;
+    entry.m_loadRequest = 0;
+    entry.m_resident = true;
+    entry.m_owned = false;
+    m_resident++;
+    if (entry.m_refs == 0)
+    {
+        LinkLru(id);
+    }
+}
+
+void CTextureManager::RetireTexture(GLuint texture, const size_t bytes)
+{
+    sRetired retired = { texture, 0, bytes, {} };
+    for (int id = 0; id < (int)m_entries.size(); id++)
+    {
+        sEntry &entry = m_entries[id];
+        if (!entry.m_resident || entry.m_owned || entry.m_texture.m_textureID != texture)
+        {
+            continue;
+        }
+        if (entry.m_refs == 0)
+        {
+            Evict(id);
+        }
+        else
+        {
+            retired.m_waiting.push_back(id);
+        }
+    }
+
+    if (retired.m_waiting.empty())
+    {
+        DeleteTexture(texture, 0);
+        return;
+    }
+    m_retiredBytes += bytes;
+    m_retired.push_back(std::move(retired));
+}
+
+void CTextureManager::AddRef(int id)
+{
+    sEntry &entry = m_entries[id];
+    if (entry.m_refs++ == 0)
+    {
+        m_referenced++;
+        UnlinkLru(id);
+    }
+}
+
+void CTextureManager::Release(int id)
+{
+    sEntry &entry = m_entries[id];
+    if (--entry.m_refs == 0)
+    {
+        m_referenced--;
+        LinkLru(id);
+        if (!m_retired.empty())
+        {
+            ReleaseRetired(id);
+        }
+        EvictToBudget();
+    }
+}
+
+void CTextureManager::Evict(int id)
+{
+    sEntry &entry = m_entries[id];
+    UnlinkLru(id);
+    if (entry.m_owned)
+    {
+        DeleteTexture(entry.m_texture.m_textureID, entry.m_loadRequest);
+        m_evictions++;
+    }
+    m_resident--;
+    m_residentBytes -= entry.m_bytes;
+    entry.m_texture = sTexture();
+    entry.m_bytes = 0;
+    entry.m_loadRequest = 0;
+    entry.m_resident = false;
+    entry.m_owned = false;
+}
+
+// An upload still on its way would land in whatever gets the name next
+void CTextureManager::DeleteTexture(GLuint texture, const uint64_t loadRequest)
+{
+    if (loadRequest)
+    {
+        CTextureLoader::GetInstance().Cancel(loadRequest);
+    }
+    glDeleteTextures(1, &texture);
+}
+
+// Entry id has just lost its last handle. A region pointing into a retired
+// texture is evicted right away, so the name can't be handed out again and
+// all handles into the texture are the ones being waited on. Retired
+// textures it was the last wait for are deleted.
+void CTextureManager::ReleaseRetired(int id)
+{
+    for (size_t i = 0; i < m_retired.size();)
+    {
+        sRetired &retired = m_retired[i];
+        retired.m_waiting.erase(std::remove(retired.m_waiting.begin(), retired.m_waiting.end(), id), retired.m_waiting.end());
+        const sEntry &entry = m_entries[id];
+        if (entry.m_resident && !entry.m_owned && entry.m_texture.m_textureID == retired.m_textureID)
+        {
+            Evict(id);
+        }
+        if (!retired.m_waiting.empty())
+        {
+            i++;
+            continue;
+        }
+
+        DeleteTexture(retired.m_textureID, retired.m_loadRequest);
+        m_retiredBytes -= retired.m_bytes;
+        m_retired.erase(m_retired.begin() + i);
+    }
+}
+
+// Regions cost nothing, so only owned textures are worth evicting
+void CTextureManager::EvictToBudget()
+{
+    int id = m_lruHead;
+    while (id >= 0 && m_residentBytes > m_budgetBytes)
+    {
+        int next = m_entries[id].m_lruNext;
+        if (m_entries[id].m_owned)
+        {
+            Evict(id);
+        }
+        id = next;
+    }
+}
+
+void CTextureManager::SetBudget(const size_t bytes)
+{
+    m_budgetBytes = bytes;
+    EvictToBudget();
+}
+
+void CTextureManager::Trim()
+{
+    int id = m_lruHead;
+    while (id >= 0)
+    {
+        int next = m_entries[id].m_lruNext;
+        if (m_entries[id].m_owned)
+        {
+            Evict(id);
+        }
+        id = next;
+    }
+}
+
+void CTextureManager::LinkLru(int id)
+{
+    sEntry &entry = m_entries[id];
+    entry.m_lruPrev = m_lruTail;
+    entry.m_lruNext = -1;
+    if (m_lruTail >= 0)
+    {
+        m_entries[m_lruTail].m_lruNext = id;
+    }
+    else
+    {
+        m_lruHead = id;
+    }
+    m_lruTail = id;
+}
+
+void CTextureManager::UnlinkLru(int id)
+{
+    sEntry &entry = m_entries[id];
+    if (entry.m_lruPrev >= 0)
+    {
+        m_entries[entry.m_lruPrev].m_lruNext = entry.m_lruNext;
+    }
+    else if (m_lruHead == id)
+    {
+        m_lruHead = entry.m_lruNext;
+    }
+    else
+    {
+        return;     // Not linked
+    }
+    if (entry.m_lruNext >= 0)
+    {
+        m_entries[entry.m_lruNext].m_lruPrev = entry.m_lruPrev;
+    }
+    else
+    {
+        m_lruTail = entry.m_lruPrev;
+    }
+    entry.m_lruPrev = -1;
+    entry.m_lruNext = -1;
+}
+
+CTextureManager::sStats CTextureManager::GetStats() const
+{
+    sStats stats;
+    stats.m_names = (int)m_entries.size();
+    stats.m_resident = m_resident;
+    stats.m_referenced = m_referenced;
+    stats.m_residentBytes = m_residentBytes;
+    stats.m_budgetBytes = m_budgetBytes;
+    stats.m_hits = m_hits;
+    stats.m_misses = m_misses;
+    stats.m_evictions = m_evictions;
+    stats.m_retired = (int)m_retired.size();
+    stats.m_retiredBytes = m_retiredBytes;
+    return stats;
+}
@@ -0,0 +1,164 @@
+//-----------------------------------------------------------------------------
+// TextureManager.h
+// Shares sprite textures by file name and frees the ones nothing uses.
+//-----------------------------------------------------------------------------
+#ifndef _TEXTUREMANAGER_H_
+#define _TEXTUREMANAGER_H_
+
+#include "../glut/include/GL/freeglut.h"
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <stdint.h>
+
+//-----------------------------------------------------------------------------
+// CTextureHandle
+// Counted reference to a texture in the manager. It stays loaded while any
+// handle to it exists. Copy and destroy these on the GL thread only.
+//-----------------------------------------------------------------------------
+class CTextureHandle
+{
+public:
+    CTextureHandle() : m_id(-1) {}
+    CTextureHandle(const CTextureHandle &other);
+    CTextureHandle(CTextureHandle &&other) : m_id(other.m_id) { other.m_id = -1; }
+    ~CTextureHandle() { Reset(); }
+    CTextureHandle &operator=(const CTextureHandle &other);
+    CTextureHandle &operator=(CTextureHandle &&other);
+
+    bool IsValid() const { return m_id >= 0; }
+    // Interned file name, the same for every handle to the file; -1 if invalid
+    int GetId() const { return m_id; }
+    void Reset();
+
+private:
+    friend class CTextureManager;
+    explicit CTextureHandle(int id);        // Takes a new reference
+
+    int m_id;
+};
+
+//-----------------------------------------------------------------------------
+// CTextureManager
+// File names are interned once into ids, so a lookup hashes the name and
+// compares it against the few names with that hash rather than walking a
+// map of strings. A texture whose last handle goes away stays loaded in case
+// it's wanted again, until the loaded textures exceed the memory budget.
+// Then the least recently released ones are deleted first. Textures still
+// referenced are never deleted, so the budget can be overrun by them.
+//-----------------------------------------------------------------------------
+class CTextureManager
+{
+public:
+    struct sTexture
+    {
+        GLuint m_textureID;
+        unsigned int m_width;
+        unsigned int m_height;
+        float m_u0, m_v0, m_u1, m_v1;   // Part of the texture the image occupies
+    };
+
+    struct sStats
+    {
+        int m_names = 0;                // Interned file names
+        int m_resident = 0;             // Textures loaded
+        int m_referenced = 0;           // Of those, ones with handles
+        size_t m_residentBytes = 0;     // Estimated, mip chains included
+        size_t m_budgetBytes = 0;
+        int m_hits = 0;
+        int m_misses = 0;
+        int m_evictions = 0;
+        int m_retired = 0;              // Replaced textures sprites may still draw
+        size_t m_retiredBytes = 0;
+    };
+
+    static CTextureManager &GetInstance();
+    ~CTextureManager();
+
+    // Loads the file unless it's resident. Returns an invalid handle if it
+    // can't be read. A .stex container baked beside the file is used instead
+    // when there is one no older than the file, otherwise textures go through
+    // CTextureLoader while it's running.
+    CTextureHandle Acquire(const std::string &fileName);
+    // Valid until the handle is released
+    const sTexture &Get(const CTextureHandle &handle) const { return m_entries[handle.m_id].m_texture; }
+
+    // Makes fileName refer to part of a texture owned elsewhere, like a sheet
+    // packed into a CSpriteAtlas. Regions cost nothing against the budget.
+    // Sprites keep the texture they were made with, so a loaded texture the
+    // region replaces is retired rather than deleted while it has handles.
+    void AddRegion(const std::string &fileName, GLuint texture, const unsigned int width, const unsigned int height,
+        const float u0, const float v0, const float u1, const float v1);
+    // Takes over a texture whose owner is done with it, like a rebuilt
+    // CSpriteAtlas, and deletes it once no handle to a region in it is left.
+    // Regions still in it with no handles are forgotten straight away.
+    void RetireTexture(GLuint texture, const size_t bytes);
+
+    void SetBudget(const size_t bytes);
+    size_t GetBudget() const { return m_budgetBytes; }
+    // Deletes every texture without a handle
+    void Trim();
+
+    sStats GetStats() const;
+
+private:
+    static const size_t DEFAULT_BUDGET = 256 * 1024 * 1024;
+
+    struct sEntry
+    {
+        std::string m_name;
+        int m_nextSameHash = -1;        // Chain of names sharing a hash
+        sTexture m_texture = {};
+        size_t m_bytes = 0;
+        int m_refs = 0;
+        bool m_resident = false;
+        bool m_owned = false;           // False for regions
+        int m_lruPrev = -1;             // Release order of unreferenced textures
+        int m_lruNext = -1;
+        uint64_t m_loadRequest = 0;     // CTextureLoader request filling the texture
+    };
+
+    // A texture that was replaced while handles to its entries existed.
+    // Those handles' sprites may still draw it, so it's deleted when each
+    // entry in m_waiting has been released by all of them.
+    struct sRetired
+    {
+        GLuint m_textureID;
+        uint64_t m_loadRequest;
+        size_t m_bytes;
+        std::vector<int> m_waiting;
+    };
+
+    friend class CTextureHandle;
+
+    CTextureManager();
+    CTextureManager(const CTextureManager &) = delete;
+    CTextureManager &operator=(const CTextureManager &) = delete;
+
+    int Intern(const std::string &fileName);
+    bool Load(sEntry &entry);
+    void AddRef(int id);
+    void Release(int id);
+    void Evict(int id);
+    void EvictToBudget();
+    void LinkLru(int id);
+    void UnlinkLru(int id);
+    void DeleteTexture(GLuint texture, const uint64_t loadRequest);
+    void ReleaseRetired(int id);
+
+    std::vector<sEntry> m_entries;                  // Indexed by interned id
+    std::unordered_map<uint64_t, int> m_hashes;     // First id with each hash
+    std::vector<sRetired> m_retired;
+    int m_lruHead = -1;                             // Least recently released
+    int m_lruTail = -1;
+    size_t m_budgetBytes = DEFAULT_BUDGET;
+    size_t m_residentBytes = 0;
+    int m_resident = 0;
+    int m_referenced = 0;
+    int m_hits = 0;
+    int m_misses = 0;
+    int m_evictions = 0;
+    size_t m_retiredBytes = 0;
+};
+
+#endif
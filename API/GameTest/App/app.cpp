@@ -11,6 +11,7 @@
 #include "SimpleSound.h"
 #include "SimpleController.h"
 #include "SimpleSprite.h"
+#include <Viewport.h>
 
 //---------------------------------------------------------------------------------
 // Utils and externals for system info.
@@ -51,11 +52,13 @@ namespace App
 		ScreenToClient(MAIN_WINDOW_HANDLE, &mousePos);
 		x = (float)mousePos.x;
 		y = (float)mousePos.y;
-		x = (x * (2.0f / WINDOW_WIDTH) - 1.0f);
-		y = -(y * (2.0f / WINDOW_HEIGHT) - 1.0f);
 
 #if APP_USE_VIRTUAL_RES		
-		APP_NATIVE_TO_VIRTUAL_COORDS(x, y);
+		// Through the letterbox, so the cursor lines up with what's drawn
+		Viewport::GetInstance().WindowToVirtual(x, y, x, y);
+#else
+		x = (x * (2.0f / WINDOW_WIDTH) - 1.0f);
+		y = -(y * (2.0f / WINDOW_HEIGHT) - 1.0f);
 #endif
 	}
 
@@ -97,4 +100,16 @@ namespace App
 	{
 		return CSimpleControllers::GetInstance().GetController(pad);
 	}
+
+	static int exitCode = 0;
+
+	void SetExitCode(const int code)
+	{
+		exitCode = code;
+	}
+
+	int GetExitCode()
+	{
+		return exitCode;
+	}
 }
\ No newline at end of file
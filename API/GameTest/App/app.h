@@ -108,5 +108,17 @@ namespace App
 	// See SimpleController.h for more info.
 	//-------------------------------------------------------------------------------------------
 	const CController &GetController(const int pad = 0 );
+
+	//*******************************************************************************************
+	// Process handling.
+	//*******************************************************************************************
+	//-------------------------------------------------------------------------------------------
+	// void SetExitCode(int code);
+	//-------------------------------------------------------------------------------------------
+	// Sets the value the program returns once the main loop ends, 0 unless set. Headless checks
+	// use it to report a failure.
+	//-------------------------------------------------------------------------------------------
+	void SetExitCode(const int code);
+	int GetExitCode();
 };
 #endif //_APP_H
\ No newline at end of file
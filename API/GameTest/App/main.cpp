@@ -14,6 +14,9 @@
 #include "app.h"
 #include "SimpleSound.h"
 #include "SimpleController.h"
+#include "TextureLoader.h"
+#include <AllocationTracker.h>
+#include <Viewport.h>
 
 //---------------------------------------------------------------------------------
 // Initial setup globals.
@@ -134,18 +137,13 @@ void Idle()
 		gUpdateDeltaTime.Stop();
 		glutPostRedisplay(); //every time you are done
 		CSimpleControllers::GetInstance().Update();
+		CTextureLoader::GetInstance().Update();	// Upload textures decoded since last frame
 
 		gUserUpdateProfiler.Start();
 		Update((float)deltaTime);				// Call user defined update.
 		gUserUpdateProfiler.Stop();
 		
 		gLastTime = currentTime;		
-		RECT tileClientArea;
-		if (GetClientRect( MAIN_WINDOW_HANDLE, &tileClientArea))
-		{
-			WINDOW_WIDTH = tileClientArea.right - tileClientArea.left;
-			WINDOW_HEIGHT = tileClientArea.bottom - tileClientArea.top;
-		}
 
 		if (App::GetController().CheckButton(APP_ENABLE_DEBUG_INFO_BUTTON) )
 		{
@@ -160,9 +158,23 @@ void Idle()
 	}
 }
 
+//---------------------------------------------------------------------------------
+// Handler for window-resize events. The viewport service keeps the size and
+// letterbox so nothing has to ask the window for them per frame.
+//---------------------------------------------------------------------------------
+void Reshape(int width, int height)
+{
+	WINDOW_WIDTH = width;
+	WINDOW_HEIGHT = height;
+	Viewport::GetInstance().Resize(width, height);
+	Viewport::GetInstance().Apply();
+}
+
 // Break here and use the diagnostics debug view to check for user mem leaks.
+// Headless runs get the allocation report, live bytes in it are leaks.
 void CheckMemCallback()
 {
+	AllocationTracker::WriteConfiguredReport();
 }
 
 //---------------------------------------------------------------------------------
@@ -182,6 +194,7 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance, 	_In_opt_ HINSTANCE hPrevInstanc
 	MAIN_WINDOW_HANDLE = WindowFromDC(dc);
 	glutIdleFunc(Idle);
 	glutDisplayFunc(Display);       // Register callback handler for window re-paint event	
+	glutReshapeFunc(Reshape);       // Register callback handler for window resize event
 	glutSetOption(GLUT_ACTION_ON_WINDOW_CLOSE, GLUT_ACTION_CONTINUE_EXECUTION);
 	InitGL();                       // Our own OpenGL initialization
 
@@ -189,6 +202,9 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance, 	_In_opt_ HINSTANCE hPrevInstanc
 
 	// Init sounds system.
 	CSimpleSound::GetInstance().Initialize();
+
+	// Decode sprite textures in the background.
+	CTextureLoader::GetInstance().Initialize();
 	
 	// Call user defined init.
 	Init();
@@ -199,11 +215,14 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance, 	_In_opt_ HINSTANCE hPrevInstanc
 	// Call user shutdown.
 	Shutdown();	
 
+	// Stop texture decoding.
+	CTextureLoader::GetInstance().Shutdown();
+
 	// Shutdown sound system.
 	CSimpleSound::GetInstance().Shutdown();
 
 	// And we are done.
-	return 0;
+	return App::GetExitCode();
 }
 
 
@@ -50,73 +50,32 @@ void Bullet::Update(float deltaTime, float spaceshipX, float spaceshipY) {
     }
 }
 
-void Bullet::Render(bool spaceship) {
+void Bullet::BuildVertices(RenderList& lines, bool spaceship) const {
     if (!active) return;
 
-    glPushMatrix();
-    glPushAttrib(GL_ALL_ATTRIB_BITS);
+    // White for the spaceship, red for the rings
+    float r = 1.0f;
+    float g = spaceship ? 1.0f : 0.0f;
+    float b = spaceship ? 1.0f : 0.0f;
 
-    glTranslatef(x, y, z);
+    // Draw bullet as small wireframe cubes
+    float s = spaceship ? BULLET_SIZE : BULLET_RING_SIZE;
 
-    if (spaceship)
-        glColor3f(1.0f, 1.0f, 1.0f);  // White color
-    else
-        glColor3f(1.0f, 0.0f, 0.0f);  // Red color
-
-    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-    glDisable(GL_LIGHTING);
-
-    // Draw bullet as small cubes
-    float bulletSize = spaceship ? BULLET_SIZE : BULLET_RING_SIZE;
-
-    // Front face
-    glBegin(GL_LINE_LOOP);
-    glVertex3f(-bulletSize, -bulletSize, bulletSize);
-    glVertex3f(bulletSize, -bulletSize, bulletSize);
-    glVertex3f(bulletSize, bulletSize, bulletSize);
-    glVertex3f(-bulletSize, bulletSize, bulletSize);
-    glEnd();
-
-    // Back face
-    glBegin(GL_LINE_LOOP);
-    glVertex3f(-bulletSize, -bulletSize, -bulletSize);
-    glVertex3f(-bulletSize, bulletSize, -bulletSize);
-    glVertex3f(bulletSize, bulletSize, -bulletSize);
-    glVertex3f(bulletSize, -bulletSize, -bulletSize);
-    glEnd();
-
-    // Top face
-    glBegin(GL_LINE_LOOP);
-    glVertex3f(-bulletSize, bulletSize, -bulletSize);
-    glVertex3f(-bulletSize, bulletSize, bulletSize);
-    glVertex3f(bulletSize, bulletSize, bulletSize);
-    glVertex3f(bulletSize, bulletSize, -bulletSize);
-    glEnd();
-
-    // Bottom face
-    glBegin(GL_LINE_LOOP);
-    glVertex3f(-bulletSize, -bulletSize, -bulletSize);
-    glVertex3f(bulletSize, -bulletSize, -bulletSize);
-    glVertex3f(bulletSize, -bulletSize, bulletSize);
-    glVertex3f(-bulletSize, -bulletSize, bulletSize);
-    glEnd();
-
-    // Right face
-    glBegin(GL_LINE_LOOP);
-    glVertex3f(bulletSize, -bulletSize, -bulletSize);
-    glVertex3f(bulletSize, bulletSize, -bulletSize);
-    glVertex3f(bulletSize, bulletSize, bulletSize);
-    glVertex3f(bulletSize, -bulletSize, bulletSize);
-    glEnd();
-
-    // Left face
-    glBegin(GL_LINE_LOOP);
-    glVertex3f(-bulletSize, -bulletSize, -bulletSize);
-    glVertex3f(-bulletSize, -bulletSize, bulletSize);
-    glVertex3f(-bulletSize, bulletSize, bulletSize);
-    glVertex3f(-bulletSize, bulletSize, -bulletSize);
-    glEnd();
+    float corners[8][3];
+    for (int i = 0; i < 8; i++) {
+        corners[i][0] = x + ((i & 1) ? s : -s);
+        corners[i][1] = y + ((i & 2) ? s : -s);
+        corners[i][2] = z + ((i & 4) ? s : -s);
+    }
 
-    glPopAttrib();
-    glPopMatrix();
+    static const int edges[12][2] = {
+        {0, 1}, {2, 3}, {4, 5}, {6, 7},  // Along X
+        {0, 2}, {1, 3}, {4, 6}, {5, 7},  // Along Y
+        {0, 4}, {1, 5}, {2, 6}, {3, 7}   // Along Z
+    };
+    for (const auto& edge : edges) {
+        const float* p0 = corners[edge[0]];
+        const float* p1 = corners[edge[1]];
+        lines.AddLine(p0[0], p0[1], p0[2], p1[0], p1[1], p1[2], r, g, b);
+    }
 }
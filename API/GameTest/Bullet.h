@@ -2,13 +2,15 @@
 #ifndef BULLET_H
 #define BULLET_H
 
+#include "RenderList.h"
+
 class Bullet {
 public:
     static const int DAMAGE = 1;  // Each bullet damage
 
     Bullet(float startX, float startY, float angle, bool isSpaceshipBullet = true);
     void Update(float deltaTime, float spaceshipX, float spaceshipY);
-    void Render(bool spaceship);
+    void BuildVertices(RenderList& lines, bool spaceship) const;
     bool IsActive() const { return active; }
     bool CheckSpaceshipCollision(float shipX, float shipY, float collisionRadius = 4.0f) const;
     bool CheckRingCollision(float ringX, float ringY, float collisionRadius = 3.0f) const;
@@ -27,7 +29,10 @@ private:
     uint64_t fireTime;
 
     static constexpr float SPACESHIP_BULLET_SPEED = 50.0f;  // Speed for spaceship bullets
-    static constexpr float RING_BULLET_SPEED = 2.5f;      // Speed for ring bullets
+    // Ring bullets used to be stepped once per active ring at 2.5. A normal
+    // game starts with about 40 rings (10 planets of 2 to 6), so that is the
+    // speed they flew at and the range that covers Galaxy's influence radius.
+    static constexpr float RING_BULLET_SPEED = 100.0f;    // Speed for ring bullets
     static constexpr float BULLET_LIFETIME_MS = 1000.0f;  // For how much time bullet can travel
     static constexpr float BULLET_SIZE = 0.45f;      // Size of bullet
     static constexpr float BULLET_RING_SIZE = 0.9f;      // Size of bullet of the rings
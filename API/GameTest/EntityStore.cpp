@@ -0,0 +1,132 @@
+//------------------------------------------------------------------------
+// EntityStore.cpp
+//------------------------------------------------------------------------
+#include "stdafx.h"
+#include "EntityStore.h"
+
+Entity EntityStore::Create() {
+    entityCount++;
+    if (!freeEntities.empty()) {
+        Entity entity = freeEntities.back();
+        freeEntities.pop_back();
+        return entity;
+    }
+    return nextEntity++;
+}
+
+void EntityStore::Destroy(Entity entity) {
+    transforms.Remove(entity);
+    orbits.Remove(entity);
+    healths.Remove(entity);
+    weapons.Remove(entity);
+    renderables.Remove(entity);
+    planets.Remove(entity);
+
+    freeEntities.push_back(entity);
+    entityCount--;
+}
+
+void EntityStore::Clear() {
+    transforms.Clear();
+    orbits.Clear();
+    healths.Clear();
+    weapons.Clear();
+    renderables.Clear();
+    planets.Clear();
+
+    freeEntities.clear();
+    nextEntity = 0;
+    entityCount = 0;
+}
+
+// Moves the last element into the hole left by index
+template <typename T>
+static void SwapRemove(std::vector<T>& column, uint32_t index) {
+    column[index] = column.back();
+    column.pop_back();
+}
+
+void OrbitArray::Add(Entity entity, const Orbit& orbit, const Transform& center) {
+    if (entity >= sparse.size()) {
+        sparse.resize(entity + 1, INVALID_ENTITY);
+    }
+    if (sparse[entity] != INVALID_ENTITY) {
+        Remove(entity);
+    }
+    sparse[entity] = (uint32_t)entities.size();
+    entities.push_back(entity);
+
+    parent.push_back(orbit.parent);
+    centerX.push_back(center.x);
+    centerY.push_back(center.y);
+    centerZ.push_back(center.z);
+    radius.push_back(orbit.radius);
+    speed.push_back(orbit.speed);
+    selfSpeed.push_back(orbit.selfSpeed);
+    angle.push_back(orbit.angle);
+    selfAngle.push_back(orbit.selfAngle);
+    yawAngle.push_back(orbit.yawAngle);
+    x.push_back(center.x);
+    y.push_back(center.y);
+    z.push_back(center.z);
+}
+
+void OrbitArray::Remove(Entity entity) {
+    if (!Has(entity)) return;
+
+    uint32_t index = sparse[entity];
+    SwapRemove(entities, index);
+    SwapRemove(parent, index);
+    SwapRemove(centerX, index);
+    SwapRemove(centerY, index);
+    SwapRemove(centerZ, index);
+    SwapRemove(radius, index);
+    SwapRemove(speed, index);
+    SwapRemove(selfSpeed, index);
+    SwapRemove(angle, index);
+    SwapRemove(selfAngle, index);
+    SwapRemove(yawAngle, index);
+    SwapRemove(x, index);
+    SwapRemove(y, index);
+    SwapRemove(z, index);
+
+    if (index < entities.size()) {
+        sparse[entities[index]] = index;
+    }
+    sparse[entity] = INVALID_ENTITY;
+}
+
+void OrbitArray::Reserve(int count) {
+    entities.reserve(count);
+    parent.reserve(count);
+    centerX.reserve(count);
+    centerY.reserve(count);
+    centerZ.reserve(count);
+    radius.reserve(count);
+    speed.reserve(count);
+    selfSpeed.reserve(count);
+    angle.reserve(count);
+    selfAngle.reserve(count);
+    yawAngle.reserve(count);
+    x.reserve(count);
+    y.reserve(count);
+    z.reserve(count);
+}
+
+void OrbitArray::Clear() {
+    entities.clear();
+    sparse.clear();
+    parent.clear();
+    centerX.clear();
+    centerY.clear();
+    centerZ.clear();
+    radius.clear();
+    speed.clear();
+    selfSpeed.clear();
+    angle.clear();
+    selfAngle.clear();
+    yawAngle.clear();
+    x.clear();
+    y.clear();
+    z.clear();
+}
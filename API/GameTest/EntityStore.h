@@ -0,0 +1,184 @@
+//------------------------------------------------------------------------
+// EntityStore.h
+//------------------------------------------------------------------------
+#ifndef ENTITY_STORE_H
+#define ENTITY_STORE_H
+
+#include <vector>
+#include <cstdint>
+#include "RenderQueue.h"
+
+typedef uint32_t Entity;
+static const Entity INVALID_ENTITY = 0xFFFFFFFF;
+
+//------------------------------------------------------------------------
+// Components
+//------------------------------------------------------------------------
+struct Transform {
+    float x, y, z;
+};
+
+// Circular orbit around the parent's transform, plus the entity's own spin.
+// Stored in an OrbitArray, this is only used to add one.
+struct Orbit {
+    Entity parent;
+    float angle;          // Current orbit angle around the parent, degrees
+    float radius;
+    float speed;          // Orbit speed, degrees per second
+    float selfAngle;      // Rotation around itself
+    float selfSpeed;
+    float yawAngle;       // Horizontal rotation to face the target
+};
+
+struct Health {
+    int current;
+    int max;
+
+    bool IsAlive() const { return current > 0; }
+};
+
+struct Weapon {
+    float fireInterval;   // Seconds between shots
+    float cooldown;       // Seconds until the next shot, counts down while engaged
+};
+
+struct Renderable {
+    MeshId mesh;
+    float r, g, b;
+};
+
+// Planets become collectable once all their rings are destroyed
+struct PlanetInfo {
+    int activeRings;      // Maintained by Galaxy::DamageRing
+    bool collectable;
+    bool collected;
+};
+
+//------------------------------------------------------------------------
+// Dense component storage. Components sit in one contiguous array that
+// systems walk linearly; a sparse table maps entities to their slot.
+// Removing swaps the last component into the hole, so order isn't stable.
+//------------------------------------------------------------------------
+template <typename T>
+class ComponentArray {
+public:
+    T& Add(Entity entity, const T& component) {
+        if (entity >= sparse.size()) {
+            sparse.resize(entity + 1, INVALID_ENTITY);
+        }
+        if (sparse[entity] != INVALID_ENTITY) {
+            dense[sparse[entity]] = component;
+            return dense[sparse[entity]];
+        }
+        sparse[entity] = (uint32_t)dense.size();
+        dense.push_back(component);
+        entities.push_back(entity);
+        return dense.back();
+    }
+
+    void Remove(Entity entity) {
+        if (!Has(entity)) return;
+
+        uint32_t index = sparse[entity];
+        uint32_t last = (uint32_t)dense.size() - 1;
+        if (index != last) {
+            dense[index] = dense[last];
+            entities[index] = entities[last];
+            sparse[entities[index]] = index;
+        }
+        dense.pop_back();
+        entities.pop_back();
+        sparse[entity] = INVALID_ENTITY;
+    }
+
+    bool Has(Entity entity) const {
+        return entity < sparse.size() && sparse[entity] != INVALID_ENTITY;
+    }
+
+    T& Get(Entity entity) { return dense[sparse[entity]]; }
+    const T& Get(Entity entity) const { return dense[sparse[entity]]; }
+    T* TryGet(Entity entity) { return Has(entity) ? &dense[sparse[entity]] : nullptr; }
+    const T* TryGet(Entity entity) const { return Has(entity) ? &dense[sparse[entity]] : nullptr; }
+
+    // Linear access for systems
+    int Size() const { return (int)dense.size(); }
+    T& operator[](int index) { return dense[index]; }
+    const T& operator[](int index) const { return dense[index]; }
+    Entity EntityAt(int index) const { return entities[index]; }
+
+    void Reserve(int count) {
+        dense.reserve(count);
+        entities.reserve(count);
+    }
+
+    void Clear() {
+        dense.clear();
+        entities.clear();
+        sparse.clear();
+    }
+
+private:
+    std::vector<T> dense;
+    std::vector<Entity> entities;
+    std::vector<uint32_t> sparse;
+};
+
+//------------------------------------------------------------------------
+// Orbits are kept as a structure of arrays so OrbitKernel can update four
+// at a time. Same sparse set scheme as ComponentArray. The parent's
+// position is copied in when the orbit is added, planets don't move.
+//------------------------------------------------------------------------
+class OrbitArray {
+public:
+    void Add(Entity entity, const Orbit& orbit, const Transform& center);
+    void Remove(Entity entity);
+
+    bool Has(Entity entity) const {
+        return entity < sparse.size() && sparse[entity] != INVALID_ENTITY;
+    }
+    int IndexOf(Entity entity) const { return (int)sparse[entity]; }
+    int Size() const { return (int)entities.size(); }
+    Entity EntityAt(int index) const { return entities[index]; }
+
+    void Reserve(int count);
+    void Clear();
+
+    std::vector<Entity> parent;
+    std::vector<float> centerX, centerY, centerZ;
+    std::vector<float> radius;
+    std::vector<float> speed;          // Degrees per second
+    std::vector<float> selfSpeed;
+    std::vector<float> angle;          // Degrees
+    std::vector<float> selfAngle;
+    std::vector<float> yawAngle;
+
+    // World position from the last update
+    std::vector<float> x, y, z;
+
+private:
+    std::vector<Entity> entities;
+    std::vector<uint32_t> sparse;
+};
+
+class EntityStore {
+public:
+    Entity Create();
+    void Destroy(Entity entity);
+    void Clear();
+
+    int GetEntityCount() const { return entityCount; }
+
+    ComponentArray<Transform> transforms;
+    OrbitArray orbits;
+    ComponentArray<Health> healths;
+    ComponentArray<Weapon> weapons;
+    ComponentArray<Renderable> renderables;
+    ComponentArray<PlanetInfo> planets;
+
+private:
+    std::vector<Entity> freeEntities;
+    Entity nextEntity = 0;
+    int entityCount = 0;
+};
+
+#endif
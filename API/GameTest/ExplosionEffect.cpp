@@ -5,6 +5,7 @@
 
 ExplosionEffect::ExplosionEffect(float x, float y, float z) {
     // Create initial sticks
+    sticks.reserve(NUM_STICKS);
     for (int i = 0; i < NUM_STICKS; i++) {
         Stick stick;
         stick.x = x;
@@ -64,29 +65,23 @@ void ExplosionEffect::Update(float deltaTime) {
     }
 }
 
-void ExplosionEffect::Render(bool isSpaceship) {
-    glPushAttrib(GL_ALL_ATTRIB_BITS);
-    glDisable(GL_LIGHTING);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+void ExplosionEffect::BuildVertices(RenderList& lines, bool isSpaceship) const {
+    // Red, or purple for the spaceship, with fading alpha
+    float r = 1.0f;
+    float g = 0.0f;
+    float b = isSpaceship ? 1.0f : 0.0f;
 
     for (const auto& stick : sticks) {
-        glPushMatrix();
-        glTranslatef(stick.x, stick.y, stick.z);
-        glRotatef(stick.rx, 1, 0, 0);
-        glRotatef(stick.ry, 0, 1, 0);
-        glRotatef(stick.rz, 0, 0, 1);
-
-        // Draw stick as a line
-        glLineWidth(2.0f);
-        glBegin(GL_LINES);
-        glColor4f(1.0f, 0.0f, isSpaceship ? 1.0f : 0.0f, stick.alpha);  // Red color with fading alpha
-        glVertex3f(-stick.length / 2, 0, 0);
-        glVertex3f(stick.length / 2, 0, 0);
-        glEnd();
-
-        glPopMatrix();
+        Matrix34 transform = Matrix34::Identity();
+        transform.Translate(stick.x, stick.y, stick.z);
+        transform.Rotate(stick.rx, 1, 0, 0);
+        transform.Rotate(stick.ry, 0, 1, 0);
+        transform.Rotate(stick.rz, 0, 0, 1);
+
+        // Stick is a line along its local X axis
+        float x0, y0, z0, x1, y1, z1;
+        transform.Apply(-stick.length / 2, 0, 0, x0, y0, z0);
+        transform.Apply(stick.length / 2, 0, 0, x1, y1, z1);
+        lines.AddLine(x0, y0, z0, x1, y1, z1, r, g, b, stick.alpha);
     }
-
-    glPopAttrib();
-}
\ No newline at end of file
+}
@@ -4,6 +4,7 @@
 #include <vector>
 #include <windows.h>
 #include <GL/gl.h>
+#include "RenderList.h"
 
 struct Stick {
     float x, y, z;           // Position
@@ -19,7 +20,7 @@ class ExplosionEffect {
 public:
     ExplosionEffect(float x, float y, float z);
     void Update(float deltaTime);
-    void Render(bool isSpaceship = false);
+    void BuildVertices(RenderList& lines, bool isSpaceship = false) const;
     bool IsActive() const { return !sticks.empty(); }
 
 private:
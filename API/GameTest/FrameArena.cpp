@@ -0,0 +1,80 @@
+//------------------------------------------------------------------------
+// FrameArena.cpp
+//------------------------------------------------------------------------
+#include "stdafx.h"
+#include "FrameArena.h"
+#include <stdlib.h>
+#include <algorithm>
+
+FrameArena& FrameArena::GetInstance() {
+    static FrameArena instance;
+    return instance;
+}
+
+FrameArena::FrameArena() : buffer(nullptr), capacity(0), offset(0), overflowBytes(0) {
+}
+
+FrameArena::~FrameArena() {
+    Shutdown();
+}
+
+void FrameArena::Initialize(size_t initialCapacity) {
+    Shutdown();
+    buffer = static_cast<uint8_t*>(malloc(initialCapacity));
+    capacity = buffer ? initialCapacity : 0;
+    stats.capacity = capacity;
+}
+
+void FrameArena::Shutdown() {
+    Reset();
+    free(buffer);
+    buffer = nullptr;
+    capacity = 0;
+    stats = Stats();
+}
+
+void FrameArena::Reset() {
+    size_t used = std::min(offset.load(), capacity);
+    stats.used = used + overflowBytes;
+    stats.peak = std::max(stats.peak, stats.used);
+    stats.overflows = (int)overflowBlocks.size();
+
+    for (void* block : overflowBlocks) {
+        free(block);
+    }
+    overflowBlocks.clear();
+
+    // Grow so next frame fits without overflowing
+    if (overflowBytes > 0 && buffer) {
+        size_t newCapacity = std::max(capacity * 2, capacity + overflowBytes);
+        uint8_t* newBuffer = static_cast<uint8_t*>(malloc(newCapacity));
+        if (newBuffer) {
+            free(buffer);
+            buffer = newBuffer;
+            capacity = newCapacity;
+            stats.capacity = capacity;
+        }
+    }
+    overflowBytes = 0;
+    offset = 0;
+}
+
+void* FrameArena::Allocate(size_t size, size_t alignment) {
+    if (size == 0) size = 1;
+
+    // Reserve enough for the worst case alignment padding, then align inside it
+    size_t padded = size + alignment - 1;
+    size_t start = offset.fetch_add(padded);
+    if (buffer && start + padded <= capacity) {
+        uintptr_t address = (uintptr_t)(buffer + start);
+        address = (address + alignment - 1) & ~(uintptr_t)(alignment - 1);
+        return (void*)address;
+    }
+
+    std::lock_guard<std::mutex> lock(overflowMutex);
+    void* block = malloc(padded);
+    overflowBlocks.push_back(block);
+    overflowBytes += padded;
+    uintptr_t address = ((uintptr_t)block + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    return (void*)address;
+}
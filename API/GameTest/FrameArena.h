@@ -0,0 +1,80 @@
+//------------------------------------------------------------------------
+// FrameArena.h
+//------------------------------------------------------------------------
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+
+#include <vector>
+#include <string>
+#include <atomic>
+#include <mutex>
+#include <cstddef>
+#include <cstdint>
+
+// Bump allocator for data that only lives until the end of the frame.
+// Allocation is lock free so job system slices can use it too. Everything
+// is released at once by Reset(), nothing allocated from it may be kept
+// past that point.
+class FrameArena {
+public:
+    static FrameArena& GetInstance();
+
+    void Initialize(size_t capacity = 1024 * 1024);
+    void Shutdown();
+
+    // Call once per frame when no frame data is alive anymore
+    void Reset();
+
+    void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+    struct Stats {
+        size_t capacity = 0;
+        size_t used = 0;          // Bytes used last frame
+        size_t peak = 0;
+        int overflows = 0;        // Allocations last frame that didn't fit and went to the heap
+    };
+    const Stats& GetStats() const { return stats; }
+
+private:
+    FrameArena();
+    ~FrameArena();
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    uint8_t* buffer;
+    size_t capacity;
+    std::atomic<size_t> offset;
+
+    // Oversized or overflowing allocations, freed on Reset
+    std::mutex overflowMutex;
+    std::vector<void*> overflowBlocks;
+    size_t overflowBytes;
+
+    Stats stats;
+};
+
+// Standard allocator over the frame arena, deallocate is a no-op
+template <typename T>
+struct FrameAllocator {
+    typedef T value_type;
+
+    FrameAllocator() = default;
+    template <typename U> FrameAllocator(const FrameAllocator<U>&) {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(FrameArena::GetInstance().Allocate(n * sizeof(T), alignof(T)));
+    }
+    void deallocate(T*, size_t) {}
+};
+
+template <typename T, typename U>
+bool operator==(const FrameAllocator<T>&, const FrameAllocator<U>&) { return true; }
+template <typename T, typename U>
+bool operator!=(const FrameAllocator<T>&, const FrameAllocator<U>&) { return false; }
+
+// Transient containers, must not outlive the frame they were filled in
+template <typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
+typedef std::basic_string<char, std::char_traits<char>, FrameAllocator<char>> FrameString;
+
+#endif
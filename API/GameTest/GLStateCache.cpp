@@ -0,0 +1,94 @@
+//------------------------------------------------------------------------
+// GLStateCache.cpp
+//------------------------------------------------------------------------
+#include "stdafx.h"
+#include "GLStateCache.h"
+
+GLStateCache::GLStateCache() {
+    Invalidate();
+}
+
+void GLStateCache::Invalidate() {
+    for (int i = 0; i < CAP_COUNT; i++) {
+        enabled[i] = -1;
+    }
+    blendSrc = blendDst = GL_ONE;
+    blendKnown = false;
+    polygonMode = GL_FILL;
+    polygonModeKnown = false;
+    lineWidth = 1.0f;
+    lineWidthKnown = false;
+    color[0] = color[1] = color[2] = color[3] = 1.0f;
+    colorKnown = false;
+}
+
+int GLStateCache::CapIndex(GLenum cap) {
+    switch (cap) {
+    case GL_BLEND:        return CAP_BLEND;
+    case GL_DEPTH_TEST:   return CAP_DEPTH_TEST;
+    case GL_LIGHTING:     return CAP_LIGHTING;
+    case GL_POINT_SMOOTH: return CAP_POINT_SMOOTH;
+    case GL_TEXTURE_2D:   return CAP_TEXTURE_2D;
+    default:              return -1;
+    }
+}
+
+void GLStateCache::SetEnabled(GLenum cap, bool enable) {
+    counters.requested++;
+
+    // Caps we don't track always go straight through
+    int index = CapIndex(cap);
+    if (index >= 0) {
+        int8_t value = enable ? 1 : 0;
+        if (enabled[index] == value) return;
+        enabled[index] = value;
+    }
+
+    if (enable) glEnable(cap);
+    else glDisable(cap);
+    counters.issued++;
+}
+
+void GLStateCache::BlendFunc(GLenum src, GLenum dst) {
+    counters.requested++;
+    if (blendKnown && blendSrc == src && blendDst == dst) return;
+
+    blendSrc = src;
+    blendDst = dst;
+    blendKnown = true;
+    glBlendFunc(src, dst);
+    counters.issued++;
+}
+
+void GLStateCache::PolygonMode(GLenum mode) {
+    counters.requested++;
+    if (polygonModeKnown && polygonMode == mode) return;
+
+    polygonMode = mode;
+    polygonModeKnown = true;
+    glPolygonMode(GL_FRONT_AND_BACK, mode);
+    counters.issued++;
+}
+
+void GLStateCache::LineWidth(float width) {
+    counters.requested++;
+    if (lineWidthKnown && lineWidth == width) return;
+
+    lineWidth = width;
+    lineWidthKnown = true;
+    glLineWidth(width);
+    counters.issued++;
+}
+
+void GLStateCache::Color(float r, float g, float b, float a) {
+    counters.requested++;
+    if (colorKnown && color[0] == r && color[1] == g && color[2] == b && color[3] == a) return;
+
+    color[0] = r;
+    color[1] = g;
+    color[2] = b;
+    color[3] = a;
+    colorKnown = true;
+    glColor4f(r, g, b, a);
+    counters.issued++;
+}
@@ -0,0 +1,67 @@
+//------------------------------------------------------------------------
+// GLStateCache.h
+//------------------------------------------------------------------------
+#ifndef GL_STATE_CACHE_H
+#define GL_STATE_CACHE_H
+
+#include <windows.h>
+#include <GL/gl.h>
+#include <cstdint>
+
+// Shadow copy of the fixed function state the game touches. Setters only
+// reach GL when the value actually changes. Code that changes GL state
+// behind the cache's back has to call Invalidate() afterwards.
+class GLStateCache {
+public:
+    struct Counters {
+        int requested = 0;  // Setter calls made by the game
+        int issued = 0;     // Calls that actually reached GL
+    };
+
+    GLStateCache();
+
+    void Invalidate();
+
+    void Enable(GLenum cap) { SetEnabled(cap, true); }
+    void Disable(GLenum cap) { SetEnabled(cap, false); }
+    void SetEnabled(GLenum cap, bool enabled);
+    void BlendFunc(GLenum src, GLenum dst);
+    void PolygonMode(GLenum mode);
+    void LineWidth(float width);
+    void Color(float r, float g, float b, float a = 1.0f);
+
+    // For draw code that sets per-vertex colours with glColor directly
+    void InvalidateColor() { colorKnown = false; }
+
+    void ResetCounters() { counters = Counters(); }
+    const Counters& GetCounters() const { return counters; }
+
+private:
+    enum Cap {
+        CAP_BLEND,
+        CAP_DEPTH_TEST,
+        CAP_LIGHTING,
+        CAP_POINT_SMOOTH,
+        CAP_TEXTURE_2D,
+        CAP_COUNT
+    };
+    static int CapIndex(GLenum cap);
+
+    int8_t enabled[CAP_COUNT];  // -1 unknown, 0 disabled, 1 enabled
+
+    GLenum blendSrc, blendDst;
+    bool blendKnown;
+
+    GLenum polygonMode;
+    bool polygonModeKnown;
+
+    float lineWidth;
+    bool lineWidthKnown;
+
+    float color[4];
+    bool colorKnown;
+
+    Counters counters;
+};
+
+#endif
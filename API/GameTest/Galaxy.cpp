@@ -2,152 +2,423 @@
 #include "Galaxy.h"
 #include <GL/gl.h>
 #include <math.h>
+#include <algorithm>
 #include <App/AppSettings.h>
 #include <DebugUtils.h>
-
-Galaxy::Galaxy(Renderer3D* renderer, int starsPerChunk, int numPlanets)
-    : starsPerChunk(starsPerChunk),
-    chunkSize(100.0f),
+#include "JobSystem.h"
+#include "OrbitKernel.h"
+#include "Viewport.h"
+#include <chrono>
+#include "AllocationTracker.h"
+
+Galaxy::Galaxy(Renderer3D* renderer, const GalaxySettings& settings, int numPlanets)
+    : settings(settings),
     renderer(renderer),
     numPlanets(numPlanets)
 {
+    if (!settings.cataloguePath.empty()) {
+        LoadCatalogue(settings.cataloguePath.c_str());
+    }
+
+    SpawnPlanets(numPlanets);
+}
+
+void Galaxy::SpawnPlanets(int count) {
     const float MIN_PLANET_DISTANCE = 150.0f;  // Increased from 100.0f
-    const float SPAWN_RANGE = 300.0f;  // Increased spawn range
 
-    planets.resize(numPlanets);
-    for (auto& planet : planets) {
+    // Grow the spawn volume with the planet count so they always fit
+    float spawnRange = std::max(300.0f, 0.5f * MIN_PLANET_DISTANCE * cbrtf(3.0f * count));
+
+    // Spacing checks only look at neighbouring grid cells
+    std::map<ChunkKey, std::vector<Transform>> grid;
+    auto cellOf = [MIN_PLANET_DISTANCE](float x, float y, float z) {
+        ChunkKey key;
+        key.x = (int)floorf(x / MIN_PLANET_DISTANCE);
+        key.y = (int)floorf(y / MIN_PLANET_DISTANCE);
+        key.z = (int)floorf(z / MIN_PLANET_DISTANCE);
+        return key;
+    };
+
+    entities.transforms.Reserve(count);
+    entities.orbits.Reserve(count * 6);
+    entities.renderables.Reserve(count * 7);
+    entities.planets.Reserve(count);
+
+    for (int p = 0; p < count; p++) {
+        Transform position;
         bool validPosition = false;
         while (!validPosition) {
-            // Increased range for spawning
-            planet.x = RandomRange(-SPAWN_RANGE, SPAWN_RANGE);
-            planet.y = RandomRange(-SPAWN_RANGE, SPAWN_RANGE);
-            planet.z = RandomRange(-SPAWN_RANGE, SPAWN_RANGE);
+            position.x = RandomRange(-spawnRange, spawnRange);
+            position.y = RandomRange(-spawnRange, spawnRange);
+            position.z = RandomRange(-spawnRange, spawnRange);
 
             validPosition = true;
-            for (const auto& otherPlanet : planets) {
-                if (&planet == &otherPlanet) continue;
-
-                float distance = sqrt(pow(planet.x - otherPlanet.x, 2) +
-                    pow(planet.y - otherPlanet.y, 2) +
-                    pow(planet.z - otherPlanet.z, 2));
-
-                if (distance < MIN_PLANET_DISTANCE) {
-                    validPosition = false;
-                    break;
+            ChunkKey cell = cellOf(position.x, position.y, position.z);
+            for (int dx = -1; dx <= 1 && validPosition; dx++) {
+                for (int dy = -1; dy <= 1 && validPosition; dy++) {
+                    for (int dz = -1; dz <= 1 && validPosition; dz++) {
+                        auto it = grid.find({ cell.x + dx, cell.y + dy, cell.z + dz });
+                        if (it == grid.end()) continue;
+
+                        for (const Transform& other : it->second) {
+                            float distance = sqrtf(powf(position.x - other.x, 2) +
+                                powf(position.y - other.y, 2) +
+                                powf(position.z - other.z, 2));
+
+                            if (distance < MIN_PLANET_DISTANCE) {
+                                validPosition = false;
+                                break;
+                            }
+                        }
+                    }
                 }
             }
         }
+        grid[cellOf(position.x, position.y, position.z)].push_back(position);
 
         int numRings = rand() % 5 + 2;
 
+        Entity planet = entities.Create();
+        entities.transforms.Add(planet, position);
+        entities.renderables.Add(planet, { MeshId::PlanetCube, 1.0f, 0.0f, 1.0f });
+        entities.planets.Add(planet, { numRings, false, false });
+
         for (int i = 0; i < numRings; i++) {
-            Ring ring;
-            ring.orbitRadius = RandomRange(15.0f, 25.0f); // Increment orbit radius for each ring
-            ring.angle = RandomRange(0.0f, 360.0f) + (i * 45.0f);
-            while (ring.angle >= 360.0f) ring.angle -= 360.0f;          // Random starting angle
-            ring.selfAngle = 0.0f;                           // Initial self rotation
-            ring.rotationSpeed = 10.0f;  // Slower orbit speed
-            ring.selfRotationSpeed = RandomRange(5.0f, 15.0f); // Even slower self rotation
-            planet.rings.push_back(ring);
+            Orbit orbit;
+            orbit.parent = planet;
+            orbit.radius = RandomRange(15.0f, 25.0f); // Increment orbit radius for each ring
+            orbit.angle = RandomRange(0.0f, 360.0f) + (i * 45.0f);
+            while (orbit.angle >= 360.0f) orbit.angle -= 360.0f;          // Random starting angle
+            orbit.selfAngle = 0.0f;                           // Initial self rotation
+            orbit.speed = 10.0f;  // Slower orbit speed
+            orbit.selfSpeed = RandomRange(5.0f, 15.0f); // Even slower self rotation
+            orbit.yawAngle = 0.0f;
+
+            Entity ring = entities.Create();
+            entities.orbits.Add(ring, orbit, position);
+            entities.healths.Add(ring, { RING_HEALTH, RING_HEALTH });
+            entities.weapons.Add(ring, { FIRE_RATE, 0.0f });
+            entities.renderables.Add(ring, { MeshId::Ring, 1.0f, 0.0f, 0.0f });
         }
     }
 }
 
 ChunkKey Galaxy::GetChunkFromPosition(float x, float y, float z) {
     ChunkKey key;
-    key.x = static_cast<int>(floor(x / chunkSize));
-    key.y = static_cast<int>(floor(y / chunkSize));
-    key.z = static_cast<int>(floor(z / chunkSize));
+    key.x = static_cast<int>(floor(x / settings.chunkSize));
+    key.y = static_cast<int>(floor(y / settings.chunkSize));
+    key.z = static_cast<int>(floor(z / settings.chunkSize));
     return key;
 }
 
-void Galaxy::CreateStar(Star& star, const ChunkKey& chunk) {
-    float minX = chunk.x * chunkSize;
-    float minY = chunk.y * chunkSize;
-    float minZ = chunk.z * chunkSize;
+// Use chunk coordinates as seed for consistent star generation
+Galaxy::ChunkRandom::ChunkRandom(const ChunkKey& chunk)
+    : engine((unsigned int)(chunk.x * 73856093 + chunk.y * 19349663 + chunk.z * 83492791)) {
+}
 
-    star.x = RandomRange(minX, minX + chunkSize);
-    star.y = RandomRange(minY, minY + chunkSize);
-    star.z = RandomRange(minZ, minZ + chunkSize);
+float Galaxy::ChunkRandom::Next() {
+    return (float)(engine() - engine.min()) / (float)(engine.max() - engine.min());
+}
 
-    // Use chunk coordinates as seed for consistent star generation
-    unsigned int seed = chunk.x * 73856093 + chunk.y * 19349663 + chunk.z * 83492791;
-    srand(seed);
+void Galaxy::CreateStar(Star& star, const ChunkKey& chunk, ChunkRandom& random) {
+    float minX = chunk.x * settings.chunkSize;
+    float minY = chunk.y * settings.chunkSize;
+    float minZ = chunk.z * settings.chunkSize;
 
-    star.brightness = pow(Random(), 2.0f);
+    star.x = random.Range(minX, minX + settings.chunkSize);
+    star.y = random.Range(minY, minY + settings.chunkSize);
+    star.z = random.Range(minZ, minZ + settings.chunkSize);
+
+    star.brightness = pow(random.Next(), 2.0f);
 
     // Size distribution
-    float sizeRand = Random();
+    float sizeRand = random.Next();
     if (sizeRand > 0.99f) {
-        star.size = RandomRange(2.0f, 3.0f);
+        star.size = random.Range(2.0f, 3.0f);
     }
     else if (sizeRand > 0.95f) {
-        star.size = RandomRange(1.0f, 2.0f);
+        star.size = random.Range(1.0f, 2.0f);
     }
     else {
-        star.size = RandomRange(0.1f, 1.0f);
+        star.size = random.Range(0.1f, 1.0f);
     }
 
     // Color distribution
-    float colorType = Random();
+    float colorType = random.Next();
     if (colorType > 0.95f) {  // Red giants
-        star.r = RandomRange(0.8f, 1.0f);
-        star.g = RandomRange(0.0f, 0.3f);
-        star.b = RandomRange(0.0f, 0.2f);
+        star.r = random.Range(0.8f, 1.0f);
+        star.g = random.Range(0.0f, 0.3f);
+        star.b = random.Range(0.0f, 0.2f);
     }
     else if (colorType > 0.90f) {  // Blue stars
-        star.r = RandomRange(0.0f, 0.4f);
-        star.g = RandomRange(0.0f, 0.4f);
-        star.b = RandomRange(0.8f, 1.0f);
+        star.r = random.Range(0.0f, 0.4f);
+        star.g = random.Range(0.0f, 0.4f);
+        star.b = random.Range(0.8f, 1.0f);
     }
     else {  // White/yellow stars
-        float baseColor = RandomRange(0.7f, 1.0f);
+        float baseColor = random.Range(0.7f, 1.0f);
         star.r = baseColor;
         star.g = baseColor;
-        star.b = RandomRange(baseColor, 1.0f);
+        star.b = random.Range(baseColor, 1.0f);
     }
 }
 
 void Galaxy::CreateChunk(const ChunkKey& key) {
-    std::vector<Star>& chunkStars = chunks[key];
-    chunkStars.resize(starsPerChunk);
+    std::vector<PackedStar>& chunkStars = chunks[key];
+
+    auto start = std::chrono::steady_clock::now();
+    bool fromCatalogue = catalogue.ReadChunk(key, chunkStars);
+    if (!fromCatalogue) {
+        GenerateStars(key, chunkStars);
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
 
-    for (Star& star : chunkStars) {
-        CreateStar(star, key);
+    if (fromCatalogue) {
+        chunkStats.catalogueChunks++;
+        chunkStats.catalogueMs += ms;
+    }
+    else {
+        chunkStats.generatedChunks++;
+        chunkStats.generateMs += ms;
+    }
+}
+
+void Galaxy::GenerateStars(const ChunkKey& key, std::vector<PackedStar>& stars) {
+    float originX = key.x * settings.chunkSize;
+    float originY = key.y * settings.chunkSize;
+    float originZ = key.z * settings.chunkSize;
+
+    ChunkRandom random(key);
+    stars.resize(settings.starsPerChunk);
+    for (PackedStar& packed : stars) {
+        Star star;
+        CreateStar(star, key, random);
+        packed = PackedStar::Pack(star, originX, originY, originZ, settings.chunkSize);
     }
 }
 
 void Galaxy::UpdateVisibleChunks(const Camera& camera) {
+    AllocationScope allocationScope(AllocTag::Stars);
+
     float camX, camY, camZ;
     camera.GetPosition(camX, camY, camZ);
     ChunkKey centerChunk = GetChunkFromPosition(camX, camY, camZ);
 
-    const int RENDER_DISTANCE = 5;
+    if (wantedDirty || centerChunk < wantedCenter || wantedCenter < centerChunk) {
+        const int range = settings.renderDistance;
+
+        wantedChunks.clear();
+        for (int x = centerChunk.x - range; x <= centerChunk.x + range; x++) {
+            for (int y = centerChunk.y - range; y <= centerChunk.y + range; y++) {
+                for (int z = centerChunk.z - range; z <= centerChunk.z + range; z++) {
+                    wantedChunks.push_back({ x, y, z });
+                }
+            }
+        }
 
-    // Remove far chunks
-    for (auto it = chunks.begin(); it != chunks.end();) {
-        const ChunkKey& key = it->first;
-        if (abs(key.x - centerChunk.x) > RENDER_DISTANCE ||
-            abs(key.y - centerChunk.y) > RENDER_DISTANCE ||
-            abs(key.z - centerChunk.z) > RENDER_DISTANCE) {
-            it = chunks.erase(it);
+        // Nearest first, so the budget cuts off the farthest chunks
+        auto distanceSq = [&centerChunk](const ChunkKey& key) {
+            int dx = key.x - centerChunk.x;
+            int dy = key.y - centerChunk.y;
+            int dz = key.z - centerChunk.z;
+            return dx * dx + dy * dy + dz * dz;
+        };
+        auto nearerFirst = [&distanceSq](const ChunkKey& a, const ChunkKey& b) {
+            int da = distanceSq(a), db = distanceSq(b);
+            if (da != db) return da < db;
+            return a < b;
+        };
+        std::sort(wantedChunks.begin(), wantedChunks.end(), nearerFirst);
+
+        size_t maxChunks = wantedChunks.size();
+        size_t chunkBytes = (size_t)settings.starsPerChunk * sizeof(PackedStar);
+        chunkStats.budgetBytes = (size_t)(settings.starBudgetMB * 1024.0f * 1024.0f);
+        if (chunkStats.budgetBytes > 0 && chunkBytes > 0) {
+            maxChunks = std::min(maxChunks, chunkStats.budgetBytes / chunkBytes);
         }
-        else {
-            ++it;
+        chunkStats.chunksOverBudget = (int)(wantedChunks.size() - maxChunks);
+        wantedChunks.resize(maxChunks);
+
+        // Evict everything that is out of range or past the budget
+        for (auto it = chunks.begin(); it != chunks.end();) {
+            if (!std::binary_search(wantedChunks.begin(), wantedChunks.end(), it->first, nearerFirst)) {
+                auto evicted = it++;
+                EvictChunk(evicted);
+            }
+            else {
+                ++it;
+            }
         }
+
+        wantedCenter = centerChunk;
+        wantedDirty = false;
     }
 
     // Create new chunks in range
-    for (int x = centerChunk.x - RENDER_DISTANCE; x <= centerChunk.x + RENDER_DISTANCE; x++) {
-        for (int y = centerChunk.y - RENDER_DISTANCE; y <= centerChunk.y + RENDER_DISTANCE; y++) {
-            for (int z = centerChunk.z - RENDER_DISTANCE; z <= centerChunk.z + RENDER_DISTANCE; z++) {
-                ChunkKey key{ x, y, z };
-                if (chunks.find(key) == chunks.end()) {
-                    CreateChunk(key);
-                }
+    for (const ChunkKey& key : wantedChunks) {
+        if (chunks.find(key) == chunks.end()) {
+            LoadChunk(key);
+        }
+    }
+
+    UpdateChunkStats();
+}
+
+void Galaxy::UpdateChunkStats() {
+    chunkStats.loadedChunks = (int)chunks.size();
+    chunkStats.loadedStars = 0;
+    for (const auto& pair : chunks) {
+        chunkStats.loadedStars += (int)pair.second.size();
+    }
+    chunkStats.loadedBytes = (size_t)chunkStats.loadedStars * sizeof(PackedStar);
+    chunkStats.cachedChunks = (int)chunkCache.size();
+    chunkStats.cachedBytes = chunkCacheBytes;
+}
+
+void Galaxy::LoadChunk(const ChunkKey& key) {
+    auto cached = chunkCache.find(key);
+    if (cached == chunkCache.end()) {
+        chunkStats.cacheMisses++;
+        CreateChunk(key);
+        return;
+    }
+
+    chunkStats.cacheHits++;
+    chunkCacheBytes -= cached->second.stars.size() * sizeof(PackedStar);
+    chunkCacheLRU.erase(cached->second.lruPosition);
+    chunks[key] = std::move(cached->second.stars);
+    chunkCache.erase(cached);
+}
+
+void Galaxy::EvictChunk(std::map<ChunkKey, std::vector<PackedStar>>::iterator chunk) {
+    size_t cacheBudget = (size_t)(settings.chunkCacheMB * 1024.0f * 1024.0f);
+    size_t bytes = chunk->second.size() * sizeof(PackedStar);
+
+    if (bytes <= cacheBudget) {
+        TrimChunkCache(cacheBudget - bytes);
+
+        chunkCacheLRU.push_front(chunk->first);
+        CachedChunk& cached = chunkCache[chunk->first];
+        cached.stars = std::move(chunk->second);
+        cached.lruPosition = chunkCacheLRU.begin();
+        chunkCacheBytes += bytes;
+    }
+
+    chunks.erase(chunk);
+}
+
+void Galaxy::TrimChunkCache(size_t budgetBytes) {
+    while (chunkCacheBytes > budgetBytes && !chunkCacheLRU.empty()) {
+        auto oldest = chunkCache.find(chunkCacheLRU.back());
+        chunkCacheBytes -= oldest->second.stars.size() * sizeof(PackedStar);
+        chunkCache.erase(oldest);
+        chunkCacheLRU.pop_back();
+    }
+}
+
+void Galaxy::SetSettings(const GalaxySettings& newSettings) {
+    bool regenerate = newSettings.chunkSize != settings.chunkSize ||
+        newSettings.starsPerChunk != settings.starsPerChunk;
+
+    settings = newSettings;
+    if (regenerate) {
+        chunks.clear();
+        TrimChunkCache(0);
+    }
+    else {
+        TrimChunkCache((size_t)(settings.chunkCacheMB * 1024.0f * 1024.0f));
+    }
+    wantedDirty = true;
+}
+
+bool Galaxy::LoadCatalogue(const char* path) {
+    if (!catalogue.Open(path)) {
+        return false;
+    }
+
+    settings.chunkSize = catalogue.GetChunkSize();
+    chunks.clear();
+    TrimChunkCache(0);
+    wantedDirty = true;
+
+    DebugPrint("Galaxy: loaded star catalogue %s, %d chunks\n", path, catalogue.GetChunkCount());
+    return true;
+}
+
+bool Galaxy::BakeCatalogue(const char* path, const ChunkKey& center, int radius) {
+    std::vector<StarCatalogue::BakedChunk> baked;
+    for (int x = center.x - radius; x <= center.x + radius; x++) {
+        for (int y = center.y - radius; y <= center.y + radius; y++) {
+            for (int z = center.z - radius; z <= center.z + radius; z++) {
+                StarCatalogue::BakedChunk chunk;
+                chunk.key = { x, y, z };
+                GenerateStars(chunk.key, chunk.stars);
+                baked.push_back(std::move(chunk));
             }
         }
     }
+
+    return StarCatalogue::Bake(path, settings.chunkSize, baked);
+}
+
+void GalaxySettings::LoadFromFile(const char* path) {
+    char value[32];
+    char fallback[32];
+
+    sprintf_s(fallback, "%d", renderDistance);
+    GetPrivateProfileStringA("Galaxy", "RenderDistance", fallback, value, sizeof(value), path);
+    renderDistance = std::max(0, atoi(value));
+
+    sprintf_s(fallback, "%g", chunkSize);
+    GetPrivateProfileStringA("Galaxy", "ChunkSize", fallback, value, sizeof(value), path);
+    chunkSize = (float)atof(value);
+    if (chunkSize <= 0.0f) chunkSize = 100.0f;
+
+    sprintf_s(fallback, "%d", starsPerChunk);
+    GetPrivateProfileStringA("Galaxy", "StarsPerChunk", fallback, value, sizeof(value), path);
+    starsPerChunk = std::max(0, atoi(value));
+
+    sprintf_s(fallback, "%g", starBudgetMB);
+    GetPrivateProfileStringA("Galaxy", "StarBudgetMB", fallback, value, sizeof(value), path);
+    starBudgetMB = std::max(0.0f, (float)atof(value));
+
+    sprintf_s(fallback, "%g", chunkCacheMB);
+    GetPrivateProfileStringA("Galaxy", "ChunkCacheMB", fallback, value, sizeof(value), path);
+    chunkCacheMB = std::max(0.0f, (float)atof(value));
+
+    char catalogue[MAX_PATH];
+    GetPrivateProfileStringA("Galaxy", "Catalogue", cataloguePath.c_str(), catalogue, sizeof(catalogue), path);
+    cataloguePath = catalogue;
+
+    starLOD.LoadFromFile(path);
+}
+
+void StarLOD::LoadFromFile(const char* path) {
+    char value[64];
+
+    GetPrivateProfileStringA("StarLOD", "Enabled", enabled ? "1" : "0", value, sizeof(value), path);
+    enabled = atoi(value) != 0;
+    GetPrivateProfileStringA("StarLOD", "CompensateBrightness", compensateBrightness ? "1" : "0", value, sizeof(value), path);
+    compensateBrightness = atoi(value) != 0;
+
+    // Level0, Level1 ... as "distance, keepFraction", up to the first missing key
+    std::vector<StarLODLevel> loaded;
+    for (int i = 0; ; i++) {
+        char key[16];
+        sprintf_s(key, "Level%d", i);
+        if (!GetPrivateProfileStringA("StarLOD", key, "", value, sizeof(value), path)) break;
+
+        StarLODLevel level;
+        if (sscanf_s(value, "%f , %f", &level.distance, &level.keepFraction) != 2) break;
+        level.keepFraction = std::min(std::max(level.keepFraction, 0.0f), 1.0f);
+        loaded.push_back(level);
+    }
+
+    if (!loaded.empty()) {
+        std::sort(loaded.begin(), loaded.end(),
+            [](const StarLODLevel& a, const StarLODLevel& b) { return a.distance < b.distance; });
+        levels = loaded;
+    }
 }
 
 void Galaxy::Update(float deltaTime, const Camera& camera) {
@@ -167,15 +438,29 @@ void Galaxy::Update(float deltaTime, const Camera& camera) {
         explosions.end());
 
     UpdateVisibleChunks(camera);
+    UpdateEntities(deltaTime);
+
+    // Update star twinkling
+    for (auto& pair : chunks) {
+        std::vector<PackedStar>& stars = pair.second;
+        for (PackedStar& star : stars) {
+            if (Random() < 0.01f) {  // Only 1% of stars twinkle each frame
+                float brightness = star.brightness * RandomRange(0.5f, 1.5f);
+                if (brightness < 0.1f * 255.0f) brightness = 0.1f * 255.0f;
+                if (brightness > 255.0f) brightness = 255.0f;
+                star.brightness = (uint8_t)brightness;
+            }
+        }
+    }
+}
+
+void Galaxy::UpdateEntities(float deltaTime) {
+    this->deltaTime = deltaTime;
 
     if (spaceship != nullptr) {
         float spaceshipX, spaceshipY, spaceshipZ;
         spaceship->GetPosition(spaceshipX, spaceshipY, spaceshipZ);
 
-        char debugText[256];
-        int closestRingIndex = -1;
-        float closestDistance = FLT_MAX;
-
         // Process bullets
         for (auto bulletIt = bullets.begin(); bulletIt != bullets.end();) {
             bool bulletDestroyed = false;
@@ -194,126 +479,212 @@ void Galaxy::Update(float deltaTime, const Camera& camera) {
             }
         }
 
-        for (int p = 0; p < planets.size(); p++) {
-            auto& planet = planets[p];
-
-            // Check if planet should become collectable
-            if (!planet.isCollectable && !planet.HasActiveRings()) {
-                planet.isCollectable = true;
-            }
-
-            // Check for collection if planet is collectable and not already collected
-            if (planet.isCollectable && !planet.isCollected) {
-                float dx = spaceshipX - planet.x;
-                float dy = spaceshipY - planet.y;
-                float distance = sqrt(dx * dx + dy * dy);
+        auto start = std::chrono::steady_clock::now();
 
-                if (distance < Planet::COLLECTION_RADIUS) {
-                    // Collect the planet
-                    planet.isCollected = true;
+        UpdateRings(spaceshipX, spaceshipY);
+        UpdatePlanets(spaceshipX, spaceshipY);
 
-                    // Replenish spaceship health and ammo
-                    spaceship->health = Spaceship::INITIAL_HEALTH;
-                    spaceship->currentAmmo = Spaceship::MAX_AMMO;
-                }
-            }
+        entityUpdateMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
 
-            for (int r = 0; r < planet.rings.size(); r++) {
-                auto& ring = planet.rings[r];
+    // Update bullets
+    bullets.erase(
+        std::remove_if(bullets.begin(), bullets.end(),
+            [](const Bullet& b) { return !b.IsActive(); }),
+        bullets.end());
+}
 
-                if (!ring.isActive) continue;  // Skip inactive rings
-                
-                float normalizedAngle = fmodf(ring.angle, 360.0f);
-                float angleInRadians = normalizedAngle * 3.14159f / 180.0f;
+uint32_t Galaxy::GetEntityChecksum() const {
+    // FNV-1a over everything the entity update writes
+    uint32_t hash = 2166136261u;
+    auto mix = [&hash](const void* data, size_t size) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; i++) {
+            hash = (hash ^ bytes[i]) * 16777619u;
+        }
+    };
+
+    const OrbitArray& orbits = entities.orbits;
+    int count = orbits.Size();
+    if (count > 0) {
+        mix(orbits.angle.data(), sizeof(float) * count);
+        mix(orbits.selfAngle.data(), sizeof(float) * count);
+        mix(orbits.yawAngle.data(), sizeof(float) * count);
+    }
+    for (int i = 0; i < entities.healths.Size(); i++) {
+        mix(&entities.healths[i].current, sizeof(int));
+    }
+    for (int i = 0; i < entities.weapons.Size(); i++) {
+        mix(&entities.weapons[i].cooldown, sizeof(float));
+    }
+    return hash;
+}
 
-                // Calculate ring's world position
-                float ringX = planet.x + ring.orbitRadius * cos(angleInRadians);
-                float ringY = planet.y + ring.orbitRadius * sin(angleInRadians);
-                float ringZ = planet.z;
+// Orbits, ship bullet hits and ring weapons. Rings are updated in parallel
+// batches that only write to their own rings and to per-slice buffers.
+// Everything shared, bullets, explosions and planet state, is then applied
+// on this thread in ring order, so the outcome doesn't depend on the thread
+// count.
+void Galaxy::UpdateRings(float spaceshipX, float spaceshipY) {
+    OrbitArray& orbits = entities.orbits;
+    JobSystem& jobs = JobSystem::GetInstance();
+    FrameArena& frame = FrameArena::GetInstance();
+    std::vector<Bullet>& shipBullets = spaceship->GetBullets();
+    int count = orbits.Size();
+    int bulletCount = (int)shipBullets.size();
+
+    // Move every ring and find the ones close enough to the ship to engage it
+    OrbitUpdateParams params;
+    params.deltaTime = deltaTime;
+    params.targetX = spaceshipX;
+    params.targetY = spaceshipY;
+    params.influenceRadius = spaceship->IsAlive() ? INFLUENCE_RADIUS : 0.0f;
+
+    // Each batch writes its engaged rings to its own part of engaged
+    int* engaged = static_cast<int*>(frame.Allocate(sizeof(int) * count, alignof(int)));
+
+    sliceRingHits.resize(jobs.GetSliceCount());
+    sliceSpawns.resize(jobs.GetSliceCount());
+    for (int slice = 0; slice < jobs.GetSliceCount(); slice++) {
+        sliceRingHits[slice].clear();
+        sliceSpawns[slice].clear();
+    }
 
-                // Check spaceship's bullets against this ring
-                std::vector<Bullet>& shipBullets = spaceship->GetBullets();
-                for (auto& shipBullet : shipBullets) {
-                    if (shipBullet.CheckRingCollision(ringX, ringY)) {
-                        ring.health -= shipBullet.DAMAGE;
+    auto start = std::chrono::steady_clock::now();
+    jobs.ParallelForStealing(count, RING_BATCH_SIZE, [&](int begin, int end, int slice) {
+        int* batchEngaged = engaged + begin;
+        int engagedCount = useReferenceOrbits
+            ? OrbitKernel::UpdateReference(orbits, begin, end, params, batchEngaged)
+            : OrbitKernel::Update(orbits, begin, end, params, batchEngaged);
+
+        // Engaged rings fire at the ship, they already face it
+        std::vector<ProjectileSpawn>& spawns = sliceSpawns[slice];
+        for (int k = 0; k < engagedCount; k++) {
+            int i = batchEngaged[k];
+            Weapon& weapon = entities.weapons.Get(orbits.EntityAt(i));
+            weapon.cooldown -= deltaTime;
+            if (weapon.cooldown <= 0.0f) {
+                spawns.push_back({ i, orbits.x[i], orbits.y[i], orbits.yawAngle[i] });
+                weapon.cooldown = weapon.fireInterval;
+            }
+        }
 
-                        if (ring.health <= 0) {
-                            explosions.emplace_back(ringX, ringY, 0);
-                            ring.isActive = false;
-                        }
-                        shipBullet.Deactivate();
-                    }
+        // Check spaceship's bullets against these rings, hits are applied below
+        if (bulletCount == 0) return;
+        std::vector<RingHit>& hits = sliceRingHits[slice];
+        for (int i = begin; i < end; i++) {
+            for (int b = 0; b < bulletCount; b++) {
+                if (shipBullets[b].CheckRingCollision(orbits.x[i], orbits.y[i])) {
+                    hits.push_back({ i, b });
                 }
+            }
+        }
+    });
+    orbitKernelMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    // Apply hits in ring then bullet order. A bullet only hits the first
+    // ring it reaches and a destroyed ring takes no more hits.
+    FrameVector<RingHit> hits;
+    for (const auto& sliceHits : sliceRingHits) {
+        hits.insert(hits.end(), sliceHits.begin(), sliceHits.end());
+    }
+    std::sort(hits.begin(), hits.end(), [](const RingHit& a, const RingHit& b) {
+        return a.ring != b.ring ? a.ring < b.ring : a.bullet < b.bullet;
+    });
+
+    FrameVector<Entity> destroyed;
+    int destroyedIndex = -1;
+    for (const RingHit& hit : hits) {
+        Bullet& shipBullet = shipBullets[hit.bullet];
+        if (hit.ring == destroyedIndex || !shipBullet.IsActive()) continue;
+        shipBullet.Deactivate();
+
+        Entity ring = orbits.EntityAt(hit.ring);
+        if (DamageRing(ring, shipBullet.DAMAGE)) {
+            destroyed.push_back(ring);
+            destroyedIndex = hit.ring;
+        }
+    }
 
-                float dx = spaceshipX - ringX;
-                float dy = spaceshipY - ringY;
-                float distanceToShip = sqrt(dx * dx + dy * dy);
-
-                if (distanceToShip < INFLUENCE_RADIUS && spaceship->IsAlive()) {
-                    // Face the spaceship and stop orbital movement
-                    float targetAngle = atan2f(dy, dx) * 180.0f / 3.14159f;
-                    float influence = 1.0f - (distanceToShip / INFLUENCE_RADIUS);
-                    ring.yawAngle = targetAngle;
+    FlushProjectileSpawns();
 
-                    fireTimer -= deltaTime;
-                    if (fireTimer <= 0.0f) {
-                        // Calculate firing position at the ring's current position
-                        float spawnX = ringX;
-                        float spawnY = ringY;
+    for (auto& bullet : bullets) {
+        bullet.Update(deltaTime, spaceshipX, spaceshipY);
+    }
 
-                        // Calculate angle towards spaceship
-                        float angleToShip = atan2f(spaceshipY - ringY, spaceshipX - ringX) * 180.0f / 3.14159f;
+    for (Entity ring : destroyed) {
+        if (entities.orbits.Has(ring)) {
+            entities.Destroy(ring);
+        }
+    }
+}
 
-                        // Fire bullet
-                        FireBullet(spawnX, spawnY);
-                        fireTimer = FIRE_RATE;  // Reset timer
-                    }
-                }
-                else {
-                    // Resume both orbital and self rotation when not influenced
-                    ring.angle += ring.rotationSpeed * deltaTime;
-                    if (ring.angle > 360.0f) ring.angle -= 360.0f;
+// All ring damage goes through here so the parent's ring count stays exact
+bool Galaxy::DamageRing(Entity ring, int amount) {
+    Health& health = entities.healths.Get(ring);
+    if (!health.IsAlive()) return false;
 
-                    ring.selfAngle += ring.selfRotationSpeed * deltaTime;
-                    if (ring.selfAngle > 360.0f) ring.selfAngle -= 360.0f;
+    health.current -= amount;
+    if (health.IsAlive()) return false;
+    health.current = 0;
 
-                    ring.yawAngle = 0.0f;
-                }
+    int index = entities.orbits.IndexOf(ring);
+    explosions.emplace_back(entities.orbits.x[index], entities.orbits.y[index], 0);
 
-                // Update bullets
-                for (auto& bullet : bullets) {
-                    bullet.Update(deltaTime, ringX, ringY);
-                }
-            }
-        }
+    Entity parent = entities.orbits.parent[index];
+    PlanetInfo& planet = entities.planets.Get(parent);
+    planet.activeRings--;
+    if (planet.activeRings == 0) {
+        OnPlanetCollectable(parent);
     }
+    return true;
+}
 
-    // Update bullets
-    bullets.erase(
-        std::remove_if(bullets.begin(), bullets.end(),
-            [](const Bullet& b) { return !b.IsActive(); }),
-        bullets.end());
+void Galaxy::OnPlanetCollectable(Entity planet) {
+    entities.planets.Get(planet).collectable = true;
+    collectablePlanets.push_back(planet);
+}
 
-    // Update star twinkling
-    for (auto& pair : chunks) {
-        std::vector<Star>& stars = pair.second;
-        for (Star& star : stars) {
-            if (Random() < 0.01f) {  // Only 1% of stars twinkle each frame
-                star.brightness *= RandomRange(0.5f, 1.5f);
-                if (star.brightness < 0.1f) star.brightness = 0.1f;
-                if (star.brightness > 1.0f) star.brightness = 1.0f;
-            }
+// Only planets that lost all their rings can be picked up, so this walks
+// the collectable list rather than every planet
+void Galaxy::UpdatePlanets(float spaceshipX, float spaceshipY) {
+    for (size_t i = 0; i < collectablePlanets.size(); ) {
+        Entity entity = collectablePlanets[i];
+        const Transform& transform = entities.transforms.Get(entity);
+        float dx = spaceshipX - transform.x;
+        float dy = spaceshipY - transform.y;
+        float distance = sqrt(dx * dx + dy * dy);
+
+        if (distance < COLLECTION_RADIUS) {
+            // Collect the planet, it stops being drawn
+            entities.planets.Get(entity).collected = true;
+            entities.renderables.Remove(entity);
+
+            // Replenish spaceship health and ammo
+            spaceship->health = Spaceship::INITIAL_HEALTH;
+            spaceship->currentAmmo = Spaceship::MAX_AMMO;
+
+            collectablePlanets[i] = collectablePlanets.back();
+            collectablePlanets.pop_back();
+        }
+        else {
+            i++;
         }
     }
 }
 
-void Galaxy::FireBullet(float spawnX, float spawnY) {
-    // Calculate angle towards spaceship
-    float spaceshipX, spaceshipY, spaceshipZ;
-    spaceship->GetPosition(spaceshipX, spaceshipY, spaceshipZ);
-    float angleToShip = atan2f(spaceshipY - spawnY, spaceshipX - spawnX) * 180.0f / 3.14159f;
+// Ring bullets spawned this tick, added in ring order
+void Galaxy::FlushProjectileSpawns() {
+    projectileSpawns.clear();
+    for (const auto& spawns : sliceSpawns) {
+        projectileSpawns.insert(projectileSpawns.end(), spawns.begin(), spawns.end());
+    }
+    std::sort(projectileSpawns.begin(), projectileSpawns.end(),
+        [](const ProjectileSpawn& a, const ProjectileSpawn& b) { return a.ring < b.ring; });
 
-    bullets.emplace_back(spawnX, spawnY, angleToShip, false);
+    for (const ProjectileSpawn& spawn : projectileSpawns) {
+        bullets.emplace_back(spawn.x, spawn.y, spawn.angle, false);
+    }
 }
 
 float CalculateDistance(float x1, float y1, float x2, float y2) {
@@ -329,219 +700,207 @@ void Normalize(float v[3]) {
     v[2] /= len;
 }
 
-void Galaxy::DrawRings() {
-    for (auto& planet : planets) {
-        for (auto& ring : planet.rings) {
-            if (!ring.isActive) continue;
-
-            glPushMatrix();
-
-            // Move to planet position and apply orbit rotation
-            glTranslatef(planet.x, planet.y, 0.0f);
+// Unit icosphere edges (one subdivision), built once
+static const std::vector<float>& GetShellEdges() {
+    static const std::vector<float> edges = [] {
+        const float X = 0.525731112119133606f;
+        const float Z = 0.850650808352039932f;
+        const float N = 0.0f;
+
+        float vdata[12][3] = {
+            {-X, N, Z}, {X, N, Z}, {-X, N, -Z}, {X, N, -Z},
+            {N, Z, X}, {N, Z, -X}, {N, -Z, X}, {N, -Z, -X},
+            {Z, X, N}, {-Z, X, N}, {Z, -X, N}, {-Z, -X, N}
+        };
+
+        int tindices[20][3] = {
+            {0,4,1}, {0,9,4}, {9,5,4}, {4,5,8}, {4,8,1},
+            {8,10,1}, {8,3,10}, {5,3,8}, {5,2,3}, {2,7,3},
+            {7,10,3}, {7,6,10}, {7,11,6}, {11,0,6}, {0,1,6},
+            {6,1,10}, {9,0,11}, {9,11,2}, {9,2,5}, {7,2,11}
+        };
+
+        std::vector<float> result;
+        auto addEdge = [&result](const float* a, const float* b) {
+            result.insert(result.end(), { a[0], a[1], a[2], b[0], b[1], b[2] });
+        };
+
+        for (int i = 0; i < 20; i++) {
+            // Get triangle vertices
+            const float* v1 = vdata[tindices[i][0]];
+            const float* v2 = vdata[tindices[i][1]];
+            const float* v3 = vdata[tindices[i][2]];
+
+            // Subdivide each triangle into 4
+            float v12[3] = { (v1[0] + v2[0]) / 2, (v1[1] + v2[1]) / 2, (v1[2] + v2[2]) / 2 };
+            float v23[3] = { (v2[0] + v3[0]) / 2, (v2[1] + v3[1]) / 2, (v2[2] + v3[2]) / 2 };
+            float v31[3] = { (v3[0] + v1[0]) / 2, (v3[1] + v1[1]) / 2, (v3[2] + v1[2]) / 2 };
+
+            Normalize(v12);
+            Normalize(v23);
+            Normalize(v31);
+
+            // Original edges
+            addEdge(v1, v2);
+            addEdge(v2, v3);
+            addEdge(v3, v1);
+
+            // Subdivided edges
+            addEdge(v12, v23);
+            addEdge(v23, v31);
+            addEdge(v31, v12);
+        }
+        return result;
+    }();
+    return edges;
+}
 
-            glRotatef(ring.angle, 0.0f, 0.0f, 1.0f);            // Orbit rotation
-            glTranslatef(ring.orbitRadius, 0.0f, 0.0f);         // Move to orbit position
+// Torus wireframe in ring space as line segments, built once
+static const std::vector<float>& GetTorusEdges() {
+    static const std::vector<float> edges = [] {
+        const float ringRadius = 3.0f;        // Major radius (size of the ring)
+        const float tubeRadius = 1.0f;        // Minor radius (thickness of the tube)
+        const int ringSegments = 16;          // Segments around the ring
+        const int tubeSegments = 8;          // Segments around the tube
+
+        std::vector<float> result;
+        for (int i = 0; i < ringSegments; i++) {
+            float phi = i * 2.0f * 3.14159f / ringSegments;
+            float nextPhi = (i + 1) * 2.0f * 3.14159f / ringSegments;
+
+            // Each loop alternates between the current and next circle
+            std::vector<float> loop;
+            for (int j = 0; j < tubeSegments; j++) {
+                float theta = j * 2.0f * 3.14159f / tubeSegments;
+                float radius = ringRadius + tubeRadius * cosf(theta);
+                float z = tubeRadius * sinf(theta);
+                loop.insert(loop.end(), { radius * cosf(phi), radius * sinf(phi), z });
+                loop.insert(loop.end(), { radius * cosf(nextPhi), radius * sinf(nextPhi), z });
+            }
 
-            // Apply ring orientation
-            glRotatef(ring.yawAngle, 1.0f, 1.0f, 0.0f);
+            // Close the loop into line segments
+            int count = (int)loop.size() / 3;
+            for (int k = 0; k < count; k++) {
+                int next = (k + 1) % count;
+                result.insert(result.end(), { loop[k * 3], loop[k * 3 + 1], loop[k * 3 + 2],
+                    loop[next * 3], loop[next * 3 + 1], loop[next * 3 + 2] });
+            }
+        }
+        return result;
+    }();
+    return edges;
+}
 
-            // Finally apply self rotation
-            glRotatef(ring.selfAngle, 0.0f, 1.0f, 0.0f);
+float Galaxy::GetStarKeepFraction(float distance) const {
+    const StarLOD& lod = settings.starLOD;
+    if (!lod.enabled || lod.levels.empty()) return 1.0f;
 
-            // Set red color
-            glColor3f(1.0f, 0.0f, 0.0f);
+    for (const auto& level : lod.levels) {
+        if (distance <= level.distance) return level.keepFraction;
+    }
+    return lod.levels.back().keepFraction;
+}
 
-            // Draw torus (donut shape)
-            const float ringRadius = 3.0f;        // Major radius (size of the ring)
-            const float tubeRadius = 1.0f;        // Minor radius (thickness of the tube)
-            const int ringSegments = 16;          // Segments around the ring
-            const int tubeSegments = 8;          // Segments around the tube
+void Galaxy::BuildStarVertices(const std::vector<PackedStar>& stars, const ChunkKey& key, float keepFraction, RenderList& points) const {
+    int count = (int)ceilf(stars.size() * keepFraction);
+    if (count > (int)stars.size()) count = (int)stars.size();
+
+    // Fewer, brighter stars so distant chunks don't fade out
+    float brightnessScale = settings.starLOD.compensateBrightness && keepFraction > 0.0f ? 1.0f / keepFraction : 1.0f;
+
+    float originX = key.x * settings.chunkSize;
+    float originY = key.y * settings.chunkSize;
+    float originZ = key.z * settings.chunkSize;
+    float positionScale = PackedStar::PositionScale(settings.chunkSize);
+
+    for (int i = 0; i < count; i++) {
+        const PackedStar& star = stars[i];
+        float alpha = star.brightness * brightnessScale;
+        points.Add(originX + star.x * positionScale,
+            originY + star.y * positionScale,
+            originZ + star.z * positionScale,
+            star.GetR8(), star.GetG8(), star.GetB8(), (uint8_t)(alpha < 255.0f ? alpha : 255.0f));
+    }
+}
 
-            // Draw circles around the torus tube
-            for (int i = 0; i < ringSegments; i++) {
-                float phi = i * 2.0f * 3.14159f / ringSegments;
-                float nextPhi = (i + 1) * 2.0f * 3.14159f / ringSegments;
+int Galaxy::GetStarVertexCount() const {
+    int count = 0;
+    for (const auto& lists : sliceLists) {
+        count += lists.stars.GetVertexCount();
+    }
+    return count;
+}
 
-                glBegin(GL_LINE_LOOP);
-                for (int j = 0; j < tubeSegments; j++) {
-                    float theta = j * 2.0f * 3.14159f / tubeSegments;
+void Galaxy::BuildPlanetVertices(Entity entity, const Renderable& renderable, RenderList& lines) const {
+    const Transform& planet = entities.transforms.Get(entity);
 
-                    // Current point
-                    float x = (ringRadius + tubeRadius * cosf(theta)) * cosf(phi);
-                    float y = (ringRadius + tubeRadius * cosf(theta)) * sinf(phi);
-                    float z = tubeRadius * sinf(theta);
-                    glVertex3f(x, y, z);
+    // Central cube
+    float size = PLANET_CUBE_SIZE;
+    float corners[8][3];
+    for (int i = 0; i < 8; i++) {
+        corners[i][0] = planet.x + ((i & 1) ? size : -size);
+        corners[i][1] = planet.y + ((i & 2) ? size : -size);
+        corners[i][2] = ((i & 4) ? size : -size);
+    }
 
-                    // Next point
-                    x = (ringRadius + tubeRadius * cosf(theta)) * cosf(nextPhi);
-                    y = (ringRadius + tubeRadius * cosf(theta)) * sinf(nextPhi);
-                    z = tubeRadius * sinf(theta);
-                    glVertex3f(x, y, z);
-                }
-                glEnd();
-            }
+    static const int cubeEdges[12][2] = {
+        {0, 1}, {2, 3}, {4, 5}, {6, 7},
+        {0, 2}, {1, 3}, {4, 6}, {5, 7},
+        {0, 4}, {1, 5}, {2, 6}, {3, 7}
+    };
+    for (const auto& edge : cubeEdges) {
+        const float* p0 = corners[edge[0]];
+        const float* p1 = corners[edge[1]];
+        lines.AddLine(p0[0], p0[1], p0[2], p1[0], p1[1], p1[2], renderable.r, renderable.g, renderable.b);
+    }
 
-            // Draw square plane in the center of the ring
-            float squareSize = 0.5f; // adjust this value to change the size
-            glPushMatrix();
-            glTranslatef(0.0f, 0.0f, 0.0f); // center of the ring
-            glPolygonMode(GL_FRONT_AND_BACK, GL_FILL); // enable filled polygons
-            glColor3f(1.0f, 0.0f, 0.0f); // red color
-            glBegin(GL_QUADS);
-            glVertex3f(-ringRadius * squareSize, -ringRadius * squareSize, 0.0f);
-            glVertex3f(ringRadius * squareSize, -ringRadius * squareSize, 0.0f);
-            glVertex3f(ringRadius * squareSize, ringRadius * squareSize, 0.0f);
-            glVertex3f(-ringRadius * squareSize, ringRadius * squareSize, 0.0f);
-            glEnd();
-            glPopMatrix();
-
-            glPopMatrix();
+    // Only draw the green sphere if there are active rings
+    if (entities.planets.Get(entity).activeRings > 0) {
+        float sphereRadius = size * 4.0f;
+        const std::vector<float>& shell = GetShellEdges();
+        for (size_t i = 0; i < shell.size(); i += 3) {
+            lines.Add(planet.x + shell[i] * sphereRadius,
+                planet.y + shell[i + 1] * sphereRadius,
+                shell[i + 2] * sphereRadius,
+                0.0f, 1.0f, 0.0f);
         }
     }
 }
 
-void Galaxy::DrawStars()
-{
-    // Draw stars
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-    glDisable(GL_DEPTH_TEST);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE);
-    glEnable(GL_POINT_SMOOTH);
+void Galaxy::BuildRingVertices(Entity entity, const Renderable& renderable, RenderList& lines, RenderList& quads) const {
+    const OrbitArray& orbits = entities.orbits;
+    int ring = orbits.IndexOf(entity);
+    Matrix34 transform = Matrix34::Identity();
 
-    for (const auto& pair : chunks) {
-        const std::vector<Star>& stars = pair.second;
-        glBegin(GL_POINTS);
-        for (const auto& star : stars) {
-            glColor4f(star.r, star.g, star.b, star.brightness);
-            glVertex3f(star.x, star.y, star.z);
-        }
-        glEnd();
+    // Move to planet position and apply orbit rotation
+    transform.Translate(orbits.centerX[ring], orbits.centerY[ring], 0.0f);
+    transform.Rotate(orbits.angle[ring], 0.0f, 0.0f, 1.0f);    // Orbit rotation
+    transform.Translate(orbits.radius[ring], 0.0f, 0.0f);      // Move to orbit position
+
+    // Apply ring orientation
+    transform.Rotate(orbits.yawAngle[ring], 1.0f, 1.0f, 0.0f);
+
+    // Finally apply self rotation
+    transform.Rotate(orbits.selfAngle[ring], 0.0f, 1.0f, 0.0f);
+
+    // Torus
+    const std::vector<float>& torus = GetTorusEdges();
+    float x, y, z;
+    for (size_t i = 0; i < torus.size(); i += 3) {
+        transform.Apply(torus[i], torus[i + 1], torus[i + 2], x, y, z);
+        lines.Add(x, y, z, renderable.r, renderable.g, renderable.b);
     }
-}
 
-void Galaxy::DrawPlanets()
-{
-    for (const auto& planet : planets)
-    {
-        if (planet.isCollected) continue;
-
-        // Draw central cube
-        glPushMatrix();
-        //glRotatef(1.0f * GetTickCount64() / 100.0f, 0.5f, -1.0f, 0.0f);
-        glTranslatef(planet.x, planet.y, 0.0f);
-
-        glDisable(GL_LIGHTING);
-        glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-        glColor4f(1.0f, 0.0f, 1.0f, 1.0f);
-
-        float size = 2.0f;
-        glBegin(GL_QUADS);
-        glVertex3f(-size, -size, size);
-        glVertex3f(size, -size, size);
-        glVertex3f(size, size, size);
-        glVertex3f(-size, size, size);
-
-        glVertex3f(-size, -size, -size);
-        glVertex3f(-size, size, -size);
-        glVertex3f(size, size, -size);
-        glVertex3f(size, -size, -size);
-
-        glVertex3f(-size, size, -size);
-        glVertex3f(-size, size, size);
-        glVertex3f(size, size, size);
-        glVertex3f(size, size, -size);
-
-        glVertex3f(-size, -size, -size);
-        glVertex3f(size, -size, -size);
-        glVertex3f(size, -size, size);
-        glVertex3f(-size, -size, size);
-
-        glVertex3f(size, -size, -size);
-        glVertex3f(size, size, -size);
-        glVertex3f(size, size, size);
-        glVertex3f(size, -size, size);
-
-        glVertex3f(-size, -size, -size);
-        glVertex3f(-size, -size, size);
-        glVertex3f(-size, size, size);
-        glVertex3f(-size, size, -size);
-        glEnd();
-        glPopMatrix();
-
-        // Only draw the green sphere if there are active rings
-        if (planet.HasActiveRings()) {
-
-            // Draw larger triangulated sphere
-            glColor3f(0.0f, 1.0f, 0.0f);  // Green
-            float sphereRadius = size * 4.0f;
-
-            const float X = 0.525731112119133606f;
-            const float Z = 0.850650808352039932f;
-            const float N = 0.0f;
-
-            float vdata[12][3] = {
-                {-X, N, Z}, {X, N, Z}, {-X, N, -Z}, {X, N, -Z},
-                {N, Z, X}, {N, Z, -X}, {N, -Z, X}, {N, -Z, -X},
-                {Z, X, N}, {-Z, X, N}, {Z, -X, N}, {-Z, -X, N}
-            };
-
-            int tindices[20][3] = {
-                {0,4,1}, {0,9,4}, {9,5,4}, {4,5,8}, {4,8,1},
-                {8,10,1}, {8,3,10}, {5,3,8}, {5,2,3}, {2,7,3},
-                {7,10,3}, {7,6,10}, {7,11,6}, {11,0,6}, {0,1,6},
-                {6,1,10}, {9,0,11}, {9,11,2}, {9,2,5}, {7,2,11}
-            };
-
-            glPushMatrix();
-            //glRotatef(2.0f * GetTickCount64() / 100.0f, 0.0f, 1.0f, 0.0f);
-            glTranslatef(planet.x, planet.y, 0.0f);
-            glBegin(GL_LINES);
-
-            for (int i = 0; i < 20; i++) {
-                // Get triangle vertices
-                float v1[3] = { vdata[tindices[i][0]][0], vdata[tindices[i][0]][1], vdata[tindices[i][0]][2] };
-                float v2[3] = { vdata[tindices[i][1]][0], vdata[tindices[i][1]][1], vdata[tindices[i][1]][2] };
-                float v3[3] = { vdata[tindices[i][2]][0], vdata[tindices[i][2]][1], vdata[tindices[i][2]][2] };
-
-                // Subdivide each triangle into 4
-                float v12[3] = { (v1[0] + v2[0]) / 2, (v1[1] + v2[1]) / 2, (v1[2] + v2[2]) / 2 };
-                float v23[3] = { (v2[0] + v3[0]) / 2, (v2[1] + v3[1]) / 2, (v2[2] + v3[2]) / 2 };
-                float v31[3] = { (v3[0] + v1[0]) / 2, (v3[1] + v1[1]) / 2, (v3[2] + v1[2]) / 2 };
-
-                Normalize(v12);
-                Normalize(v23);
-                Normalize(v31);
-
-                // Draw original edges
-                glVertex3f(v1[0] * sphereRadius, v1[1] * sphereRadius, v1[2] * sphereRadius);
-                glVertex3f(v2[0] * sphereRadius, v2[1] * sphereRadius, v2[2] * sphereRadius);
-
-                glVertex3f(v2[0] * sphereRadius, v2[1] * sphereRadius, v2[2] * sphereRadius);
-                glVertex3f(v3[0] * sphereRadius, v3[1] * sphereRadius, v3[2] * sphereRadius);
-
-                glVertex3f(v3[0] * sphereRadius, v3[1] * sphereRadius, v3[2] * sphereRadius);
-                glVertex3f(v1[0] * sphereRadius, v1[1] * sphereRadius, v1[2] * sphereRadius);
-
-                // Draw subdivided edges
-                glVertex3f(v12[0] * sphereRadius, v12[1] * sphereRadius, v12[2] * sphereRadius);
-                glVertex3f(v23[0] * sphereRadius, v23[1] * sphereRadius, v23[2] * sphereRadius);
-
-                glVertex3f(v23[0] * sphereRadius, v23[1] * sphereRadius, v23[2] * sphereRadius);
-                glVertex3f(v31[0] * sphereRadius, v31[1] * sphereRadius, v31[2] * sphereRadius);
-
-                glVertex3f(v31[0] * sphereRadius, v31[1] * sphereRadius, v31[2] * sphereRadius);
-                glVertex3f(v12[0] * sphereRadius, v12[1] * sphereRadius, v12[2] * sphereRadius);
-            }
-            glEnd();
-            glPopMatrix();
-        }
+    // Filled square plane in the center of the ring
+    const float half = 3.0f * 0.5f;
+    const float square[4][2] = { {-half, -half}, {half, -half}, {half, half}, {-half, half} };
+    for (const auto& corner : square) {
+        transform.Apply(corner[0], corner[1], 0.0f, x, y, z);
+        quads.Add(x, y, z, renderable.r, renderable.g, renderable.b);
     }
 }
 
-Galaxy::ScreenPosition Galaxy::GetPlanetScreenPosition(const Planet& planet, const Camera& camera) {
-    ScreenPosition result;
-
+void Galaxy::GetScreenProjection(const Camera& camera, ScreenProjection& projection) {
     // Save current matrices
     glMatrixMode(GL_MODELVIEW);
     glPushMatrix();
@@ -568,21 +927,32 @@ Galaxy::ScreenPosition Galaxy::GetPlanetScreenPosition(const Planet& planet, con
     glTranslatef(-camX, -camY, -camZ);
 
     // Get matrices
-    GLdouble modelview[16];
-    GLdouble projection[16];
-    GLint viewport[4];
-    glGetDoublev(GL_MODELVIEW_MATRIX, modelview);
-    glGetDoublev(GL_PROJECTION_MATRIX, projection);
-    glGetIntegerv(GL_VIEWPORT, viewport);
+    glGetDoublev(GL_MODELVIEW_MATRIX, projection.modelview);
+    glGetDoublev(GL_PROJECTION_MATRIX, projection.projection);
+    const Viewport& viewport = Viewport::GetInstance();
+    projection.viewport[0] = viewport.GetX();
+    projection.viewport[1] = viewport.GetY();
+    projection.viewport[2] = viewport.GetWidth();
+    projection.viewport[3] = viewport.GetHeight();
+
+    // Restore matrices
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+    glPopMatrix();
+}
+
+Galaxy::ScreenPosition Galaxy::GetPlanetScreenPosition(const Transform& planet, const ScreenProjection& projection) {
+    ScreenPosition result;
+    const GLint* viewport = projection.viewport;
 
     GLdouble screenX, screenY, screenZ;
     gluProject(planet.x, planet.y, planet.z,
-        modelview, projection, viewport,
+        projection.modelview, projection.projection, viewport,
         &screenX, &screenY, &screenZ);
 
-    // Convert to virtual coordinates
-    result.screenX = (screenX * APP_VIRTUAL_WIDTH) / viewport[2];
-    result.screenY = ((viewport[3] - screenY) * APP_VIRTUAL_HEIGHT) / viewport[3];
+    // Convert to virtual coordinates, taking the letterbox offset off
+    Viewport::GetInstance().GLToVirtual((float)screenX, (float)screenY, result.screenX, result.screenY);
 
     // Smaller margin and stricter bounds check
     float margin = 10.0f;  // Reduced margin
@@ -598,26 +968,16 @@ Galaxy::ScreenPosition Galaxy::GetPlanetScreenPosition(const Planet& planet, con
     //    result.isOnScreen,
     //    screenZ);
 
-    // Restore matrices
-    glMatrixMode(GL_PROJECTION);
-    glPopMatrix();
-    glMatrixMode(GL_MODELVIEW);
-    glPopMatrix();
-
     return result;
 }
 
-void Galaxy::RenderDirectionArrows() {
+void Galaxy::RenderDirectionArrows(RenderQueue& queue) {
     Camera& camera = renderer->GetCamera();
 
-    // Save current matrices and set up 2D rendering
-    glPushMatrix();
-    glMatrixMode(GL_PROJECTION);
-    glPushMatrix();
-    glLoadIdentity();
-    glOrtho(0, APP_VIRTUAL_WIDTH, APP_VIRTUAL_HEIGHT, 0, -1, 1);
-    glMatrixMode(GL_MODELVIEW);
-    glLoadIdentity();
+    RenderState state;
+    state.pass = RenderPass::Overlay;
+    state.depthTest = false;
+    state.lineWidth = 2.0f;
 
     // Get camera info
     float camX, camY, camZ;
@@ -630,10 +990,15 @@ void Galaxy::RenderDirectionArrows() {
     float screenHeight = APP_VIRTUAL_HEIGHT;
     float padding = 20.0f; // Padding from screen edge
 
-    for (const auto& planet : planets) {
-        if (planet.isCollected) continue;
+    // The matrices are the same for every planet, read them back once
+    ScreenProjection projection;
+    GetScreenProjection(camera, projection);
+
+    for (int i = 0; i < entities.planets.Size(); i++) {
+        if (entities.planets[i].collected) continue;
 
-        ScreenPosition pos = GetPlanetScreenPosition(planet, camera);
+        const Transform& planet = entities.transforms.Get(entities.planets.EntityAt(i));
+        ScreenPosition pos = GetPlanetScreenPosition(planet, projection);
 
         if (!pos.isOnScreen) {
             // Calculate direction to planet in world space
@@ -669,60 +1034,130 @@ void Galaxy::RenderDirectionArrows() {
                 rotation = (dy > 0) ? 90 : 270;
             }
 
-            // Draw arrow
-            glDisable(GL_LIGHTING);
-            glPushMatrix();
-            glTranslatef(arrowX, arrowY, 0);
-            glRotatef(rotation, 0, 0, 1);
-
-            glColor3f(1.0f, 1.0f, 1.0f);
-            glLineWidth(2.0f);
-
-            // Draw arrow shape
-            glBegin(GL_LINE_LOOP);
-            glVertex2f(-10, -5);
-            glVertex2f(10, 0);
-            glVertex2f(-10, 5);
-            glEnd();
-
-            glEnable(GL_LIGHTING);
-            glPopMatrix();
+            RenderCommand& cmd = queue.Submit(state, MeshId::Arrow, &Galaxy::DrawArrow, arrowX, arrowY, 0.0f);
+            cmd.angle = rotation;
         }
     }
-
-    // Restore states
-    glLineWidth(1.0f);
-    glMatrixMode(GL_PROJECTION);
-    glPopMatrix();
-    glMatrixMode(GL_MODELVIEW);
-    glPopMatrix();
-
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_LIGHTING);
 }
 
-void Galaxy::Render() {
+void Galaxy::DrawArrow(const RenderCommand& cmd, GLStateCache& gl) {
     glPushMatrix();
-    glPushAttrib(GL_ALL_ATTRIB_BITS);
+    glTranslatef(cmd.x, cmd.y, 0);
+    glRotatef(cmd.angle, 0, 0, 1);
 
-    //Draw planets and stars
-    DrawStars();
-    DrawPlanets();
-    DrawRings();
+    // Draw arrow shape
+    glBegin(GL_LINE_LOOP);
+    glVertex2f(-10, -5);
+    glVertex2f(10, 0);
+    glVertex2f(-10, 5);
+    glEnd();
 
-    glPopAttrib();
     glPopMatrix();
+}
 
-    // Render explosions
-    for (auto& explosion : explosions) {
-        explosion.Render();
+void Galaxy::Render(RenderQueue& queue) {
+    JobSystem& jobs = JobSystem::GetInstance();
+
+    // Build render lists in parallel, each slice writes to its own buffers
+    sliceLists.resize(jobs.GetSliceCount());
+    for (auto& lists : sliceLists) {
+        lists.Clear();
     }
 
-    // Render bullets
-    for (auto& bullet : bullets) {
-        bullet.Render(false);
+    float camX, camY, camZ;
+    renderer->GetCamera().GetPosition(camX, camY, camZ);
+
+    FrameVector<VisibleChunk> chunkList;
+    chunkList.reserve(chunks.size());
+    float halfChunk = settings.chunkSize * 0.5f;
+    for (const auto& pair : chunks) {
+        const ChunkKey& key = pair.first;
+        float dx = key.x * settings.chunkSize + halfChunk - camX;
+        float dy = key.y * settings.chunkSize + halfChunk - camY;
+        float dz = key.z * settings.chunkSize + halfChunk - camZ;
+        float distance = sqrtf(dx * dx + dy * dy + dz * dz);
+
+        chunkList.push_back({ &pair.second, key, GetStarKeepFraction(distance) });
+    }
+
+    auto starStart = std::chrono::steady_clock::now();
+    jobs.ParallelFor((int)chunkList.size(), [this, &chunkList](int begin, int end, int slice) {
+        for (int i = begin; i < end; i++) {
+            BuildStarVertices(*chunkList[i].stars, chunkList[i].key, chunkList[i].keepFraction, sliceLists[slice].stars);
+        }
+    });
+    starBuildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - starStart).count();
+
+    auto buildStart = std::chrono::steady_clock::now();
+    jobs.ParallelFor(entities.renderables.Size(), [this](int begin, int end, int slice) {
+        SliceLists& lists = sliceLists[slice];
+        for (int i = begin; i < end; i++) {
+            Entity entity = entities.renderables.EntityAt(i);
+            const Renderable& renderable = entities.renderables[i];
+            if (renderable.mesh == MeshId::PlanetCube) {
+                BuildPlanetVertices(entity, renderable, lists.planetLines);
+            }
+            else if (renderable.mesh == MeshId::Ring) {
+                BuildRingVertices(entity, renderable, lists.ringLines, lists.ringQuads);
+            }
+        }
+    });
+    renderBuildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - buildStart).count();
+
+    jobs.ParallelFor((int)explosions.size(), [this](int begin, int end, int slice) {
+        for (int i = begin; i < end; i++) {
+            explosions[i].BuildVertices(sliceLists[slice].explosionLines);
+        }
+    });
+
+    jobs.ParallelFor((int)bullets.size(), [this](int begin, int end, int slice) {
+        for (int i = begin; i < end; i++) {
+            bullets[i].BuildVertices(sliceLists[slice].bulletLines, false);
+        }
+    });
+
+    // Only the submission happens on the GL thread
+    RenderState starState;
+    starState.pass = RenderPass::Background;
+    starState.blend = BlendMode::Additive;
+    starState.depthTest = false;
+    starState.lighting = true;
+    starState.pointSmooth = true;
+
+    RenderState planetState;
+    planetState.pass = RenderPass::Background;
+    planetState.blend = BlendMode::Additive;
+    planetState.depthTest = false;
+    planetState.wireframe = true;
+
+    RenderState ringState = planetState;
+    ringState.wireframe = false;
+
+    RenderState explosionState;
+    explosionState.pass = RenderPass::Transparent;
+    explosionState.blend = BlendMode::Alpha;
+    explosionState.lineWidth = 2.0f;
+
+    RenderState bulletState;
+    bulletState.pass = RenderPass::Opaque;
+    bulletState.wireframe = true;
+
+    for (const auto& lists : sliceLists) {
+        SubmitList(queue, starState, MeshId::Stars, lists.stars);
+        SubmitList(queue, planetState, MeshId::PlanetCube, lists.planetLines);
+        SubmitList(queue, ringState, MeshId::Ring, lists.ringLines);
+        SubmitList(queue, ringState, MeshId::Ring, lists.ringQuads);
+        SubmitList(queue, explosionState, MeshId::Explosion, lists.explosionLines);
+        SubmitList(queue, bulletState, MeshId::Bullet, lists.bulletLines);
     }
 
     // Render direction arrows for off-screen planets
-    RenderDirectionArrows();
-}
\ No newline at end of file
+    RenderDirectionArrows(queue);
+}
+
+void Galaxy::SubmitList(RenderQueue& queue, const RenderState& state, MeshId mesh, const RenderList& list) {
+    if (list.IsEmpty()) return;
+
+    RenderCommand& cmd = queue.Submit(state, mesh, &RenderList::Draw, 0.0f, 0.0f, 0.0f);
+    cmd.object = &list;
+}
@@ -3,97 +3,204 @@
 
 #include <vector>
 #include <map>
+#include <list>
+#include <string>
+#include <random>
+#include <float.h>
 #include "Renderer3D.h"
+#include "RenderList.h"
+#include "Star.h"
+#include "StarCatalogue.h"
+#include "FrameArena.h"
+#include "EntityStore.h"
 #include <Spaceship.h>
 #include <UISystem.h>
 #include <ExplosionEffect.h>
 
-struct Star {
-    float x, y, z;
-    float brightness;
-    float size;
-    float r, g, b;
+// Distant chunks only draw a prefix of their stars. Each star is placed
+// uniformly and independently of the others, so a prefix is an unbiased
+// random subset of the chunk.
+struct StarLODLevel {
+    float distance;       // Applies to chunks up to this far from the camera
+    float keepFraction;   // Share of the chunk's stars that are drawn
 };
 
-struct ChunkKey {
-    int x, y, z;
-    bool operator<(const ChunkKey& other) const {
-        if (x != other.x) return x < other.x;
-        if (y != other.y) return y < other.y;
-        return z < other.z;
-    }
-};
+struct StarLOD {
+    bool enabled = true;
+    bool compensateBrightness = true;   // Keep the chunk's total light roughly constant
 
-struct Ring {
-    static const int INITIAL_HEALTH = 10;
-
-    float x, y;           // Position relative to planet
-    float angle;          // Current orbit angle around planet
-    float selfAngle;      // Ring's rotation around itself
-    float yawAngle;       // Horizontal rotation to face target
-    float pitchAngle;     // Vertical rotation to face target
-    float orbitRadius;    // Distance from planet
-    float rotationSpeed;  // Orbit rotation speed
-    float selfRotationSpeed;  // Speed of rotation around itself
-    int health = INITIAL_HEALTH;           // Add health for rings
-    bool isActive = true;       // To track if ring is destroyed
-
-    void TakeDamage(int amount) {
-        health -= amount;
-        if (health <= 0) {
-            health = 0;
-            isActive = false;
-        }
-    }
+    // Sorted by distance, the last level covers everything beyond it
+    std::vector<StarLODLevel> levels = {
+        { 200.0f, 1.0f },
+        { 400.0f, 0.5f },
+        { 600.0f, 0.25f },
+        { FLT_MAX, 0.125f }
+    };
 
-    int GetHealth() const { return health; }
-    bool IsAlive() const { return health > 0; }
+    // Overrides from the [StarLOD] section of an ini file. Any LevelN key
+    // replaces the whole level list.
+    void LoadFromFile(const char* path);
 };
 
-struct Planet {
-    float x, y, z;
-    std::vector<Ring> rings;  // Multiple rings per planet
-    float orbitRadius;
+// Star streaming settings. Loaded star memory grows as
+// (2 * renderDistance + 1)^3 * starsPerChunk * sizeof(PackedStar), the budget caps it
+// by dropping the farthest chunks first.
+struct GalaxySettings {
+    int renderDistance = 5;        // Chunks loaded in each direction around the camera's chunk
+    float chunkSize = 100.0f;
+    int starsPerChunk = 200;
+    float starBudgetMB = 32.0f;    // 0 means no budget
+    float chunkCacheMB = 8.0f;     // Recently evicted chunks kept for reuse, 0 disables the cache
+    std::string cataloguePath;     // Baked star catalogue, chunks outside it are still generated
+    StarLOD starLOD;
+    // Overrides from the [Galaxy] and [StarLOD] sections of an ini file,
+    // missing keys keep their value
+    void LoadFromFile(const char* path);
+};
 
-    bool isCollectable = false;  // Becomes true when all rings are destroyed
-    bool isCollected = false;    // Becomes true when picked up by spaceship
+struct ChunkStats {
+    int loadedChunks = 0;
+    int loadedStars = 0;
+    size_t loadedBytes = 0;
+    size_t budgetBytes = 0;
+    int chunksOverBudget = 0;      // Chunks in render distance left unloaded by the budget
 
-    bool HasActiveRings() const {
-        for (const auto& ring : rings) {
-            if (ring.isActive) return true;
-        }
-        return false;
-    }
+    int cachedChunks = 0;
+    size_t cachedBytes = 0;
+    int cacheHits = 0;             // Chunks reloaded from the cache instead of generated
+    int cacheMisses = 0;           // Chunks that had to be generated or read from the catalogue
 
-    static constexpr float COLLECTION_RADIUS = 5.0f;  // Distance at which player can collect the cube
+    int generatedChunks = 0;
+    int catalogueChunks = 0;
+    double generateMs = 0.0;       // Total time spent generating chunks
+    double catalogueMs = 0.0;      // Total time spent reading chunks from the catalogue
 };
 
 class Galaxy {
 public:
-    Galaxy(Renderer3D* renderer, int starsPerChunk = 200, int numPlanets = 10);
-    void DrawStars();
-    void DrawPlanets();
-    void DrawRings();
-    void Render();
+    Galaxy(Renderer3D* renderer, const GalaxySettings& settings = GalaxySettings(), int numPlanets = 10);
+    void Render(RenderQueue& queue);
     void Update(float deltaTime, const Camera& camera);
-    void FireBullet(float spawnX, float spawnY);
+
+    // Bullets, rings and planets for one tick of deltaTime seconds. Update
+    // calls it with the measured frame time, benchmarks with a fixed one.
+    void UpdateEntities(float deltaTime);
+
+    // Hash of the ring state and weapon cooldowns, the same run gives the same
+    // value on any thread count. Bullets are left out, they expire on wall
+    // clock time.
+    uint32_t GetEntityChecksum() const;
     void SetSpaceship(Spaceship* ship) { spaceship = ship; }
 
+    StarLOD& GetStarLOD() { return settings.starLOD; }
+    int GetStarVertexCount() const;
+
+    // Changing chunk size or stars per chunk regenerates every chunk
+    void SetSettings(const GalaxySettings& newSettings);
+    const GalaxySettings& GetSettings() const { return settings; }
+    const ChunkStats& GetChunkStats() const { return chunkStats; }
+
+    // Serves chunks from a baked catalogue instead of generating them. The
+    // catalogue's chunk size replaces the configured one.
+    bool LoadCatalogue(const char* path);
+    bool IsCatalogueLoaded() const { return catalogue.IsOpen(); }
+
+    // Generates every chunk within radius of center and writes them to path
+    bool BakeCatalogue(const char* path, const ChunkKey& center, int radius);
+    ChunkKey GetChunkFromPosition(float x, float y, float z);
+
+    int GetPlanetCount() const { return entities.planets.Size(); }
+    int GetRingCount() const { return entities.orbits.Size(); }
+    double GetEntityUpdateMs() const { return entityUpdateMs; }
+    double GetRenderBuildMs() const { return renderBuildMs; }
+    double GetStarBuildMs() const { return starBuildMs; }
+
+    // Runs the scalar orbit update instead of the SIMD kernel, to compare them
+    void SetReferenceOrbits(bool enable) { useReferenceOrbits = enable; }
+    bool IsUsingReferenceOrbits() const { return useReferenceOrbits; }
+    double GetOrbitKernelMs() const { return orbitKernelMs; }
+
 private:
     std::vector<Bullet> bullets;
 
-    std::map<ChunkKey, std::vector<Star>> chunks;
-    int starsPerChunk;
-    float chunkSize;
+    std::map<ChunkKey, std::vector<PackedStar>> chunks;
+    GalaxySettings settings;
+    ChunkStats chunkStats;
+
+    // Chunks that should be loaded, nearest first. Only rebuilt when the
+    // camera changes chunk or the settings change.
+    std::vector<ChunkKey> wantedChunks;
+    ChunkKey wantedCenter = { 0, 0, 0 };
+    bool wantedDirty = true;
+
+    // Evicted chunks, most recently evicted at the front of the LRU list
+    struct CachedChunk {
+        std::vector<PackedStar> stars;
+        std::list<ChunkKey>::iterator lruPosition;
+    };
+    std::map<ChunkKey, CachedChunk> chunkCache;
+    std::list<ChunkKey> chunkCacheLRU;
+    size_t chunkCacheBytes = 0;
+
+    StarCatalogue catalogue;
     Renderer3D* renderer;
-    Spaceship* spaceship;
+    Spaceship* spaceship = nullptr;
     int numPlanets;
-    std::vector<Planet> planets;
+
+    // Planets are entities with a transform and a PlanetInfo, rings orbit
+    // them and carry health and a weapon
+    EntityStore entities;
+    std::vector<Entity> collectablePlanets;   // Lost all their rings, not picked up yet
+    double entityUpdateMs = 0.0;
+    double renderBuildMs = 0.0;
+    double starBuildMs = 0.0;
+    double orbitKernelMs = 0.0;    // Parallel part of UpdateRings
+
+    // Ship bullet hits found by the parallel ring update, one list per job slice
+    struct RingHit {
+        int ring;       // Index into entities.orbits
+        int bullet;     // Index into the spaceship's bullets
+    };
+    std::vector<std::vector<RingHit>> sliceRingHits;
+
+    // Ring bullets to add at the end of the ring update
+    struct ProjectileSpawn {
+        int ring;       // Index into entities.orbits, orders the spawns
+        float x, y;
+        float angle;    // Degrees, towards the ship
+    };
+    std::vector<std::vector<ProjectileSpawn>> sliceSpawns;
+    std::vector<ProjectileSpawn> projectileSpawns;
+    void FlushProjectileSpawns();
+    static const int RING_BATCH_SIZE = 1024;
+    bool useReferenceOrbits = false;
 
     void CreateChunk(const ChunkKey& key);
-    void CreateStar(Star& star, const ChunkKey& chunk);
-    ChunkKey GetChunkFromPosition(float x, float y, float z);
+    // Each chunk draws its stars from its own generator, seeded from the
+    // chunk key, so the global rand() sequence is left alone
+    struct ChunkRandom {
+        std::minstd_rand engine;
+
+        explicit ChunkRandom(const ChunkKey& chunk);
+        float Next();
+        float Range(float min, float max) { return min + Next() * (max - min); }
+    };
+
+    void CreateStar(Star& star, const ChunkKey& chunk, ChunkRandom& random);
+    void GenerateStars(const ChunkKey& key, std::vector<PackedStar>& stars);
     void UpdateVisibleChunks(const Camera& camera);
+    void UpdateChunkStats();
+    void LoadChunk(const ChunkKey& key);
+    void EvictChunk(std::map<ChunkKey, std::vector<PackedStar>>::iterator chunk);
+    void TrimChunkCache(size_t budgetBytes);
+    void SpawnPlanets(int count);
+    void UpdateRings(float spaceshipX, float spaceshipY);
+    void UpdatePlanets(float spaceshipX, float spaceshipY);
+
+    // Returns true if this destroyed the ring. The ring entity itself is
+    // destroyed by the caller once it's done iterating.
+    bool DamageRing(Entity ring, int amount);
+    void OnPlanetCollectable(Entity planet);
     float Random() { return (float)rand() / RAND_MAX; }
     float RandomRange(float min, float max) { return min + Random() * (max - min); }
 
@@ -103,7 +210,9 @@ private:
 
     const float FIRE_RATE = 0.1f;
 
-    float fireTimer = 0.0f;
+    static constexpr float PLANET_CUBE_SIZE = 2.0f;
+    static constexpr float COLLECTION_RADIUS = 5.0f;  // Distance at which player can collect the cube
+    static const int RING_HEALTH = 10;
 
     float previousTime = 0.0f;
     float deltaTime = 0.0f;
@@ -114,8 +223,49 @@ private:
         float angle;
     };
 
-    ScreenPosition GetPlanetScreenPosition(const Planet& planet, const Camera& camera);
-    void RenderDirectionArrows();
+    struct ScreenProjection {
+        GLdouble modelview[16];
+        GLdouble projection[16];
+        GLint viewport[4];
+    };
+
+    static void GetScreenProjection(const Camera& camera, ScreenProjection& projection);
+    static ScreenPosition GetPlanetScreenPosition(const Transform& planet, const ScreenProjection& projection);
+    void RenderDirectionArrows(RenderQueue& queue);
+
+    static void DrawArrow(const RenderCommand& cmd, GLStateCache& gl);
+
+    // Render list building, safe to run on any thread
+    void BuildStarVertices(const std::vector<PackedStar>& stars, const ChunkKey& key, float keepFraction, RenderList& points) const;
+    float GetStarKeepFraction(float distance) const;
+    void BuildPlanetVertices(Entity entity, const Renderable& renderable, RenderList& lines) const;
+    void BuildRingVertices(Entity entity, const Renderable& renderable, RenderList& lines, RenderList& quads) const;
+    static void SubmitList(RenderQueue& queue, const RenderState& state, MeshId mesh, const RenderList& list);
+
+    // One set of render lists per job system slice
+    struct SliceLists {
+        RenderList stars{ GL_POINTS };
+        RenderList planetLines{ GL_LINES };
+        RenderList ringLines{ GL_LINES };
+        RenderList ringQuads{ GL_QUADS };
+        RenderList explosionLines{ GL_LINES };
+        RenderList bulletLines{ GL_LINES };
+
+        void Clear() {
+            stars.Clear();
+            planetLines.Clear();
+            ringLines.Clear();
+            ringQuads.Clear();
+            explosionLines.Clear();
+            bulletLines.Clear();
+        }
+    };
+    std::vector<SliceLists> sliceLists;
+    struct VisibleChunk {
+        const std::vector<PackedStar>* stars;
+        ChunkKey key;
+        float keepFraction;
+    };
 
     std::vector<ExplosionEffect> explosions;  // Store active explosions
 };
@@ -0,0 +1,209 @@
+//------------------------------------------------------------------------
+// GalaxyBenchmark.cpp
+//------------------------------------------------------------------------
+#include "stdafx.h"
+#include "GalaxyBenchmark.h"
+#include "Galaxy.h"
+#include "JobSystem.h"
+#include "FrameArena.h"
+#include "OrbitKernel.h"
+#include <Spaceship.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <float.h>
+#include <algorithm>
+#include <chrono>
+#include <windows.h>
+
+static int planetCount = 10000;
+static int tickCount = 300;
+static int maxThreads = 16;
+
+static const int WARMUP_TICKS = 10;
+static const float TICK_SECONDS = 1.0f / 60.0f;
+static const unsigned int SEED = 1234;
+
+// Kernel comparison, on the same number of rings as the galaxy
+static const int KERNEL_TICKS = 600;
+static const float KERNEL_SPAWN_RANGE = 3000.0f;
+static const float KERNEL_INFLUENCE_RADIUS = 30.0f;   // Same as Galaxy's
+
+void GalaxyBenchmark::ConfigureFromEnvironment() {
+    planetCount = HeadlessRun::GetInt("GAMETEST_BENCH_PLANETS", planetCount);
+    tickCount = HeadlessRun::GetInt("GAMETEST_BENCH_TICKS", tickCount);
+    maxThreads = HeadlessRun::GetInt("GAMETEST_BENCH_THREADS", maxThreads);
+    if (tickCount < 1) tickCount = 1;
+    if (maxThreads < 1) maxThreads = 1;
+}
+
+struct BenchmarkResult {
+    int threads;
+    double updateMs;    // Average Galaxy::UpdateEntities time per tick
+    double ringsMs;     // Average parallel ring update time per tick
+    uint32_t checksum;
+};
+
+static BenchmarkResult RunWithThreads(Renderer3D* renderer, int threads, int& ringCount) {
+    JobSystem& jobs = JobSystem::GetInstance();
+    jobs.Shutdown();
+    jobs.Initialize(threads - 1);
+
+    // Same layout every time
+    srand(SEED);
+    Galaxy galaxy(renderer, GalaxySettings(), planetCount);
+    Spaceship ship;
+    ship.SetPosition(0.0f, 0.0f, 0.0f);
+    galaxy.SetSpaceship(&ship);
+    ringCount = galaxy.GetRingCount();
+
+    BenchmarkResult result = { threads, 0.0, 0.0, 0 };
+    for (int tick = 0; tick < WARMUP_TICKS + tickCount; tick++) {
+        FrameArena::GetInstance().Reset();
+
+        auto start = std::chrono::steady_clock::now();
+        galaxy.UpdateEntities(TICK_SECONDS);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        if (tick >= WARMUP_TICKS) {
+            result.updateMs += ms;
+            result.ringsMs += galaxy.GetOrbitKernelMs();
+        }
+    }
+    result.updateMs /= tickCount;
+    result.ringsMs /= tickCount;
+    result.checksum = galaxy.GetEntityChecksum();
+    return result;
+}
+
+struct KernelResult {
+    double simdMs;              // Whole array per tick, one thread
+    double referenceMs;
+    double maxPositionError;
+    double maxErrorRatio;       // Worst error over its ring's tolerance
+    int engagedMismatches;      // Ticks where the two engaged different rings
+};
+
+static float RandomRange(float min, float max) {
+    return min + (float)rand() / RAND_MAX * (max - min);
+}
+
+// Runs OrbitKernel::Update and UpdateReference side by side. Every tick
+// starts both from the reference state, so the errors don't compound and
+// each one is a single step's difference. A ring's position may differ by
+// twice MAX_SINCOS_ERROR times its radius, the kernel's error plus the
+// reference's own, plus float rounding of its world coordinates.
+static KernelResult CompareKernels(int ringCount) {
+    srand(SEED);
+    OrbitArray simd;
+    simd.Reserve(ringCount);
+    for (int i = 0; i < ringCount; i++) {
+        Transform center = { RandomRange(-KERNEL_SPAWN_RANGE, KERNEL_SPAWN_RANGE),
+            RandomRange(-KERNEL_SPAWN_RANGE, KERNEL_SPAWN_RANGE), 0.0f };
+        Orbit orbit = { 0, RandomRange(0.0f, 360.0f), RandomRange(15.0f, 25.0f), 10.0f,
+            0.0f, RandomRange(5.0f, 15.0f), 0.0f };
+        simd.Add((Entity)i, orbit, center);
+    }
+    OrbitArray reference = simd;
+
+    std::vector<int> simdEngaged(ringCount), referenceEngaged(ringCount);
+    OrbitUpdateParams params = { TICK_SECONDS, 0.0f, 0.0f, KERNEL_INFLUENCE_RADIUS };
+
+    KernelResult result = { 0.0, 0.0, 0.0, 0.0, 0 };
+    for (int tick = 0; tick < KERNEL_TICKS; tick++) {
+        // Park the target on a different ring each tick so engagement is exercised
+        int target = (int)((long long)tick * 7919 % ringCount);
+        params.targetX = reference.centerX[target];
+        params.targetY = reference.centerY[target];
+
+        simd.angle = reference.angle;
+        simd.selfAngle = reference.selfAngle;
+        int simdCount = OrbitKernel::Update(simd, 0, ringCount, params, simdEngaged.data());
+        int referenceCount = OrbitKernel::UpdateReference(reference, 0, ringCount, params, referenceEngaged.data());
+
+        if (simdCount != referenceCount ||
+            !std::equal(simdEngaged.begin(), simdEngaged.begin() + simdCount, referenceEngaged.begin())) {
+            result.engagedMismatches++;
+        }
+
+        for (int i = 0; i < ringCount; i++) {
+            double error = std::max(fabs((double)simd.x[i] - reference.x[i]), fabs((double)simd.y[i] - reference.y[i]));
+            double extent = std::max(fabsf(reference.centerX[i]), fabsf(reference.centerY[i])) + reference.radius[i];
+            double tolerance = 2.0 * OrbitKernel::MAX_SINCOS_ERROR * reference.radius[i] + 4.0 * FLT_EPSILON * extent;
+            result.maxPositionError = std::max(result.maxPositionError, error);
+            result.maxErrorRatio = std::max(result.maxErrorRatio, error / tolerance);
+        }
+    }
+
+    // Timed separately, without the copies and checks
+    params.influenceRadius = 0.0f;
+    auto start = std::chrono::steady_clock::now();
+    for (int tick = 0; tick < tickCount; tick++) {
+        OrbitKernel::Update(simd, 0, ringCount, params, simdEngaged.data());
+    }
+    result.simdMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / tickCount;
+
+    start = std::chrono::steady_clock::now();
+    for (int tick = 0; tick < tickCount; tick++) {
+        OrbitKernel::UpdateReference(reference, 0, ringCount, params, referenceEngaged.data());
+    }
+    result.referenceMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / tickCount;
+    return result;
+}
+
+bool GalaxyBenchmark::Run(const char* reportPath, const HeadlessRun::Context& context) {
+    Renderer3D* renderer = context.renderer;
+
+    std::vector<BenchmarkResult> results;
+    int ringCount = 0;
+    for (int threads = 1; ; threads *= 2) {
+        if (threads > maxThreads) threads = maxThreads;
+        results.push_back(RunWithThreads(renderer, threads, ringCount));
+        if (threads == maxThreads) break;
+    }
+
+    JobSystem::GetInstance().Shutdown();
+    JobSystem::GetInstance().Initialize();
+
+    KernelResult kernel = CompareKernels(ringCount);
+    bool withinTolerance = kernel.maxErrorRatio <= 1.0;
+
+    FILE* out = HeadlessRun::OpenReport(reportPath);
+    if (!out) return false;
+
+    bool deterministic = true;
+    for (const BenchmarkResult& result : results) {
+        deterministic = deterministic && result.checksum == results[0].checksum;
+    }
+
+    fprintf(out, "planets=%d\n", planetCount);
+    fprintf(out, "rings=%d\n", ringCount);
+    fprintf(out, "ticks=%d\n", tickCount);
+    fprintf(out, "hardware_threads=%u\n", std::thread::hardware_concurrency());
+    fprintf(out, "deterministic=%s\n", deterministic ? "yes" : "no");
+
+    fprintf(out, "\n%-8s %12s %12s %12s %10s %11s\n", "threads", "update ms", "rings ms", "rings/ms", "speedup", "checksum");
+    for (const BenchmarkResult& result : results) {
+        fprintf(out, "%-8d %12.3f %12.3f %12.0f %10.2f   %08x\n",
+            result.threads, result.updateMs, result.ringsMs,
+            result.ringsMs > 0.0 ? ringCount / result.ringsMs : 0.0,
+            result.updateMs > 0.0 ? results[0].updateMs / result.updateMs : 0.0,
+            result.checksum);
+    }
+
+    // SIMD kernel against the sinf/cosf reference, one thread, no hit tests
+    fprintf(out, "\nkernel_ticks_compared=%d\n", KERNEL_TICKS);
+    fprintf(out, "kernel_max_position_error=%.6g\n", kernel.maxPositionError);
+    fprintf(out, "kernel_max_error_over_tolerance=%.3f\n", kernel.maxErrorRatio);
+    fprintf(out, "kernel_engaged_mismatches=%d\n", kernel.engagedMismatches);
+    fprintf(out, "kernel_within_tolerance=%s\n", withinTolerance ? "yes" : "no");
+
+    fprintf(out, "\n%-10s %12s %12s %10s\n", "kernel", "ms", "rings/ms", "speedup");
+    fprintf(out, "%-10s %12.3f %12.0f %10.2f\n", "reference", kernel.referenceMs,
+        kernel.referenceMs > 0.0 ? ringCount / kernel.referenceMs : 0.0, 1.0);
+    fprintf(out, "%-10s %12.3f %12.0f %10.2f\n", ORBIT_KERNEL_SSE ? "SSE" : "scalar", kernel.simdMs,
+        kernel.simdMs > 0.0 ? ringCount / kernel.simdMs : 0.0,
+        kernel.simdMs > 0.0 ? kernel.referenceMs / kernel.simdMs : 0.0);
+    fclose(out);
+    return withinTolerance && kernel.engagedMismatches == 0;
+}
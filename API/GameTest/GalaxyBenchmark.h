@@ -0,0 +1,30 @@
+//------------------------------------------------------------------------
+// GalaxyBenchmark.h
+//------------------------------------------------------------------------
+#ifndef GALAXY_BENCHMARK_H
+#define GALAXY_BENCHMARK_H
+
+#include "HeadlessRun.h"
+
+// Times Galaxy::UpdateEntities on a crowded galaxy with 1, 2, 4 ... job
+// system threads and writes the per tick cost, rings/ms and a state
+// checksum for each. Then runs the SIMD orbit kernel against the
+// sinf/cosf reference on as many rings. Ring positions may differ by at
+// most 2 * OrbitKernel::MAX_SINCOS_ERROR times the ring radius plus float
+// rounding, and both must engage the same rings. Nothing is drawn while
+// it runs. A headless run, see HeadlessRun.h:
+//   GAMETEST_BENCH_REPORT   report file, enables the benchmark
+//   GAMETEST_BENCH_PLANETS  planets in the galaxy, default 10000
+//   GAMETEST_BENCH_TICKS    timed ticks per thread count, default 300
+//   GAMETEST_BENCH_THREADS  highest thread count, default 16
+class GalaxyBenchmark {
+public:
+    // Settings besides GAMETEST_BENCH_REPORT
+    static void ConfigureFromEnvironment();
+
+    // Leaves the job system with its default thread count afterwards.
+    // Returns false if the kernels disagree beyond the tolerance.
+    static bool Run(const char* reportPath, const HeadlessRun::Context& context);
+};
+
+#endif
@@ -6,6 +6,10 @@
 #include "UISystem.h"
 #include "Galaxy.h"
 #include "Spaceship.h"
+#include "JobSystem.h"
+#include "FrameArena.h"
+#include "AllocationTracker.h"
+#include "HeadlessRun.h"
 
 // Global variables
 Renderer3D* renderer = nullptr;
@@ -13,19 +17,34 @@ UISystem* ui = nullptr;
 Galaxy* galaxy = nullptr;
 Spaceship* spaceship = nullptr;
 
-UIText* fpsDisplay = nullptr;
-UIText* positionDisplay = nullptr;
-UIText* mousePositionDisplay = nullptr;
-UIText* healthDisplay = nullptr;
-UIText* ammoDisplay = nullptr;
-UIText* gameOverText = nullptr;
-UIText* restartText = nullptr;
+UITextHandle fpsDisplay;
+UITextHandle positionDisplay;
+UITextHandle mousePositionDisplay;
+UITextHandle healthDisplay;
+UITextHandle ammoDisplay;
+UITextHandle gameOverText;
+UITextHandle restartText;
+UITextHandle renderStatsDisplay;
+UITextHandle galaxyStatsDisplay;
+UITextHandle chunkStatsDisplay;
+UITextHandle chunkCacheDisplay;
+UITextHandle chunkSourceDisplay;
+UITextHandle memoryStatsDisplay;
+UITextHandle allocationTagsDisplay;
+UITextHandle entityStatsDisplay;
+UITextHandle uiStatsDisplay;
+
+bool showDebugStats = false;       // Toggled with F1, F2 toggles star LOD
+bool benchmarkGalaxy = false;      // F4 swaps in a galaxy with BENCHMARK_PLANETS planets, F5 toggles the reference orbit update
 
 float mouseWorldX = 0.0f;
 float mouseWorldY = 0.0f;
 
 // Constants
 const float MOVE_SPEED = 2.0f;
+const int NORMAL_PLANETS = 10;
+const int BENCHMARK_PLANETS = 10000;
+const float HUD_REFRESH_INTERVAL = 250.0f;  // Milliseconds between FPS and debug stat updates
 const float CAM_HEIGHT = 0.0f;
 const float CAM_DISTANCE = 150.0f;
 const float INITIAL_ZOOM = 1500.0f;  // Starting zoom distance
@@ -38,9 +57,20 @@ bool isZooming = true;             // Track if initial zoom is active
 //------------------------------------------------------------------------
 void Init() {
     // Initialize basic systems
+    if (!AllocationTracker::ConfigureFromEnvironment() && AllocationTracker::IsConfigured()) {
+        App::SetExitCode(1);
+    }
+    JobSystem::GetInstance().Initialize();
+    FrameArena::GetInstance().Initialize();
+
     renderer = new Renderer3D();
     renderer->Initialize(APP_VIRTUAL_WIDTH, APP_VIRTUAL_HEIGHT);
 
+    // Headless runs, the game quits on its first update afterwards
+    HeadlessRun::ConfigureFromEnvironment();
+    HeadlessRun::Context headless = { renderer, nullptr };
+    HeadlessRun::RunConfigured(headless);
+
     // Initialize UI and add text displays
     ui = new UISystem(renderer);
     fpsDisplay = ui->AddText("FPS: 0", 10, 20);
@@ -59,15 +89,42 @@ void Init() {
         TEXT_Y_POS + 20,  // Slightly below center
         1.0f, 1.0f, 1.0f);
 
-    gameOverText->visible = false;
-    restartText->visible = false;
+    ui->Get(gameOverText)->visible = false;
+    ui->Get(restartText)->visible = false;
 
     mousePositionDisplay = ui->AddText("Mouse: 0, 0", APP_VIRTUAL_WIDTH/2 - 100, APP_VIRTUAL_HEIGHT - 10);
 
+    renderStatsDisplay = ui->AddText("Render: 0 cmds", 10, 40);
+    ui->Get(renderStatsDisplay)->visible = false;
+    galaxyStatsDisplay = ui->AddText("Stars: 0", 10, 60);
+    ui->Get(galaxyStatsDisplay)->visible = false;
+    chunkStatsDisplay = ui->AddText("Chunks: 0", 10, 80);
+    ui->Get(chunkStatsDisplay)->visible = false;
+    chunkCacheDisplay = ui->AddText("Chunk cache: 0", 10, 100);
+    ui->Get(chunkCacheDisplay)->visible = false;
+    chunkSourceDisplay = ui->AddText("Chunk sources: 0", 10, 120);
+    ui->Get(chunkSourceDisplay)->visible = false;
+    memoryStatsDisplay = ui->AddText("Memory: 0", 10, 140);
+    ui->Get(memoryStatsDisplay)->visible = false;
+    allocationTagsDisplay = ui->AddText("Heap by tag:", 10, 160);
+    ui->Get(allocationTagsDisplay)->visible = false;
+    entityStatsDisplay = ui->AddText("Entities: 0", 10, 180);
+    ui->Get(entityStatsDisplay)->visible = false;
+    uiStatsDisplay = ui->AddText("UI: 0 ms", 10, 200);
+    ui->Get(uiStatsDisplay)->visible = false;
+
     // Create galaxy and spaceship
-    galaxy = new Galaxy(renderer, 100);
+    // Streaming can be tuned per machine through galaxy.ini in the working directory
+    GalaxySettings galaxySettings;
+    galaxySettings.starsPerChunk = 100;
+    galaxySettings.LoadFromFile(".\\galaxy.ini");
+    galaxy = new Galaxy(renderer, galaxySettings, NORMAL_PLANETS);
     spaceship = new Spaceship();
 
+    // The runs that needed the galaxy, with the settings just loaded
+    headless.galaxy = galaxy;
+    HeadlessRun::RunConfigured(headless);
+
     healthDisplay = ui->AddText("Ship Health: " + spaceship->health , 10, APP_VIRTUAL_HEIGHT - 30);
     positionDisplay = ui->AddText("Ship Position: 0, 0, 0", 10, APP_VIRTUAL_HEIGHT - 50);
     ammoDisplay = ui->AddText("Ship Ammo: " + std::to_string(spaceship->MAX_AMMO), 10, APP_VIRTUAL_HEIGHT - 10);
@@ -148,10 +205,11 @@ void UpdateCamera(float deltaTime) {
 }
 
 void DrawCrosshair(float mouseX, float mouseY) {
+    GLStateCache& gl = renderer->GetStateCache();
 
-    glDisable(GL_DEPTH_TEST);
-    glDisable(GL_LIGHTING);
-    glDisable(GL_BLEND);
+    gl.Disable(GL_DEPTH_TEST);
+    gl.Disable(GL_LIGHTING);
+    gl.Disable(GL_BLEND);
 
     glMatrixMode(GL_PROJECTION);
     glPushMatrix();
@@ -162,8 +220,8 @@ void DrawCrosshair(float mouseX, float mouseY) {
 
     mouseY = APP_VIRTUAL_HEIGHT - mouseY;
 
-    glColor3f(1.0f, 1.0f, 1.0f);  // Color
-    glLineWidth(Spaceship::CROSSHAIR_THICKNESS);
+    gl.Color(1.0f, 1.0f, 1.0f);  // Color
+    gl.LineWidth(Spaceship::CROSSHAIR_THICKNESS);
 
     // Draw circle
     glBegin(GL_LINE_LOOP);
@@ -185,21 +243,29 @@ void DrawCrosshair(float mouseX, float mouseY) {
     glVertex2f(mouseX, mouseY + Spaceship::CROSSHAIR_LINE_LENGTH);
     glEnd();
 
-    // Reset line width
-    glLineWidth(1.0f);
-
     glMatrixMode(GL_PROJECTION);
     glPopMatrix();
     glMatrixMode(GL_MODELVIEW);
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_BLEND);
-    glEnable(GL_LIGHTING);
 }
 
 //------------------------------------------------------------------------
 // Update game state. deltaTime is the elapsed time since the last update in ms.
 //------------------------------------------------------------------------
 void Update(float deltaTime) {
+    // Last frame's transient data is dead by now
+    FrameArena& frame = FrameArena::GetInstance();
+    frame.Reset();
+    AllocationTracker::BeginFrame();
+    // The report is written at exit, too late to set the exit code
+    if (AllocationTracker::IsFrameLimitReached() && AllocationTracker::GetSteadyStateAllocatingFrames() > 0) {
+        App::SetExitCode(1);
+    }
+    if (AllocationTracker::IsFrameLimitReached() || HeadlessRun::IsAnyConfigured()) {
+        glutLeaveMainLoop();
+        return;
+    }
+    AllocationScope allocationScope(AllocTag::Game);
+
     // Check for game over conditions
     bool isGameOver = !spaceship->IsAlive() || spaceship->GetAmmo() <= 0;
     float dt = deltaTime * 0.001f;  // Convert to seconds
@@ -220,29 +286,22 @@ void Update(float deltaTime) {
     float mouseX, mouseY;
     App::GetMousePos(mouseX, mouseY);
 
-    char mouseText[64];
-    sprintf_s(mouseText, "Crosshair Pos: %.1f, %.1f", mouseX, mouseY);
-    mousePositionDisplay->text = mouseText;
+    ui->Get(mousePositionDisplay)->SetValues("Crosshair Pos: %.1f, %.1f", mouseX, mouseY);
 
     // Get ship's current data
     float shipX, shipY, shipZ;
     spaceship->GetPosition(shipX, shipY, shipZ);
 
-    char healthText[32];
-    sprintf_s(healthText, "Ship Health: %d", spaceship->GetHealth());
-    healthDisplay->text = healthText;
-
-    char posText[64];
-    sprintf_s(posText, "Ship Position: %.1f, %.1f, %.1f", shipX, shipY, shipZ);
-    positionDisplay->text = posText;
-
-    char ammoText[32];
-    sprintf_s(ammoText, "Ammo: %d/%d", spaceship->GetAmmo(), spaceship->MAX_AMMO);
-    ammoDisplay->text = ammoText;
+    ui->Get(healthDisplay)->SetValues("Ship Health: %d", spaceship->GetHealth());
+    ui->Get(positionDisplay)->SetValues("Ship Position: %.1f, %.1f, %.1f", shipX, shipY, shipZ);
+    ui->Get(ammoDisplay)->SetValues("Ammo: %d/%d", spaceship->GetAmmo(), spaceship->MAX_AMMO);
 
     // Update components
     spaceship->Update(dt);
-    galaxy->Update(deltaTime, renderer->GetCamera());
+    {
+        AllocationScope galaxyScope(AllocTag::Galaxy);
+        galaxy->Update(deltaTime, renderer->GetCamera());
+    }
     UpdateCamera(deltaTime);
 
     spaceship->LookAt(mouseX, mouseY);
@@ -250,17 +309,146 @@ void Update(float deltaTime) {
     // Update UI
     static float fps = 0;
     fps = 0.9f * fps + 0.1f * (1000.0f / deltaTime);
-    char fpsText[32];
-    sprintf_s(fpsText, "FPS: %.1f", fps);
-    fpsDisplay->text = fpsText;
-
-    if (gameOverText) gameOverText->visible = isGameOver;
-    if (restartText) restartText->visible = isGameOver;
-    if (ammoDisplay) ammoDisplay->visible = !isGameOver;
-    if (healthDisplay) healthDisplay->visible = !isGameOver;
+
+    // Stats that change every frame are refreshed a few times a second, so
+    // the UI layer stays cached in between
+    static float hudRefreshTimer = 0.0f;
+    hudRefreshTimer += deltaTime;
+    bool refreshHud = hudRefreshTimer >= HUD_REFRESH_INTERVAL;
+    if (refreshHud) {
+        hudRefreshTimer = 0.0f;
+        ui->Get(fpsDisplay)->SetValues("FPS: %.1f", fps);
+    }
+
+    // UI cost since the last refresh
+    static double uiMs = 0.0;
+    static int uiFrames = 0;
+    static int uiCachedFrames = 0;
+    const UISystem::Stats& uiStats = ui->GetStats();
+    uiMs += uiStats.ms;
+    uiFrames++;
+    if (uiStats.cached) uiCachedFrames++;
+
+    // Debug stats, toggled with F1
+    static bool debugKeyWasDown = false;
+    bool debugKeyDown = App::IsKeyPressed(VK_F1);
+    if (debugKeyDown && !debugKeyWasDown) showDebugStats = !showDebugStats;
+    debugKeyWasDown = debugKeyDown;
+
+    // Star LOD on/off to compare quality and cost
+    static bool lodKeyWasDown = false;
+    bool lodKeyDown = App::IsKeyPressed(VK_F2);
+    if (lodKeyDown && !lodKeyWasDown) galaxy->GetStarLOD().enabled = !galaxy->GetStarLOD().enabled;
+    lodKeyWasDown = lodKeyDown;
+
+    // Swap between the normal galaxy and a crowded one to measure the entity systems
+    static bool benchmarkKeyWasDown = false;
+    bool benchmarkKeyDown = App::IsKeyPressed(VK_F4);
+    if (benchmarkKeyDown && !benchmarkKeyWasDown) {
+        benchmarkGalaxy = !benchmarkGalaxy;
+        GalaxySettings galaxySettings = galaxy->GetSettings();
+        delete galaxy;
+        galaxy = new Galaxy(renderer, galaxySettings, benchmarkGalaxy ? BENCHMARK_PLANETS : NORMAL_PLANETS);
+        galaxy->SetSpaceship(spaceship);
+    }
+    benchmarkKeyWasDown = benchmarkKeyDown;
+
+    // Scalar reference orbit update against the SIMD kernel
+    static bool orbitKeyWasDown = false;
+    bool orbitKeyDown = App::IsKeyPressed(VK_F5);
+    if (orbitKeyDown && !orbitKeyWasDown) galaxy->SetReferenceOrbits(!galaxy->IsUsingReferenceOrbits());
+    orbitKeyWasDown = orbitKeyDown;
+
+    if (showDebugStats && refreshHud) {
+        const RenderQueue::Stats& stats = renderer->GetRenderQueue().GetStats();
+        const GLStateCache::Counters& glCounters = renderer->GetStateCache().GetCounters();
+        const TextRenderer::Stats& textStats = ui->GetTextStats();
+        ui->Get(renderStatsDisplay)->SetValues("Render: %d cmds, state changes %d unsorted / %d sorted, GL state calls %d requested / %d issued, text %d glyphs in %d draws",
+            stats.commands, stats.stateChangesUnsorted, stats.stateChanges,
+            glCounters.requested, glCounters.issued, textStats.glyphs, textStats.drawCalls);
+
+        ui->Get(galaxyStatsDisplay)->SetValues("Stars: %d vertices (LOD %s)",
+            galaxy->GetStarVertexCount(), galaxy->GetStarLOD().enabled ? "on" : "off");
+
+        const ChunkStats& chunkStats = galaxy->GetChunkStats();
+        ui->Get(chunkStatsDisplay)->SetValues("Chunks: %d loaded, %d over budget, %d stars, %.1f / %.1f MB",
+            chunkStats.loadedChunks, chunkStats.chunksOverBudget, chunkStats.loadedStars,
+            chunkStats.loadedBytes / (1024.0f * 1024.0f), chunkStats.budgetBytes / (1024.0f * 1024.0f));
+
+        ui->Get(chunkCacheDisplay)->SetValues("Chunk cache: %d chunks, %.1f MB, %d hits / %d misses",
+            chunkStats.cachedChunks, chunkStats.cachedBytes / (1024.0f * 1024.0f),
+            chunkStats.cacheHits, chunkStats.cacheMisses);
+
+        ui->Get(chunkSourceDisplay)->SetValues("Chunk sources: %d generated (%.2f ms avg), %d from catalogue (%.2f ms avg)%s",
+            chunkStats.generatedChunks,
+            chunkStats.generatedChunks ? chunkStats.generateMs / chunkStats.generatedChunks : 0.0,
+            chunkStats.catalogueChunks,
+            chunkStats.catalogueChunks ? chunkStats.catalogueMs / chunkStats.catalogueChunks : 0.0,
+            galaxy->IsCatalogueLoaded() ? "" : ", no catalogue");
+
+        const FrameArena::Stats& arenaStats = frame.GetStats();
+        int heapAllocations = AllocationTracker::GetFrameAllocations();
+        if (heapAllocations < 0) {
+            ui->Get(memoryStatsDisplay)->SetValues("Memory: heap tracking off (TRACK_ALLOCATIONS), frame arena %.1f / %.1f KB, %d overflows",
+                arenaStats.used / 1024.0f, arenaStats.capacity / 1024.0f, arenaStats.overflows);
+        }
+        else {
+            ui->Get(memoryStatsDisplay)->SetValues("Memory: %d heap allocations last frame, frame arena %.1f / %.1f KB, %d overflows",
+                heapAllocations, arenaStats.used / 1024.0f, arenaStats.capacity / 1024.0f, arenaStats.overflows);
+        }
+
+        if (AllocationTracker::IsEnabled()) {
+            // Tags that allocated last frame
+            const AllocationTracker::Report& lastFrame = AllocationTracker::GetLastFrame();
+            UIText* tagText = ui->Get(allocationTagsDisplay);
+            tagText->BeginText();
+            tagText->AppendText("Heap by tag:");
+            for (int i = 0; i < (int)AllocTag::Count; i++) {
+                const AllocationTracker::TagStats& tag = lastFrame.tags[i];
+                if (tag.allocations == 0) continue;
+                tagText->AppendText(" %s %d (%zu B)", AllocationTracker::GetTagName((AllocTag)i),
+                    tag.allocations, tag.bytes);
+            }
+            tagText->AppendText(", steady state allocating frames %d",
+                AllocationTracker::GetSteadyStateAllocatingFrames());
+            tagText->EndText();
+        }
+        else {
+            ui->Get(allocationTagsDisplay)->SetText(heapAllocations < 0 ?
+                "Heap by tag: build with TRACK_ALLOCATIONS=1 and set GAMETEST_ALLOC_REPORT to enable" :
+                "Heap by tag: set GAMETEST_ALLOC_REPORT to enable");
+        }
+
+        ui->Get(entityStatsDisplay)->SetValues("Entities: %d planets, %d rings, update %.2f ms (orbits %.3f ms %s), build %.2f ms",
+            galaxy->GetPlanetCount(), galaxy->GetRingCount(), galaxy->GetEntityUpdateMs(),
+            galaxy->GetOrbitKernelMs(), galaxy->IsUsingReferenceOrbits() ? "scalar" : "SIMD",
+            galaxy->GetRenderBuildMs());
+
+        ui->Get(uiStatsDisplay)->SetValues("UI: %.3f ms avg, layer cached %d of %d frames, %d of %d elements changed last frame",
+            uiMs / uiFrames, uiCachedFrames, uiFrames, uiStats.changedElements, uiStats.elements);
+    }
+    if (refreshHud) {
+        uiMs = 0.0;
+        uiFrames = 0;
+        uiCachedFrames = 0;
+    }
+    ui->Get(renderStatsDisplay)->visible = showDebugStats;
+    ui->Get(galaxyStatsDisplay)->visible = showDebugStats;
+    ui->Get(chunkStatsDisplay)->visible = showDebugStats;
+    ui->Get(chunkCacheDisplay)->visible = showDebugStats;
+    ui->Get(chunkSourceDisplay)->visible = showDebugStats;
+    ui->Get(memoryStatsDisplay)->visible = showDebugStats;
+    ui->Get(allocationTagsDisplay)->visible = showDebugStats;
+    ui->Get(entityStatsDisplay)->visible = showDebugStats;
+    ui->Get(uiStatsDisplay)->visible = showDebugStats;
+
+    if (gameOverText) ui->Get(gameOverText)->visible = isGameOver;
+    if (restartText) ui->Get(restartText)->visible = isGameOver;
+    if (ammoDisplay) ui->Get(ammoDisplay)->visible = !isGameOver;
+    if (healthDisplay) ui->Get(healthDisplay)->visible = !isGameOver;
     //temp off
-    if (positionDisplay) positionDisplay->visible = false;
-    if (mousePositionDisplay) mousePositionDisplay->visible = false;
+    if (positionDisplay) ui->Get(positionDisplay)->visible = false;
+    if (mousePositionDisplay) ui->Get(mousePositionDisplay)->visible = false;
 
     // Handle restart
     if (isGameOver && App::IsKeyPressed('R')) {
@@ -274,8 +462,8 @@ void Update(float deltaTime) {
         isZooming = true;
 
         // Reset UI visibility
-        gameOverText->visible = false;
-        restartText->visible = false;
+        ui->Get(gameOverText)->visible = false;
+        ui->Get(restartText)->visible = false;
     }
 }
 
@@ -283,13 +471,20 @@ void Update(float deltaTime) {
 // Render the game world
 //------------------------------------------------------------------------
 void Render() {
+    AllocationScope allocationScope(AllocTag::Render);
+
     // Clear screen with dark background
     glClearColor(0.0f, 0.0f, 0.02f, 1.0f);
+    renderer->GetStateCache().ResetCounters();
+    ui->BakeFonts();
     renderer->SetupScene();
 
-    // Render game objects
-    galaxy->Render();
-    spaceship->Render();
+    // Queue game objects, then sort and submit them in one go
+    RenderQueue& queue = renderer->GetRenderQueue();
+    queue.Begin(renderer->GetCamera());
+    galaxy->Render(queue);
+    spaceship->Render(queue);
+    queue.Flush();
 
     galaxy->SetSpaceship(spaceship);
 
@@ -299,6 +494,7 @@ void Render() {
     DrawCrosshair(mouseX, mouseY);
 
     // Render UI on top
+    AllocationScope uiScope(AllocTag::UI);
     ui->Render();
 }
 
@@ -310,4 +506,7 @@ void Shutdown() {
     delete galaxy;
     delete ui;
     delete renderer;
+
+    JobSystem::GetInstance().Shutdown();
+    FrameArena::GetInstance().Shutdown();
 }
\ No newline at end of file
@@ -0,0 +1,96 @@
+//------------------------------------------------------------------------
+// HeadlessRun.cpp
+//------------------------------------------------------------------------
+#include "stdafx.h"
+#include "HeadlessRun.h"
+#include "DebugUtils.h"
+#include <App/app.h>
+#include "GalaxyBenchmark.h"
+#include "UIBenchmark.h"
+#include "TextBenchmark.h"
+#include "SpriteBenchmark.h"
+#include "SpriteUVCheck.h"
+#include "TextureBenchmark.h"
+#include "TextureBaker.h"
+#include "RenderBenchmark.h"
+#include "StarCatalogueBaker.h"
+#include "PackedStarCheck.h"
+#include <stdlib.h>
+#include <windows.h>
+
+struct HeadlessEntry {
+    const char* variable;           // Enables the run
+    void (*configure)();            // Reads the run's other variables, may be null
+    HeadlessRun::RunFunc run;
+    bool needsGalaxy;
+};
+
+// In the order they run
+static const HeadlessEntry RUNS[] = {
+    { "GAMETEST_BENCH_REPORT", GalaxyBenchmark::ConfigureFromEnvironment, GalaxyBenchmark::Run, false },
+    { "GAMETEST_UI_BENCH_REPORT", UIBenchmark::ConfigureFromEnvironment, UIBenchmark::Run, false },
+    { "GAMETEST_TEXT_BENCH_REPORT", TextBenchmark::ConfigureFromEnvironment, TextBenchmark::Run, false },
+    { "GAMETEST_SPRITE_BENCH_REPORT", SpriteBenchmark::ConfigureFromEnvironment, SpriteBenchmark::Run, false },
+    { "GAMETEST_SPRITE_UV_CHECK_REPORT", nullptr, SpriteUVCheck::Run, false },
+    { "GAMETEST_TEXTURE_BENCH_REPORT", TextureBenchmark::ConfigureFromEnvironment, TextureBenchmark::Run, false },
+    { "GAMETEST_TEXTURE_BAKE_DIR", TextureBaker::ConfigureFromEnvironment, TextureBaker::Run, false },
+    { "GAMETEST_RENDER_BENCH_REPORT", RenderBenchmark::ConfigureFromEnvironment, RenderBenchmark::Run, false },
+    { "GAMETEST_STAR_CHECK_REPORT", nullptr, PackedStarCheck::Run, false },
+    // Bakes with the settings Init loaded for the game's galaxy
+    { "GAMETEST_CATALOGUE_BAKE_PATH", StarCatalogueBaker::ConfigureFromEnvironment, StarCatalogueBaker::Run, true },
+};
+static const int RUN_COUNT = sizeof(RUNS) / sizeof(RUNS[0]);
+
+static char values[RUN_COUNT][MAX_PATH];
+static bool finished[RUN_COUNT];
+static bool anyConfigured = false;
+
+bool HeadlessRun::ConfigureFromEnvironment() {
+    anyConfigured = false;
+    for (int i = 0; i < RUN_COUNT; i++) {
+        finished[i] = false;
+        if (!GetString(RUNS[i].variable, values[i], sizeof(values[i]))) continue;
+        if (RUNS[i].configure) RUNS[i].configure();
+        anyConfigured = true;
+    }
+    return anyConfigured;
+}
+
+bool HeadlessRun::IsAnyConfigured() {
+    return anyConfigured;
+}
+
+void HeadlessRun::RunConfigured(const Context& context) {
+    for (int i = 0; i < RUN_COUNT; i++) {
+        if (values[i][0] == '\0' || finished[i]) continue;
+        if (RUNS[i].needsGalaxy && !context.galaxy) continue;
+
+        finished[i] = true;
+        if (!RUNS[i].run(values[i], context)) {
+            DebugPrint("HeadlessRun: %s run failed\n", RUNS[i].variable);
+            App::SetExitCode(1);
+        }
+    }
+}
+
+bool HeadlessRun::GetString(const char* name, char* value, size_t size) {
+    if (!GetEnvironmentVariableA(name, value, (DWORD)size)) {
+        value[0] = '\0';
+        return false;
+    }
+    return true;
+}
+
+int HeadlessRun::GetInt(const char* name, int defaultValue) {
+    char value[32];
+    return GetString(name, value, sizeof(value)) ? atoi(value) : defaultValue;
+}
+
+FILE* HeadlessRun::OpenReport(const char* path) {
+    FILE* out = nullptr;
+    if (fopen_s(&out, path, "w") != 0 || !out) {
+        DebugPrint("HeadlessRun: can't write %s\n", path);
+        return nullptr;
+    }
+    return out;
+}
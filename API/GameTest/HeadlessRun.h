@@ -0,0 +1,44 @@
+//------------------------------------------------------------------------
+// HeadlessRun.h
+//------------------------------------------------------------------------
+#ifndef HEADLESS_RUN_H
+#define HEADLESS_RUN_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+class Renderer3D;
+class Galaxy;
+
+// Benchmarks, checks and bakers that run in place of the game, e.g. in CI.
+// Each is enabled by one environment variable, usually its report file,
+// and listed in the table in HeadlessRun.cpp. Init runs the enabled ones,
+// a failed run sets exit code 1, and the game quits on its first update.
+class HeadlessRun {
+public:
+    // What a run gets to work with. Runs that need the galaxy wait until
+    // Init has made it.
+    struct Context {
+        Renderer3D* renderer;
+        Galaxy* galaxy;
+    };
+
+    // value is the enabling variable, e.g. the report file
+    typedef bool (*RunFunc)(const char* value, const Context& context);
+
+    // Reads every run's variables. Returns true if any run is enabled.
+    static bool ConfigureFromEnvironment();
+    static bool IsAnyConfigured();
+
+    // Runs the enabled runs whose needs context meets and that haven't run
+    static void RunConfigured(const Context& context);
+
+    // For the runs' own settings. GetString empties value if name is unset.
+    static bool GetString(const char* name, char* value, size_t size);
+    static int GetInt(const char* name, int defaultValue);
+
+    // Opens a report for writing, logging why it couldn't
+    static FILE* OpenReport(const char* path);
+};
+
+#endif
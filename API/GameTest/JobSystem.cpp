@@ -0,0 +1,187 @@
+//------------------------------------------------------------------------
+// JobSystem.cpp
+//------------------------------------------------------------------------
+#include "stdafx.h"
+#include "JobSystem.h"
+#include <algorithm>
+
+JobSystem& JobSystem::GetInstance() {
+    static JobSystem instance;
+    return instance;
+}
+
+JobSystem::JobSystem() : quit(false) {
+}
+
+JobSystem::~JobSystem() {
+    Shutdown();
+}
+
+void JobSystem::Initialize(int threadCount) {
+    if (!workers.empty()) return;
+
+    if (threadCount < 0) {
+        threadCount = std::max(0, (int)std::thread::hardware_concurrency() - 1);
+    }
+
+    quit = false;
+    for (int i = 0; i < threadCount; i++) {
+        workers.emplace_back(&JobSystem::WorkerLoop, this);
+    }
+    batchRanges.reset(new BatchRange[GetSliceCount()]);
+}
+
+void JobSystem::Shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    jobAvailable.notify_all();
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+    jobs.clear();
+}
+
+void JobSystem::WorkerLoop() {
+    for (;;) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            jobAvailable.wait(lock, [this] { return quit || !jobs.empty(); });
+            if (quit && jobs.empty()) return;
+
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+        job();
+    }
+}
+
+void JobSystem::ParallelFor(int count, const std::function<void(int begin, int end, int slice)>& fn) {
+    if (count <= 0) return;
+
+    int slices = std::min(GetSliceCount(), count);
+    if (slices == 1) {
+        fn(0, count, 0);
+        return;
+    }
+
+    int perSlice = count / slices;
+    int remainder = count % slices;
+    int pending = slices - 1;
+
+    // Slice 0 runs on the calling thread, the rest go to the workers
+    int begin = perSlice + (remainder > 0 ? 1 : 0);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (int slice = 1; slice < slices; slice++) {
+            int end = begin + perSlice + (slice < remainder ? 1 : 0);
+            jobs.emplace_back([this, &fn, &pending, begin, end, slice] {
+                fn(begin, end, slice);
+
+                std::lock_guard<std::mutex> doneLock(mutex);
+                if (--pending == 0) {
+                    jobsDone.notify_all();
+                }
+            });
+            begin = end;
+        }
+    }
+    jobAvailable.notify_all();
+
+    fn(0, perSlice + (remainder > 0 ? 1 : 0), 0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    jobsDone.wait(lock, [&pending] { return pending == 0; });
+}
+
+bool JobSystem::PopFront(BatchRange& batches, int& batch) {
+    uint64_t range = batches.range.load();
+    for (;;) {
+        uint32_t front = (uint32_t)(range >> 32);
+        uint32_t back = (uint32_t)range;
+        if (front >= back) return false;
+
+        uint64_t next = ((uint64_t)(front + 1) << 32) | back;
+        if (batches.range.compare_exchange_weak(range, next)) {
+            batch = (int)front;
+            return true;
+        }
+    }
+}
+
+bool JobSystem::PopBack(BatchRange& batches, int& batch) {
+    uint64_t range = batches.range.load();
+    for (;;) {
+        uint32_t front = (uint32_t)(range >> 32);
+        uint32_t back = (uint32_t)range;
+        if (front >= back) return false;
+
+        uint64_t next = ((uint64_t)front << 32) | (back - 1);
+        if (batches.range.compare_exchange_weak(range, next)) {
+            batch = (int)(back - 1);
+            return true;
+        }
+    }
+}
+
+void JobSystem::ParallelForStealing(int count, int batchSize, const std::function<void(int begin, int end, int slice)>& fn) {
+    if (count <= 0) return;
+    if (batchSize < 1) batchSize = 1;
+
+    int batchCount = (count + batchSize - 1) / batchSize;
+    int slices = std::min(GetSliceCount(), batchCount);
+    if (slices == 1) {
+        fn(0, count, 0);
+        return;
+    }
+
+    BatchRange* owned = batchRanges.get();
+    int perSlice = batchCount / slices;
+    int remainder = batchCount % slices;
+    uint32_t first = 0;
+    for (int slice = 0; slice < slices; slice++) {
+        uint32_t last = first + perSlice + (slice < remainder ? 1 : 0);
+        owned[slice].range = ((uint64_t)first << 32) | last;
+        first = last;
+    }
+
+    auto runSlice = [owned, &fn, slices, batchSize, count](int slice) {
+        int batch;
+        while (PopFront(owned[slice], batch)) {
+            fn(batch * batchSize, std::min(count, (batch + 1) * batchSize), slice);
+        }
+
+        // Own batches are done, help whoever still has some
+        for (int offset = 1; offset < slices; offset++) {
+            BatchRange& victim = owned[(slice + offset) % slices];
+            while (PopBack(victim, batch)) {
+                fn(batch * batchSize, std::min(count, (batch + 1) * batchSize), slice);
+            }
+        }
+    };
+
+    int pending = slices - 1;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (int slice = 1; slice < slices; slice++) {
+            jobs.emplace_back([this, &runSlice, &pending, slice] {
+                runSlice(slice);
+
+                std::lock_guard<std::mutex> doneLock(mutex);
+                if (--pending == 0) {
+                    jobsDone.notify_all();
+                }
+            });
+        }
+    }
+    jobAvailable.notify_all();
+
+    runSlice(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    jobsDone.wait(lock, [&pending] { return pending == 0; });
+}
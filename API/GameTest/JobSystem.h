@@ -0,0 +1,69 @@
+//------------------------------------------------------------------------
+// JobSystem.h
+//------------------------------------------------------------------------
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+// Small fixed thread pool. The calling thread always takes part in the work,
+// so with no worker threads everything simply runs inline.
+class JobSystem {
+public:
+    static JobSystem& GetInstance();
+
+    // Worker threads besides the caller. Negative means one per hardware
+    // thread, minus the caller.
+    void Initialize(int threadCount = -1);
+    void Shutdown();
+
+    // Number of slices ParallelFor splits work into, the calling thread included.
+    // Use it to size per-slice output buffers.
+    int GetSliceCount() const { return (int)workers.size() + 1; }
+
+    // Splits [0, count) into at most GetSliceCount() contiguous slices and
+    // blocks until all of them are done. A slice index is only ever used by
+    // one thread at a time, so it can index per-slice buffers without locking.
+    void ParallelFor(int count, const std::function<void(int begin, int end, int slice)>& fn);
+
+    // Like ParallelFor but for uneven work. [0, count) is cut into batches
+    // of up to batchSize. Each slice starts with a contiguous share of the
+    // batches and takes them from the front. A slice that runs out steals
+    // from the back of the others. Which slice runs a batch isn't fixed, so
+    // anything merged from per-slice buffers must be ordered by index.
+    void ParallelForStealing(int count, int batchSize, const std::function<void(int begin, int end, int slice)>& fn);
+
+private:
+    JobSystem();
+    ~JobSystem();
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    void WorkerLoop();
+
+    // Batches a slice still owns, packed as front << 32 | back so both ends
+    // move with one compare and swap
+    struct BatchRange {
+        std::atomic<uint64_t> range;
+    };
+    static bool PopFront(BatchRange& batches, int& batch);
+    static bool PopBack(BatchRange& batches, int& batch);
+    std::unique_ptr<BatchRange[]> batchRanges;   // One per slice
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> jobs;
+    std::mutex mutex;
+    std::condition_variable jobAvailable;
+    std::condition_variable jobsDone;
+    bool quit;
+};
+
+#endif
@@ -0,0 +1,203 @@
+//------------------------------------------------------------------------
+// OrbitKernel.cpp
+//------------------------------------------------------------------------
+#include "stdafx.h"
+#include "OrbitKernel.h"
+#include <math.h>
+#if ORBIT_KERNEL_SSE
+#include <emmintrin.h>
+#endif
+
+static const float PI = 3.14159265f;
+static const float TWO_PI = 2.0f * PI;
+static const float INV_360 = 1.0f / 360.0f;
+
+// Taylor coefficients of sin(x). Truncating after x^9 is off by at most
+// (pi/2)^11 / 11!, about 4e-6, on [-pi/2, pi/2].
+static const float S3 = -1.0f / 6.0f;
+static const float S5 = 1.0f / 120.0f;
+static const float S7 = -1.0f / 5040.0f;
+static const float S9 = 1.0f / 362880.0f;
+
+// sin(2 pi q) for q in [-0.5, 0.5] turns. Folding around +-0.25 keeps the
+// polynomial on the quarter turn where it's accurate.
+static inline float SinTurns(float q) {
+    if (q > 0.25f) q = 0.5f - q;
+    else if (q < -0.25f) q = -0.5f - q;
+
+    float x = q * TWO_PI;
+    float x2 = x * x;
+    return x * (1.0f + x2 * (S3 + x2 * (S5 + x2 * (S7 + x2 * S9))));
+}
+
+void OrbitKernel::FastSinCos(float degrees, float& sine, float& cosine) {
+    float turns = degrees * INV_360;
+    turns -= floorf(turns + 0.5f);
+
+    float quarter = turns + 0.25f;
+    if (quarter > 0.5f) quarter -= 1.0f;
+
+    sine = SinTurns(turns);
+    cosine = SinTurns(quarter);
+}
+
+// One ring given the sine and cosine of its angle, shared by the scalar
+// tail of Update and by UpdateReference
+static inline void UpdateOrbit(OrbitArray& orbits, int i, float sine, float cosine,
+    const OrbitUpdateParams& params, int* engaged, int& engagedCount) {
+    float x = orbits.centerX[i] + orbits.radius[i] * cosine;
+    float y = orbits.centerY[i] + orbits.radius[i] * sine;
+    orbits.x[i] = x;
+    orbits.y[i] = y;
+    orbits.z[i] = orbits.centerZ[i];
+
+    float dx = params.targetX - x;
+    float dy = params.targetY - y;
+    if (dx * dx + dy * dy < params.influenceRadius * params.influenceRadius) {
+        engaged[engagedCount++] = i;
+        return;
+    }
+
+    float angle = orbits.angle[i] + orbits.speed[i] * params.deltaTime;
+    if (angle > 360.0f) angle -= 360.0f;
+    orbits.angle[i] = angle;
+
+    float selfAngle = orbits.selfAngle[i] + orbits.selfSpeed[i] * params.deltaTime;
+    if (selfAngle > 360.0f) selfAngle -= 360.0f;
+    orbits.selfAngle[i] = selfAngle;
+
+    orbits.yawAngle[i] = 0.0f;
+}
+
+// Engaged rings face the target. There are only ever a handful, so this
+// stays scalar.
+static void FaceTarget(OrbitArray& orbits, const OrbitUpdateParams& params, const int* engaged, int engagedCount) {
+    for (int k = 0; k < engagedCount; k++) {
+        int i = engaged[k];
+        float dx = params.targetX - orbits.x[i];
+        float dy = params.targetY - orbits.y[i];
+        orbits.yawAngle[i] = atan2f(dy, dx) * 180.0f / PI;
+    }
+}
+
+#if ORBIT_KERNEL_SSE
+
+static inline __m128 Select(__m128 mask, __m128 a, __m128 b) {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+static inline __m128 SinTurns4(__m128 q) {
+    const __m128 quarter = _mm_set1_ps(0.25f);
+    const __m128 half = _mm_set1_ps(0.5f);
+    q = Select(_mm_cmpgt_ps(q, quarter), _mm_sub_ps(half, q), q);
+    q = Select(_mm_cmplt_ps(q, _mm_sub_ps(_mm_setzero_ps(), quarter)),
+        _mm_sub_ps(_mm_sub_ps(_mm_setzero_ps(), half), q), q);
+
+    __m128 x = _mm_mul_ps(q, _mm_set1_ps(TWO_PI));
+    __m128 x2 = _mm_mul_ps(x, x);
+    __m128 p = _mm_add_ps(_mm_set1_ps(S7), _mm_mul_ps(x2, _mm_set1_ps(S9)));
+    p = _mm_add_ps(_mm_set1_ps(S5), _mm_mul_ps(x2, p));
+    p = _mm_add_ps(_mm_set1_ps(S3), _mm_mul_ps(x2, p));
+    p = _mm_add_ps(_mm_set1_ps(1.0f), _mm_mul_ps(x2, p));
+    return _mm_mul_ps(x, p);
+}
+
+static inline void SinCos4(__m128 degrees, __m128& sine, __m128& cosine) {
+    // Round to nearest, orbit angles are far inside the int range
+    __m128 turns = _mm_mul_ps(degrees, _mm_set1_ps(INV_360));
+    turns = _mm_sub_ps(turns, _mm_cvtepi32_ps(_mm_cvtps_epi32(turns)));
+
+    __m128 quarter = _mm_add_ps(turns, _mm_set1_ps(0.25f));
+    quarter = Select(_mm_cmpgt_ps(quarter, _mm_set1_ps(0.5f)),
+        _mm_sub_ps(quarter, _mm_set1_ps(1.0f)), quarter);
+
+    sine = SinTurns4(turns);
+    cosine = SinTurns4(quarter);
+}
+
+// Adds step to angle and wraps past 360 like the scalar path
+static inline __m128 Advance4(__m128 angle, __m128 speed, __m128 deltaTime) {
+    const __m128 full = _mm_set1_ps(360.0f);
+    angle = _mm_add_ps(angle, _mm_mul_ps(speed, deltaTime));
+    return Select(_mm_cmpgt_ps(angle, full), _mm_sub_ps(angle, full), angle);
+}
+
+int OrbitKernel::Update(OrbitArray& orbits, int begin, int end, const OrbitUpdateParams& params, int* engaged) {
+    int engagedCount = 0;
+
+    const __m128 targetX = _mm_set1_ps(params.targetX);
+    const __m128 targetY = _mm_set1_ps(params.targetY);
+    const __m128 radiusSq = _mm_set1_ps(params.influenceRadius * params.influenceRadius);
+    const __m128 deltaTime = _mm_set1_ps(params.deltaTime);
+
+    int i = begin;
+    for (; i + 4 <= end; i += 4) {
+        __m128 angle = _mm_loadu_ps(&orbits.angle[i]);
+        __m128 sine, cosine;
+        SinCos4(angle, sine, cosine);
+
+        __m128 radius = _mm_loadu_ps(&orbits.radius[i]);
+        __m128 x = _mm_add_ps(_mm_loadu_ps(&orbits.centerX[i]), _mm_mul_ps(radius, cosine));
+        __m128 y = _mm_add_ps(_mm_loadu_ps(&orbits.centerY[i]), _mm_mul_ps(radius, sine));
+        _mm_storeu_ps(&orbits.x[i], x);
+        _mm_storeu_ps(&orbits.y[i], y);
+        _mm_storeu_ps(&orbits.z[i], _mm_loadu_ps(&orbits.centerZ[i]));
+
+        __m128 dx = _mm_sub_ps(targetX, x);
+        __m128 dy = _mm_sub_ps(targetY, y);
+        __m128 distanceSq = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+        __m128 inRange = _mm_cmplt_ps(distanceSq, radiusSq);
+
+        // Engaged lanes keep their angles, FaceTarget sets their yaw below
+        __m128 selfAngle = _mm_loadu_ps(&orbits.selfAngle[i]);
+        __m128 newAngle = Advance4(angle, _mm_loadu_ps(&orbits.speed[i]), deltaTime);
+        __m128 newSelfAngle = Advance4(selfAngle, _mm_loadu_ps(&orbits.selfSpeed[i]), deltaTime);
+        _mm_storeu_ps(&orbits.angle[i], Select(inRange, angle, newAngle));
+        _mm_storeu_ps(&orbits.selfAngle[i], Select(inRange, selfAngle, newSelfAngle));
+        _mm_storeu_ps(&orbits.yawAngle[i], _mm_setzero_ps());
+
+        int lanes = _mm_movemask_ps(inRange);
+        if (lanes) {
+            if (lanes & 1) engaged[engagedCount++] = i;
+            if (lanes & 2) engaged[engagedCount++] = i + 1;
+            if (lanes & 4) engaged[engagedCount++] = i + 2;
+            if (lanes & 8) engaged[engagedCount++] = i + 3;
+        }
+    }
+
+    for (; i < end; i++) {
+        float sine, cosine;
+        FastSinCos(orbits.angle[i], sine, cosine);
+        UpdateOrbit(orbits, i, sine, cosine, params, engaged, engagedCount);
+    }
+
+    FaceTarget(orbits, params, engaged, engagedCount);
+    return engagedCount;
+}
+
+#else
+
+int OrbitKernel::Update(OrbitArray& orbits, int begin, int end, const OrbitUpdateParams& params, int* engaged) {
+    int engagedCount = 0;
+    for (int i = begin; i < end; i++) {
+        float sine, cosine;
+        FastSinCos(orbits.angle[i], sine, cosine);
+        UpdateOrbit(orbits, i, sine, cosine, params, engaged, engagedCount);
+    }
+
+    FaceTarget(orbits, params, engaged, engagedCount);
+    return engagedCount;
+}
+
+#endif
+
+int OrbitKernel::UpdateReference(OrbitArray& orbits, int begin, int end, const OrbitUpdateParams& params, int* engaged) {
+    int engagedCount = 0;
+    for (int i = begin; i < end; i++) {
+        float radians = fmodf(orbits.angle[i], 360.0f) * PI / 180.0f;
+        UpdateOrbit(orbits, i, sinf(radians), cosf(radians), params, engaged, engagedCount);
+    }
+
+    FaceTarget(orbits, params, engaged, engagedCount);
+    return engagedCount;
+}
@@ -0,0 +1,40 @@
+//------------------------------------------------------------------------
+// OrbitKernel.h
+//------------------------------------------------------------------------
+#ifndef ORBIT_KERNEL_H
+#define ORBIT_KERNEL_H
+
+#include "EntityStore.h"
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define ORBIT_KERNEL_SSE 1
+#else
+#define ORBIT_KERNEL_SSE 0
+#endif
+
+struct OrbitUpdateParams {
+    float deltaTime;
+    float targetX, targetY;     // Rings closer than influenceRadius stop and face this
+    float influenceRadius;      // 0 disengages every ring
+};
+
+// Advances every orbit in an OrbitArray. Each ring gets its world position
+// from its current angle. Rings within the influence radius of the target
+// hold still and face it. The rest keep orbiting and spinning.
+class OrbitKernel {
+public:
+    // Updates orbits [begin, end). Returns how many rings are engaged and
+    // writes their indices, in ascending order, to engaged. It must hold
+    // end - begin entries. Disjoint ranges can be updated in parallel.
+    static int Update(OrbitArray& orbits, int begin, int end, const OrbitUpdateParams& params, int* engaged);
+
+    // Same update one ring at a time with sinf/cosf, to check Update against
+    static int UpdateReference(OrbitArray& orbits, int begin, int end, const OrbitUpdateParams& params, int* engaged);
+
+    // Polynomial sine and cosine of an angle in degrees, accurate to
+    // MAX_SINCOS_ERROR for any angle the orbits reach
+    static void FastSinCos(float degrees, float& sine, float& cosine);
+    static constexpr float MAX_SINCOS_ERROR = 1e-5f;
+};
+
+#endif
@@ -0,0 +1,113 @@
+//------------------------------------------------------------------------
+// PackedStarCheck.cpp
+//------------------------------------------------------------------------
+#include "stdafx.h"
+#include "PackedStarCheck.h"
+#include "Star.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <algorithm>
+#include <vector>
+#include <windows.h>
+
+static const int POSITION_SAMPLES = 1 << 20;   // Per chunk size and origin, 16 per 16 bit step
+static const int UNIT_SAMPLES = 1 << 16;       // Per colour channel, brightness and size
+static const float CHUNK_SIZES[] = { 1.0f, 100.0f, 1000.0f };
+static const int CHUNK_ORIGINS[] = { 0, -7, 1000 };   // Chunk index along each axis
+
+struct FieldResult {
+    char name[32];
+    double maxError;
+    double bound;
+};
+
+static void AddResult(std::vector<FieldResult>& results, const char* name, double maxError, double bound) {
+    FieldResult result;
+    strcpy_s(result.name, name);
+    result.maxError = maxError;
+    result.bound = bound;
+    results.push_back(result);
+}
+
+static bool WriteResults(FILE* out, const std::vector<FieldResult>& results) {
+    bool passed = true;
+    fprintf(out, "%-26s %14s %14s %6s\n", "field", "max error", "bound", "ok");
+    for (const FieldResult& result : results) {
+        bool ok = result.maxError <= result.bound;
+        passed = passed && ok;
+        fprintf(out, "%-26s %14.8f %14.8f %6s\n", result.name, result.maxError, result.bound, ok ? "yes" : "no");
+    }
+    return passed;
+}
+
+bool PackedStarCheck::Run(const char* reportPath, const HeadlessRun::Context& context) {
+    std::vector<FieldResult> results;
+
+    // Positions, every offset across the chunk including both edges
+    for (float chunkSize : CHUNK_SIZES) {
+        for (int chunk : CHUNK_ORIGINS) {
+            float origin = chunk * chunkSize;
+            float scale = PackedStar::PositionScale(chunkSize);
+
+            double maxError = 0.0;
+            for (int i = 0; i <= POSITION_SAMPLES; i++) {
+                Star star = {};
+                star.x = star.y = star.z = origin + chunkSize * ((float)i / POSITION_SAMPLES);
+
+                PackedStar packed = PackedStar::Pack(star, origin, origin, origin, chunkSize);
+                float x = origin + packed.x * scale;
+                float y = origin + packed.y * scale;
+                float z = origin + packed.z * scale;
+                maxError = std::max(maxError, (double)fabsf(x - star.x));
+                maxError = std::max(maxError, (double)fabsf(y - star.y));
+                maxError = std::max(maxError, (double)fabsf(z - star.z));
+            }
+
+            // Both the input and the decoded coordinate are rounded to float
+            double rounding = 2.0 * FLT_EPSILON * (fabs(origin) + chunkSize);
+            char name[32];
+            sprintf_s(name, "position %g @ %d", chunkSize, chunk);
+            AddResult(results, name, maxError, chunkSize / 131070.0 + rounding);
+        }
+    }
+
+    // Colour, brightness and size over [0, 1]
+    double maxR = 0.0, maxG = 0.0, maxB = 0.0, maxBrightness = 0.0, maxSize = 0.0;
+    for (int i = 0; i <= UNIT_SAMPLES; i++) {
+        float value = (float)i / UNIT_SAMPLES;
+
+        Star star = {};
+        star.r = value;
+        star.g = value;
+        star.b = value;
+        star.brightness = value;
+        star.size = value * PackedStar::MAX_SIZE;
+
+        PackedStar packed = PackedStar::Pack(star, 0.0f, 0.0f, 0.0f, 1.0f);
+        maxR = std::max(maxR, fabs(packed.GetR8() / 255.0 - value));
+        maxG = std::max(maxG, fabs(packed.GetG8() / 255.0 - value));
+        maxB = std::max(maxB, fabs(packed.GetB8() / 255.0 - value));
+        maxBrightness = std::max(maxBrightness, fabs(packed.GetBrightness() - (double)value));
+        maxSize = std::max(maxSize, fabs(packed.GetSize() - (double)star.size));
+    }
+
+    // Float rounding in Pack and the getters is far below these
+    const double SLACK = 1e-6;
+    AddResult(results, "r (5 bit)", maxR, 0.5 / 31.0 + 1.0 / 255.0 + SLACK);
+    AddResult(results, "g (6 bit)", maxG, 0.5 / 63.0 + 1.0 / 255.0 + SLACK);
+    AddResult(results, "b (5 bit)", maxB, 0.5 / 31.0 + 1.0 / 255.0 + SLACK);
+    AddResult(results, "brightness", maxBrightness, 0.5 / 255.0 + SLACK);
+    AddResult(results, "size", maxSize, 0.5 / 255.0 * PackedStar::MAX_SIZE + SLACK);
+
+    FILE* out = HeadlessRun::OpenReport(reportPath);
+    if (!out) return false;
+
+    fprintf(out, "position_samples=%d\n", POSITION_SAMPLES);
+    fprintf(out, "unit_samples=%d\n\n", UNIT_SAMPLES);
+    bool passed = WriteResults(out, results);
+    fprintf(out, "\npassed=%s\n", passed ? "yes" : "no");
+    fclose(out);
+    return passed;
+}
@@ -0,0 +1,25 @@
+//------------------------------------------------------------------------
+// PackedStarCheck.h
+//------------------------------------------------------------------------
+#ifndef PACKED_STAR_CHECK_H
+#define PACKED_STAR_CHECK_H
+
+#include "HeadlessRun.h"
+
+// Sweeps PackedStar::Pack over its whole input range and checks the
+// decoded values against the error bounds the format promises:
+//   position    half a 16 bit step, chunkSize / 131070, plus float rounding
+//               of the world coordinate
+//   colour      half a 5 or 6 bit step plus one 8 bit step for the
+//               bit replication in GetR8/GetG8/GetB8
+//   brightness  half an 8 bit step, size the same scaled by MAX_SIZE
+// Writes the worst error per field and fails the run if any is over.
+// A headless run, see HeadlessRun.h:
+//   GAMETEST_STAR_CHECK_REPORT  report file, enables the check
+class PackedStarCheck {
+public:
+    // Returns false if any bound is exceeded or the report can't be written
+    static bool Run(const char* reportPath, const HeadlessRun::Context& context);
+};
+
+#endif
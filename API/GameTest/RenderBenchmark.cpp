@@ -0,0 +1,226 @@
+//------------------------------------------------------------------------
+// RenderBenchmark.cpp
+//------------------------------------------------------------------------
+#include "stdafx.h"
+#include "RenderBenchmark.h"
+#include "Renderer3D.h"
+#include "Galaxy.h"
+#include "JobSystem.h"
+#include "FrameArena.h"
+#include <Spaceship.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include <chrono>
+#include <windows.h>
+
+static int sliceCount = 8;
+static int frameCount = 3;
+static int starCount = 1000000;
+static int buildCount = 30;
+static int maxThreads = 16;
+
+static const int STAR_RENDER_DISTANCE = 5;
+static const int WARMUP_BUILDS = 2;
+static const unsigned int SEED = 1234;
+
+void RenderBenchmark::ConfigureFromEnvironment() {
+    sliceCount = HeadlessRun::GetInt("GAMETEST_RENDER_BENCH_SLICES", sliceCount);
+    frameCount = HeadlessRun::GetInt("GAMETEST_RENDER_BENCH_FRAMES", frameCount);
+    starCount = HeadlessRun::GetInt("GAMETEST_RENDER_BENCH_STARS", starCount);
+    buildCount = HeadlessRun::GetInt("GAMETEST_RENDER_BENCH_BUILDS", buildCount);
+    maxThreads = HeadlessRun::GetInt("GAMETEST_RENDER_BENCH_THREADS", maxThreads);
+    if (sliceCount < 1) sliceCount = 1;
+    if (frameCount < 1) frameCount = 1;
+    if (starCount < 1) starCount = 1;
+    if (buildCount < 1) buildCount = 1;
+    if (maxThreads < 1) maxThreads = 1;
+}
+
+static void DrawNothing(const RenderCommand&, GLStateCache&) {
+}
+
+static void Submit(RenderQueue& queue, const RenderState& state, MeshId mesh,
+    float x, float y, float z, float r, float g, float b, float a = 1.0f) {
+    RenderCommand& cmd = queue.Submit(state, mesh, &DrawNothing, x, y, z);
+    cmd.r = r;
+    cmd.g = g;
+    cmd.b = b;
+    cmd.a = a;
+}
+
+// Same states and submission order as Galaxy::Render and Spaceship::Render
+static void SubmitFrame(RenderQueue& queue) {
+    RenderState starState;
+    starState.pass = RenderPass::Background;
+    starState.blend = BlendMode::Additive;
+    starState.depthTest = false;
+    starState.lighting = true;
+    starState.pointSmooth = true;
+
+    RenderState planetState;
+    planetState.pass = RenderPass::Background;
+    planetState.blend = BlendMode::Additive;
+    planetState.depthTest = false;
+    planetState.wireframe = true;
+
+    RenderState ringState = planetState;
+    ringState.wireframe = false;
+
+    RenderState explosionState;
+    explosionState.pass = RenderPass::Transparent;
+    explosionState.blend = BlendMode::Alpha;
+    explosionState.lineWidth = 2.0f;
+
+    RenderState bulletState;
+    bulletState.pass = RenderPass::Opaque;
+    bulletState.wireframe = true;
+
+    RenderState arrowState;
+    arrowState.pass = RenderPass::Overlay;
+    arrowState.depthTest = false;
+    arrowState.lineWidth = 2.0f;
+
+    for (int slice = 0; slice < sliceCount; slice++) {
+        float z = -100.0f * (slice + 1);
+        Submit(queue, starState, MeshId::Stars, 0.0f, 0.0f, z, 1.0f, 1.0f, 1.0f);
+        Submit(queue, planetState, MeshId::PlanetCube, 0.0f, 0.0f, z, 1.0f, 1.0f, 1.0f);
+        Submit(queue, ringState, MeshId::Ring, 0.0f, 0.0f, z, 1.0f, 1.0f, 1.0f);
+        Submit(queue, ringState, MeshId::Ring, 0.0f, 0.0f, z, 1.0f, 1.0f, 1.0f);
+        Submit(queue, explosionState, MeshId::Explosion, 0.0f, 0.0f, z, 1.0f, 1.0f, 1.0f);
+        Submit(queue, bulletState, MeshId::Bullet, 0.0f, 0.0f, z, 1.0f, 1.0f, 1.0f);
+    }
+
+    Submit(queue, explosionState, MeshId::Explosion, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f);
+    Submit(queue, bulletState, MeshId::Bullet, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f);
+    Submit(queue, bulletState, MeshId::Spaceship, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f);
+    Submit(queue, arrowState, MeshId::Arrow, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f);
+}
+
+struct StateResult {
+    RenderQueue::Stats queue;
+    GLStateCache::Counters calls;
+};
+
+static std::vector<StateResult> ReplayCommandStream() {
+    // A cache of its own, so the first frame starts from unknown state
+    // like the game's first frame does
+    GLStateCache gl;
+    RenderQueue queue(gl);
+    Camera camera;
+
+    std::vector<StateResult> results;
+    glPushAttrib(GL_ALL_ATTRIB_BITS);
+    for (int frame = 0; frame < frameCount; frame++) {
+        gl.ResetCounters();
+        queue.Begin(camera);
+        SubmitFrame(queue);
+        queue.Flush();
+        results.push_back({ queue.GetStats(), gl.GetCounters() });
+    }
+    glPopAttrib();
+    return results;
+}
+
+struct ListResult {
+    int threads;
+    double starsMs;     // Average star list build time
+    double renderMs;    // Average Galaxy::Render time, submission included
+    int vertices;
+};
+
+static ListResult BuildWithThreads(Galaxy& galaxy, Renderer3D* renderer, int threads) {
+    JobSystem& jobs = JobSystem::GetInstance();
+    jobs.Shutdown();
+    jobs.Initialize(threads - 1);
+
+    // Never flushed, so nothing reaches GL
+    GLStateCache gl;
+    RenderQueue queue(gl);
+
+    ListResult result = { threads, 0.0, 0.0, 0 };
+    for (int build = 0; build < WARMUP_BUILDS + buildCount; build++) {
+        FrameArena::GetInstance().Reset();
+        queue.Begin(renderer->GetCamera());
+
+        auto start = std::chrono::steady_clock::now();
+        galaxy.Render(queue);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        if (build >= WARMUP_BUILDS) {
+            result.renderMs += ms;
+            result.starsMs += galaxy.GetStarBuildMs();
+        }
+    }
+    result.renderMs /= buildCount;
+    result.starsMs /= buildCount;
+    result.vertices = galaxy.GetStarVertexCount();
+    return result;
+}
+
+bool RenderBenchmark::Run(const char* reportPath, const HeadlessRun::Context& context) {
+    Renderer3D* renderer = context.renderer;
+
+    std::vector<StateResult> stateResults = ReplayCommandStream();
+
+    // Every chunk in render distance loaded, no budget and no LOD, so every
+    // loaded star is drawn
+    const int side = 2 * STAR_RENDER_DISTANCE + 1;
+    GalaxySettings settings;
+    settings.renderDistance = STAR_RENDER_DISTANCE;
+    settings.starsPerChunk = (starCount + side * side * side - 1) / (side * side * side);
+    settings.starBudgetMB = 0.0f;
+    settings.chunkCacheMB = 0.0f;
+
+    srand(SEED);
+    Galaxy galaxy(renderer, settings, 0);
+    galaxy.GetStarLOD().enabled = false;
+    Spaceship ship;
+    ship.SetPosition(0.0f, 0.0f, 0.0f);
+    galaxy.SetSpaceship(&ship);
+    galaxy.Update(0.0f, renderer->GetCamera());
+    int loadedStars = galaxy.GetChunkStats().loadedStars;
+
+    std::vector<ListResult> listResults;
+    for (int threads = 1; ; threads *= 2) {
+        if (threads > maxThreads) threads = maxThreads;
+        listResults.push_back(BuildWithThreads(galaxy, renderer, threads));
+        if (threads == maxThreads) break;
+    }
+
+    JobSystem::GetInstance().Shutdown();
+    JobSystem::GetInstance().Initialize();
+
+    FILE* out = HeadlessRun::OpenReport(reportPath);
+    if (!out) return false;
+
+    fprintf(out, "slices=%d\n", sliceCount);
+    fprintf(out, "commands=%d\n", stateResults[0].queue.commands);
+
+    fprintf(out, "\n%-6s %10s %10s %16s %14s\n", "frame", "requested", "issued", "unsorted est.", "sorted state");
+    for (size_t i = 0; i < stateResults.size(); i++) {
+        const StateResult& result = stateResults[i];
+        fprintf(out, "%-6d %10d %10d %16d %14d\n", (int)i, result.calls.requested, result.calls.issued,
+            result.queue.stateChangesUnsorted, result.queue.stateChanges);
+    }
+
+    bool consistent = true;
+    for (const ListResult& result : listResults) {
+        consistent = consistent && result.vertices == loadedStars;
+    }
+
+    fprintf(out, "\nstars=%d\n", loadedStars);
+    fprintf(out, "builds=%d\n", buildCount);
+    fprintf(out, "hardware_threads=%u\n", std::thread::hardware_concurrency());
+    fprintf(out, "all_stars_drawn=%s\n", consistent ? "yes" : "no");
+
+    fprintf(out, "\n%-8s %12s %12s %10s %12s\n", "threads", "stars ms", "render ms", "speedup", "Mstars/s");
+    for (const ListResult& result : listResults) {
+        fprintf(out, "%-8d %12.3f %12.3f %10.2f %12.1f\n",
+            result.threads, result.starsMs, result.renderMs,
+            result.starsMs > 0.0 ? listResults[0].starsMs / result.starsMs : 0.0,
+            result.starsMs > 0.0 ? result.vertices / (result.starsMs * 1000.0) : 0.0);
+    }
+    fclose(out);
+    return consistent;
+}
@@ -0,0 +1,35 @@
+//------------------------------------------------------------------------
+// RenderBenchmark.h
+//------------------------------------------------------------------------
+#ifndef RENDER_BENCHMARK_H
+#define RENDER_BENCHMARK_H
+
+#include "HeadlessRun.h"
+
+// Two measurements in one headless run, see HeadlessRun.h.
+//
+// Replays a fixed command stream shaped like a galaxy frame through the
+// render queue and its GL state cache, and writes how many state calls
+// were requested against how many reached GL. The draw functions are
+// empty, so only state changes are counted.
+//
+// Then times building the star render lists for a galaxy with about a
+// million loaded stars, LOD off, with 1, 2, 4 ... job system threads.
+// Nothing is flushed to GL for this part. The run fails if any build
+// misses stars.
+//   GAMETEST_RENDER_BENCH_REPORT   report file, enables the benchmark
+//   GAMETEST_RENDER_BENCH_SLICES   job slices submitting lists, default 8
+//   GAMETEST_RENDER_BENCH_FRAMES   frames replayed, default 3
+//   GAMETEST_RENDER_BENCH_STARS    loaded stars, default 1000000
+//   GAMETEST_RENDER_BENCH_BUILDS   timed list builds per thread count, default 30
+//   GAMETEST_RENDER_BENCH_THREADS  highest thread count, default 16
+class RenderBenchmark {
+public:
+    // Settings besides GAMETEST_RENDER_BENCH_REPORT
+    static void ConfigureFromEnvironment();
+
+    // Leaves the job system with its default thread count afterwards
+    static bool Run(const char* reportPath, const HeadlessRun::Context& context);
+};
+
+#endif
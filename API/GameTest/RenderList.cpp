@@ -0,0 +1,101 @@
+//------------------------------------------------------------------------
+// RenderList.cpp
+//------------------------------------------------------------------------
+#include "stdafx.h"
+#include "RenderList.h"
+#include <math.h>
+
+Matrix34 Matrix34::Identity() {
+    Matrix34 result = { {
+        { 1.0f, 0.0f, 0.0f, 0.0f },
+        { 0.0f, 1.0f, 0.0f, 0.0f },
+        { 0.0f, 0.0f, 1.0f, 0.0f } } };
+    return result;
+}
+
+void Matrix34::Translate(float x, float y, float z) {
+    for (int row = 0; row < 3; row++) {
+        m[row][3] += m[row][0] * x + m[row][1] * y + m[row][2] * z;
+    }
+}
+
+void Matrix34::Rotate(float degrees, float ax, float ay, float az) {
+    float len = sqrtf(ax * ax + ay * ay + az * az);
+    if (len <= 0.0f) return;
+    ax /= len;
+    ay /= len;
+    az /= len;
+
+    float radians = degrees * 3.14159265f / 180.0f;
+    float c = cosf(radians);
+    float s = sinf(radians);
+    float t = 1.0f - c;
+
+    // Same matrix glRotatef builds
+    float r[3][3] = {
+        { t * ax * ax + c,      t * ax * ay - s * az, t * ax * az + s * ay },
+        { t * ax * ay + s * az, t * ay * ay + c,      t * ay * az - s * ax },
+        { t * ax * az - s * ay, t * ay * az + s * ax, t * az * az + c }
+    };
+
+    for (int row = 0; row < 3; row++) {
+        float m0 = m[row][0], m1 = m[row][1], m2 = m[row][2];
+        for (int col = 0; col < 3; col++) {
+            m[row][col] = m0 * r[0][col] + m1 * r[1][col] + m2 * r[2][col];
+        }
+    }
+}
+
+void Matrix34::Apply(float x, float y, float z, float& outX, float& outY, float& outZ) const {
+    outX = m[0][0] * x + m[0][1] * y + m[0][2] * z + m[0][3];
+    outY = m[1][0] * x + m[1][1] * y + m[1][2] * z + m[1][3];
+    outZ = m[2][0] * x + m[2][1] * y + m[2][2] * z + m[2][3];
+}
+
+static uint8_t ToByte(float value) {
+    if (value <= 0.0f) return 0;
+    if (value >= 1.0f) return 255;
+    return (uint8_t)(value * 255.0f + 0.5f);
+}
+
+void RenderList::Add(float x, float y, float z, float r, float g, float b, float a) {
+    RenderVertex v;
+    v.x = x;
+    v.y = y;
+    v.z = z;
+    v.r = ToByte(r);
+    v.g = ToByte(g);
+    v.b = ToByte(b);
+    v.a = ToByte(a);
+    vertices.push_back(v);
+}
+
+void RenderList::Add(float x, float y, float z, uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
+    RenderVertex v = { x, y, z, r, g, b, a };
+    vertices.push_back(v);
+}
+
+void RenderList::AddLine(float x0, float y0, float z0, float x1, float y1, float z1,
+    float r, float g, float b, float a) {
+    Add(x0, y0, z0, r, g, b, a);
+    Add(x1, y1, z1, r, g, b, a);
+}
+
+void RenderList::Draw(const RenderCommand& cmd, GLStateCache& gl) {
+    const RenderList& list = *static_cast<const RenderList*>(cmd.object);
+    if (list.vertices.empty()) return;
+
+    const RenderVertex* data = list.vertices.data();
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(3, GL_FLOAT, sizeof(RenderVertex), &data->x);
+    glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(RenderVertex), &data->r);
+
+    glDrawArrays(list.primitive, 0, (GLsizei)list.vertices.size());
+
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+
+    // The current colour is undefined after drawing with a colour array
+    gl.InvalidateColor();
+}
@@ -0,0 +1,53 @@
+//------------------------------------------------------------------------
+// RenderList.h
+//------------------------------------------------------------------------
+#ifndef RENDER_LIST_H
+#define RENDER_LIST_H
+
+#include <windows.h>
+#include <GL/gl.h>
+#include <vector>
+#include <cstdint>
+#include "RenderQueue.h"
+
+struct RenderVertex {
+    float x, y, z;
+    uint8_t r, g, b, a;
+};
+
+// CPU side affine transform, composed the same way glTranslatef/glRotatef
+// compose onto the modelview matrix.
+struct Matrix34 {
+    float m[3][4];
+
+    static Matrix34 Identity();
+    void Translate(float x, float y, float z);
+    void Rotate(float degrees, float ax, float ay, float az);
+    void Apply(float x, float y, float z, float& outX, float& outY, float& outZ) const;
+};
+
+// World space vertices built off the GL thread and drawn with one
+// glDrawArrays call on it.
+class RenderList {
+public:
+    explicit RenderList(GLenum primitive = GL_LINES) : primitive(primitive) {}
+
+    void Clear() { vertices.clear(); }
+    bool IsEmpty() const { return vertices.empty(); }
+    int GetVertexCount() const { return (int)vertices.size(); }
+
+    void Add(float x, float y, float z, float r, float g, float b, float a = 1.0f);
+    void Add(float x, float y, float z, uint8_t r, uint8_t g, uint8_t b, uint8_t a);
+    void AddLine(float x0, float y0, float z0, float x1, float y1, float z1,
+        float r, float g, float b, float a = 1.0f);
+
+    // Render queue draw callback, cmd.object is the RenderList
+    static void Draw(const RenderCommand& cmd, GLStateCache& gl);
+
+    GLenum primitive;
+
+private:
+    std::vector<RenderVertex> vertices;
+};
+
+#endif
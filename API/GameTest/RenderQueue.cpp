@@ -0,0 +1,157 @@
+//------------------------------------------------------------------------
+// RenderQueue.cpp
+//------------------------------------------------------------------------
+#include "stdafx.h"
+#include "RenderQueue.h"
+#include "Renderer3D.h"
+#include <algorithm>
+#include <math.h>
+#include <App/AppSettings.h>
+
+const float RenderQueue::MAX_DEPTH = 10000.0f;  // Matches the far plane
+
+RenderQueue::RenderQueue(GLStateCache& gl) : gl(gl), inOverlay(false), camX(0.0f), camY(0.0f), camZ(0.0f) {
+}
+
+void RenderQueue::Begin(const Camera& camera) {
+    camera.GetPosition(camX, camY, camZ);
+    commands.clear();
+}
+
+RenderCommand& RenderQueue::Submit(const RenderState& state, MeshId mesh, DrawFunc draw,
+    float x, float y, float z) {
+    float dx = x - camX;
+    float dy = y - camY;
+    float dz = z - camZ;
+    float depth = sqrtf(dx * dx + dy * dy + dz * dz);
+
+    RenderCommand cmd;
+    cmd.sortKey = MakeSortKey(state, mesh, depth, (uint32_t)commands.size());
+    cmd.state = state;
+    cmd.draw = draw;
+    cmd.object = nullptr;
+    cmd.x = x;
+    cmd.y = y;
+    cmd.z = z;
+    cmd.angle = 0.0f;
+    cmd.scale = 1.0f;
+    cmd.r = cmd.g = cmd.b = cmd.a = 1.0f;
+    commands.push_back(cmd);
+    return commands.back();
+}
+
+// Key layout, most significant first:
+// pass:2 | blend:2 | depthTest:1 | lighting:1 | wireframe:1 | pointSmooth:1 |
+// lineWidth:4 | mesh:8 | depth:24 | sequence:20
+uint64_t RenderQueue::MakeSortKey(const RenderState& state, MeshId mesh, float depth, uint32_t sequence) const {
+    uint64_t lineWidth = (uint64_t)std::min(15.0f, state.lineWidth * 2.0f);
+
+    float normalizedDepth = std::min(std::max(depth / MAX_DEPTH, 0.0f), 1.0f);
+    uint64_t depthBits = (uint64_t)(normalizedDepth * 0xFFFFFF);
+    if (state.pass == RenderPass::Transparent) {
+        depthBits = 0xFFFFFF - depthBits;  // Back to front
+    }
+    else if (state.pass == RenderPass::Overlay) {
+        depthBits = 0;                     // Keep submission order
+    }
+
+    uint64_t key = 0;
+    key |= (uint64_t)state.pass << 62;
+    key |= (uint64_t)state.blend << 60;
+    key |= (uint64_t)state.depthTest << 59;
+    key |= (uint64_t)state.lighting << 58;
+    key |= (uint64_t)state.wireframe << 57;
+    key |= (uint64_t)state.pointSmooth << 56;
+    key |= lineWidth << 52;
+    key |= (uint64_t)mesh << 44;
+    key |= depthBits << 20;
+    key |= (uint64_t)(sequence & 0xFFFFF);
+    return key;
+}
+
+// Estimate of the GL calls needed to go from one state to the other,
+// used to report what replaying in submission order would have cost.
+int RenderQueue::CountStateChanges(const RenderState& from, const RenderState& to) {
+    int count = 0;
+    if ((from.pass == RenderPass::Overlay) != (to.pass == RenderPass::Overlay)) count++;
+    if (from.blend != to.blend) {
+        if (to.blend == BlendMode::Opaque) count++;
+        else count += (from.blend == BlendMode::Opaque) ? 2 : 1;
+    }
+    if (from.depthTest != to.depthTest) count++;
+    if (from.lighting != to.lighting) count++;
+    if (from.wireframe != to.wireframe) count++;
+    if (from.pointSmooth != to.pointSmooth) count++;
+    if (from.lineWidth != to.lineWidth) count++;
+    return count;
+}
+
+void RenderQueue::ApplyState(const RenderState& state) {
+    bool overlay = state.pass == RenderPass::Overlay;
+    if (overlay != inOverlay) {
+        if (overlay) BeginOverlay();
+        else EndOverlay();
+        inOverlay = overlay;
+        stats.stateChanges++;
+    }
+
+    gl.SetEnabled(GL_BLEND, state.blend != BlendMode::Opaque);
+    if (state.blend != BlendMode::Opaque) {
+        gl.BlendFunc(GL_SRC_ALPHA, state.blend == BlendMode::Additive ? GL_ONE : GL_ONE_MINUS_SRC_ALPHA);
+    }
+    gl.SetEnabled(GL_DEPTH_TEST, state.depthTest);
+    gl.SetEnabled(GL_LIGHTING, state.lighting);
+    gl.PolygonMode(state.wireframe ? GL_LINE : GL_FILL);
+    gl.SetEnabled(GL_POINT_SMOOTH, state.pointSmooth);
+    gl.LineWidth(state.lineWidth);
+}
+
+void RenderQueue::BeginOverlay() {
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadIdentity();
+    glOrtho(0, APP_VIRTUAL_WIDTH, APP_VIRTUAL_HEIGHT, 0, -1, 1);
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glLoadIdentity();
+}
+
+void RenderQueue::EndOverlay() {
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+    glPopMatrix();
+}
+
+void RenderQueue::Flush() {
+    stats = Stats();
+    stats.commands = (int)commands.size();
+    if (commands.empty()) return;
+
+    // Cost of replaying in the order objects submitted, for comparison
+    for (size_t i = 1; i < commands.size(); i++) {
+        stats.stateChangesUnsorted += CountStateChanges(commands[i - 1].state, commands[i].state);
+    }
+
+    std::sort(commands.begin(), commands.end(),
+        [](const RenderCommand& a, const RenderCommand& b) { return a.sortKey < b.sortKey; });
+
+    inOverlay = false;
+
+    for (const RenderCommand& cmd : commands) {
+        // The cache knows what actually reached GL
+        int issuedBefore = gl.GetCounters().issued;
+        ApplyState(cmd.state);
+        stats.stateChanges += gl.GetCounters().issued - issuedBefore;
+
+        gl.Color(cmd.r, cmd.g, cmd.b, cmd.a);
+        cmd.draw(cmd, gl);
+    }
+
+    if (inOverlay) {
+        EndOverlay();
+        inOverlay = false;
+    }
+
+    commands.clear();
+}
@@ -0,0 +1,99 @@
+//------------------------------------------------------------------------
+// RenderQueue.h
+//------------------------------------------------------------------------
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <windows.h>
+#include <GL/gl.h>
+#include <vector>
+#include <cstdint>
+#include "GLStateCache.h"
+
+class Camera;
+
+// Passes are drawn in this order. Background is drawn without depth test,
+// so it has to come before anything that writes depth.
+enum class RenderPass : uint8_t {
+    Background = 0,
+    Opaque = 1,
+    Transparent = 2,
+    Overlay = 3     // 2D, virtual resolution ortho projection
+};
+
+enum class BlendMode : uint8_t {
+    Opaque = 0,
+    Alpha = 1,      // GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA
+    Additive = 2    // GL_SRC_ALPHA, GL_ONE
+};
+
+// Mesh ids only group identical geometry together in the sort.
+enum class MeshId : uint8_t {
+    Stars,
+    PlanetCube,
+    PlanetShell,
+    Ring,
+    Bullet,
+    Explosion,
+    Spaceship,
+    Arrow
+};
+
+struct RenderState {
+    RenderPass pass = RenderPass::Opaque;
+    BlendMode blend = BlendMode::Opaque;
+    bool depthTest = true;
+    bool lighting = false;
+    bool wireframe = false;      // glPolygonMode GL_LINE
+    bool pointSmooth = false;
+    float lineWidth = 1.0f;
+};
+
+struct RenderCommand;
+typedef void (*DrawFunc)(const RenderCommand& cmd, GLStateCache& gl);
+
+struct RenderCommand {
+    uint64_t sortKey;
+    RenderState state;
+    DrawFunc draw;           // Issues the geometry, state and colour are already set
+    const void* object;      // Whatever the draw function needs to read
+    float x, y, z;           // World position, also used for depth sorting
+    float angle;             // Rotation around Z in degrees
+    float scale;
+    float r, g, b, a;
+};
+
+class RenderQueue {
+public:
+    struct Stats {
+        int commands = 0;
+        int stateChangesUnsorted = 0;  // What submission order would have cost
+        int stateChanges = 0;          // What was actually issued
+    };
+
+    RenderQueue(GLStateCache& gl);
+
+    void Begin(const Camera& camera);
+    RenderCommand& Submit(const RenderState& state, MeshId mesh, DrawFunc draw,
+        float x, float y, float z);
+    void Flush();
+
+    const Stats& GetStats() const { return stats; }
+
+private:
+    std::vector<RenderCommand> commands;
+    GLStateCache& gl;
+    bool inOverlay;
+    Stats stats;
+    float camX, camY, camZ;
+
+    static const float MAX_DEPTH;
+
+    uint64_t MakeSortKey(const RenderState& state, MeshId mesh, float depth, uint32_t sequence) const;
+    static int CountStateChanges(const RenderState& from, const RenderState& to);
+    void ApplyState(const RenderState& state);
+    void BeginOverlay();
+    void EndOverlay();
+};
+
+#endif
@@ -24,17 +24,17 @@ void Camera::Apply() {
     glTranslatef(-posX, -posY, -posZ);
 }
 
-Renderer3D::Renderer3D() : screenWidth(800), screenHeight(600) {
+Renderer3D::Renderer3D() : renderQueue(stateCache), screenWidth(800), screenHeight(600) {
 }
 
 void Renderer3D::Initialize(int width, int height) {
     screenWidth = width;
     screenHeight = height;
 
-    glEnable(GL_DEPTH_TEST);
+    stateCache.Enable(GL_DEPTH_TEST);
 
     // Enable lighting
-    glEnable(GL_LIGHTING);
+    stateCache.Enable(GL_LIGHTING);
     glEnable(GL_LIGHT0);
 
     // Set up ambient light
@@ -81,7 +81,7 @@ void Renderer3D::UpdateLight(float x, float y, float z) {
 void Renderer3D::DrawCube(float x, float y, float z, float size, float r, float g, float b) {
     glPushMatrix();
     glTranslatef(x, y, z);
-    glColor3f(r, g, b);
+    stateCache.Color(r, g, b);
 
     float halfSize = size * 0.5f;
     glBegin(GL_QUADS);
@@ -135,7 +135,7 @@ void Renderer3D::DrawCube(float x, float y, float z, float size, float r, float
 void Renderer3D::DrawPyramid(float x, float y, float z, float size, float r, float g, float b) {
     glPushMatrix();
     glTranslatef(x, y, z);
-    glColor3f(r, g, b);
+    stateCache.Color(r, g, b);
 
     float halfSize = size * 0.5f;
     glBegin(GL_TRIANGLES);
@@ -180,7 +180,7 @@ void Renderer3D::DrawPyramid(float x, float y, float z, float size, float r, flo
 void Renderer3D::DrawSphere(float x, float y, float z, float radius, float r, float g, float b) {
     glPushMatrix();
     glTranslatef(x, y, z);
-    glColor3f(r, g, b);
+    stateCache.Color(r, g, b);
 
     GLUquadric* quadric = gluNewQuadric();
     gluQuadricNormals(quadric, GLU_SMOOTH);
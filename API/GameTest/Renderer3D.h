@@ -7,6 +7,8 @@
 #include <windows.h>
 #include <GL/gl.h>
 #include <GL/glu.h>
+#include "GLStateCache.h"
+#include "RenderQueue.h"
 
 class Camera {
 public:
@@ -60,9 +62,13 @@ public:
     void DrawSphere(float x, float y, float z, float radius, float r, float g, float b);
     void UpdateLight(float x, float y, float z);
     Camera& GetCamera() { return camera; }
+    RenderQueue& GetRenderQueue() { return renderQueue; }
+    GLStateCache& GetStateCache() { return stateCache; }
 
 private:
     Camera camera;
+    GLStateCache stateCache;   // Must be declared before renderQueue
+    RenderQueue renderQueue;
     int screenWidth;
     int screenHeight;
 };
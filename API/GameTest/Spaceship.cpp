@@ -117,33 +117,54 @@ void Spaceship::FireBullet() {
     bullets.emplace_back(spawnX, spawnY, rotZ - 90.0f);
 }
 
-void Spaceship::Render() {
+void Spaceship::Render(RenderQueue& queue) {
     // Render explosions
+    explosionLines.Clear();
     for (auto& explosion : explosions) {
-        explosion.Render(true);
+        explosion.BuildVertices(explosionLines, true);
+    }
+    if (!explosionLines.IsEmpty()) {
+        RenderState explosionState;
+        explosionState.pass = RenderPass::Transparent;
+        explosionState.blend = BlendMode::Alpha;
+        explosionState.lineWidth = 2.0f;
+
+        RenderCommand& cmd = queue.Submit(explosionState, MeshId::Explosion, &RenderList::Draw, posX, posY, posZ);
+        cmd.object = &explosionLines;
     }
 
     // Render bullets
+    bulletLines.Clear();
     for (auto& bullet : bullets) {
-        bullet.Render(true);
+        bullet.BuildVertices(bulletLines, true);
+    }
+    if (!bulletLines.IsEmpty()) {
+        RenderState bulletState;
+        bulletState.pass = RenderPass::Opaque;
+        bulletState.wireframe = true;
+
+        RenderCommand& cmd = queue.Submit(bulletState, MeshId::Bullet, &RenderList::Draw, posX, posY, posZ);
+        cmd.object = &bulletLines;
     }
 
     if (!isAlive) return;
 
-    glPushMatrix();
-    glPushAttrib(GL_ALL_ATTRIB_BITS);
+    RenderState state;
+    state.pass = RenderPass::Opaque;
+    state.wireframe = true;
 
-    glTranslatef(posX, posY, posZ);
-    glRotatef(rotZ, 0.0f, 0.0f, 1.0f);
+    RenderCommand& cmd = queue.Submit(state, MeshId::Spaceship, &Spaceship::DrawHull, posX, posY, posZ);
+    cmd.angle = rotZ;
 
     // Set purple color
-    glColor4f(1.0f, 0.0f, 1.0f, 1.0f); // Purple
+    cmd.r = 1.0f; cmd.g = 0.0f; cmd.b = 1.0f; cmd.a = 1.0f;
+}
 
-    // Enable wireframe mode
-    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+void Spaceship::DrawHull(const RenderCommand& cmd, GLStateCache& gl) {
+    glPushMatrix();
 
-    // Disable lighting
-    glDisable(GL_LIGHTING);
+    glTranslatef(cmd.x, cmd.y, cmd.z);
+    glRotatef(cmd.angle, 0.0f, 0.0f, 1.0f);
 
     // Draw cone
     glBegin(GL_TRIANGLES);
@@ -171,6 +192,5 @@ void Spaceship::Render() {
 
     glEnd();
 
-    glPopAttrib();
     glPopMatrix();
 }
\ No newline at end of file
@@ -4,10 +4,12 @@
 #ifndef SPACESHIP_H
 #define SPACESHIP_H
 
+#include "RenderList.h"
+
 class Spaceship {
 public:
     Spaceship();
-    void Render();
+    void Render(RenderQueue& queue);
     void Update(float deltaTime);
     void Move(float dx, float dy);
     void LookAt(float mouseX, float mouseY);  // New function for mouse look
@@ -46,6 +48,7 @@ private:
     float fireTimer;           // New: Timer for shooting
     std::vector<Bullet> bullets;
     void FireBullet();
+    static void DrawHull(const RenderCommand& cmd, GLStateCache& gl);
 
     float posX, posY, posZ;    // Position
     float rotX, rotY, rotZ;    // Rotation
@@ -58,6 +61,9 @@ private:
     static constexpr float DECELERATION = 0.98f;    // Deceleration factor
 
     std::vector<ExplosionEffect> explosions;
+
+    RenderList bulletLines;
+    RenderList explosionLines;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,192 @@
+//------------------------------------------------------------------------
+// SpriteBenchmark.cpp
+//------------------------------------------------------------------------
+#include "stdafx.h"
+#include "SpriteBenchmark.h"
+#include "Renderer3D.h"
+#include <App/app.h>
+#include <App/SpriteBatch.h>
+#include <App/SpriteAtlas.h>
+#include <App/TextureManager.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <windows.h>
+
+static int spriteCount = 50000;
+static int frameCount = 60;
+
+static const int WARMUP_FRAMES = 5;
+static const int SHEET_COUNT = 8;
+static const int SHEET_SIZE = 128;
+static const int SHEET_FRAMES = 4;     // Columns and rows of each sheet
+static const unsigned int SEED = 1234;
+static const float ANIMATION_SPEED = 1.0f / 15.0f;
+static const float UPDATE_MS = 1000.0f / 60.0f;
+
+void SpriteBenchmark::ConfigureFromEnvironment() {
+    spriteCount = HeadlessRun::GetInt("GAMETEST_SPRITE_BENCH_SPRITES", spriteCount);
+    frameCount = HeadlessRun::GetInt("GAMETEST_SPRITE_BENCH_FRAMES", frameCount);
+    if (spriteCount < 1) spriteCount = 1;
+    if (frameCount < 1) frameCount = 1;
+}
+
+// A sheet of round blobs in a colour of its own, so the sheets are told apart
+static std::vector<unsigned char> MakeSheet(int sheet) {
+    std::vector<unsigned char> pixels(SHEET_SIZE * SHEET_SIZE * 4);
+    int cell = SHEET_SIZE / SHEET_FRAMES;
+    for (int y = 0; y < SHEET_SIZE; y++) {
+        for (int x = 0; x < SHEET_SIZE; x++) {
+            int dx = x % cell - cell / 2;
+            int dy = y % cell - cell / 2;
+            unsigned char* pixel = &pixels[(y * SHEET_SIZE + x) * 4];
+            pixel[0] = (unsigned char)(sheet & 1 ? 255 : 64);
+            pixel[1] = (unsigned char)(sheet & 2 ? 255 : 64);
+            pixel[2] = (unsigned char)(sheet & 4 ? 255 : 64);
+            pixel[3] = (unsigned char)(dx * dx + dy * dy < cell * cell / 4 ? 255 : 0);
+        }
+    }
+    return pixels;
+}
+
+struct SpriteResult {
+    const char* method;
+    double frameMs;     // Average time from the first draw to glFinish
+    int drawCalls;      // Per frame
+};
+
+static SpriteResult TimeFrames(const char* method, std::vector<CSimpleSprite>& sprites, CSpriteBatch* batch,
+    GLStateCache& gl) {
+    SpriteResult result = { method, 0.0, 0 };
+    for (int frame = 0; frame < WARMUP_FRAMES + frameCount; frame++) {
+        glClear(GL_COLOR_BUFFER_BIT);
+        auto start = std::chrono::steady_clock::now();
+        if (batch) {
+            batch->Begin();
+            for (CSimpleSprite& sprite : sprites) {
+                sprite.Draw(*batch);
+            }
+            batch->Flush(gl);
+            result.drawCalls = batch->GetStats().m_drawCalls;
+        }
+        else {
+            for (CSimpleSprite& sprite : sprites) {
+                sprite.Draw(gl);
+            }
+            result.drawCalls = (int)sprites.size();
+        }
+        glFinish();
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (frame >= WARMUP_FRAMES) result.frameMs += ms;
+    }
+    result.frameMs /= frameCount;
+    return result;
+}
+
+// The same crowd, each sprite from a random sheet, frame, place and angle.
+static std::vector<CSimpleSprite> MakeSprites(const std::string& prefix) {
+    srand(SEED);
+    std::vector<CSimpleSprite> sprites;
+    sprites.reserve(spriteCount);
+    for (int i = 0; i < spriteCount; i++) {
+        std::string name = prefix + std::to_string(rand() % SHEET_COUNT);
+        sprites.emplace_back(name.c_str(), SHEET_FRAMES, SHEET_FRAMES);
+        CSimpleSprite& sprite = sprites.back();
+        sprite.SetFrame(rand() % (SHEET_FRAMES * SHEET_FRAMES));
+        sprite.SetPosition(FRAND * APP_VIRTUAL_WIDTH, FRAND * APP_VIRTUAL_HEIGHT);
+        sprite.SetAngle(FRAND * 2.0f * PI);
+        sprite.SetScale(0.5f + FRAND);
+    }
+    return sprites;
+}
+
+// Average time for one Update of every sprite, each playing through its sheet
+static double TimeAnimation(std::vector<CSimpleSprite>& sprites) {
+    std::vector<int> frames;
+    for (int i = 0; i < SHEET_FRAMES * SHEET_FRAMES; i++) {
+        frames.push_back(i);
+    }
+    for (CSimpleSprite& sprite : sprites) {
+        sprite.CreateAnimation(0, ANIMATION_SPEED, frames);
+        sprite.SetAnimation(0, true);
+    }
+
+    double total = 0.0;
+    for (int frame = 0; frame < WARMUP_FRAMES + frameCount; frame++) {
+        auto start = std::chrono::steady_clock::now();
+        for (CSimpleSprite& sprite : sprites) {
+            sprite.Update(UPDATE_MS);
+        }
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (frame >= WARMUP_FRAMES) total += ms;
+    }
+    return total / frameCount;
+}
+
+bool SpriteBenchmark::Run(const char* reportPath, const HeadlessRun::Context& context) {
+    Renderer3D* renderer = context.renderer;
+
+    // Every sheet as a texture of its own, and all of them in one atlas
+    CSpriteAtlas atlas;
+    for (int sheet = 0; sheet < SHEET_COUNT; sheet++) {
+        std::vector<unsigned char> pixels = MakeSheet(sheet);
+        CSpriteAtlas single;
+        single.AddImage("sheet" + std::to_string(sheet), SHEET_SIZE, SHEET_SIZE, pixels.data());
+        single.Build(SHEET_SIZE * 2, SHEET_SIZE * 2);
+        atlas.AddImage("atlas sheet" + std::to_string(sheet), SHEET_SIZE, SHEET_SIZE, pixels.data());
+    }
+    int packed = atlas.Build(1024, 1024);
+
+    // Sprites draw in native coordinates
+    GLStateCache& gl = renderer->GetStateCache();
+    gl.Disable(GL_DEPTH_TEST);
+    gl.Disable(GL_LIGHTING);
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadIdentity();
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glLoadIdentity();
+
+    std::vector<SpriteResult> results;
+    CSpriteBatch batch;
+    double animationMs = 0.0;
+    {
+        std::vector<CSimpleSprite> sprites = MakeSprites("sheet");
+        results.push_back(TimeFrames("immediate", sprites, nullptr, gl));
+        results.push_back(TimeFrames("batched", sprites, &batch, gl));
+        animationMs = TimeAnimation(sprites);
+    }
+    {
+        std::vector<CSimpleSprite> sprites = MakeSprites("atlas sheet");
+        results.push_back(TimeFrames("batched atlas", sprites, &batch, gl));
+    }
+
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+    glPopMatrix();
+
+    FILE* out = HeadlessRun::OpenReport(reportPath);
+    if (!out) return false;
+
+    fprintf(out, "sprites=%d\n", spriteCount);
+    fprintf(out, "frames=%d\n", frameCount);
+    fprintf(out, "sheets=%d\n", SHEET_COUNT);
+    fprintf(out, "atlas=%dx%d, %d of %d sheets packed\n", atlas.GetWidth(), atlas.GetHeight(), packed, SHEET_COUNT);
+    fprintf(out, "animation update=%.3f ms per frame\n", animationMs);
+    CTextureManager::sStats textures = CTextureManager::GetInstance().GetStats();
+    fprintf(out, "textures=%d resident, %d referenced, %.1f / %.1f MB, %d retired (%.1f MB)\n", textures.m_resident,
+        textures.m_referenced, textures.m_residentBytes / (1024.0 * 1024.0), textures.m_budgetBytes / (1024.0 * 1024.0),
+        textures.m_retired, textures.m_retiredBytes / (1024.0 * 1024.0));
+
+    fprintf(out, "\n%-16s %12s %12s %10s\n", "method", "frame ms", "draw calls", "speedup");
+    for (const SpriteResult& result : results) {
+        fprintf(out, "%-16s %12.3f %12d %10.2f\n", result.method, result.frameMs, result.drawCalls,
+            result.frameMs > 0.0 ? results[0].frameMs / result.frameMs : 0.0);
+    }
+    fclose(out);
+    return true;
+}
@@ -0,0 +1,26 @@
+//------------------------------------------------------------------------
+// SpriteBenchmark.h
+//------------------------------------------------------------------------
+#ifndef SPRITE_BENCHMARK_H
+#define SPRITE_BENCHMARK_H
+
+#include "HeadlessRun.h"
+
+// Draws a crowd of CSimpleSprites from several sprite sheets three ways:
+// one Draw call per sprite, through a CSpriteBatch, and through a
+// CSpriteBatch with the sheets packed into one CSpriteAtlas. Writes the
+// frame time and draw calls of each. It also times animating the crowd.
+// SpriteUVCheck checks the frames' UVs. Needs the GL context, so it runs
+// from Init.
+// A headless run, see HeadlessRun.h:
+//   GAMETEST_SPRITE_BENCH_REPORT   report file, enables the benchmark
+//   GAMETEST_SPRITE_BENCH_SPRITES  sprites per frame, default 50000
+//   GAMETEST_SPRITE_BENCH_FRAMES   timed frames per method, default 60
+class SpriteBenchmark {
+public:
+    // Settings besides GAMETEST_SPRITE_BENCH_REPORT
+    static void ConfigureFromEnvironment();
+    static bool Run(const char* reportPath, const HeadlessRun::Context& context);
+};
+
+#endif
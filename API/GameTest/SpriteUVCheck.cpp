@@ -0,0 +1,85 @@
+//------------------------------------------------------------------------
+// SpriteUVCheck.cpp
+//------------------------------------------------------------------------
+#include "stdafx.h"
+#include "SpriteUVCheck.h"
+#include <App/app.h>
+#include <App/TextureManager.h>
+#include <stdio.h>
+#include <math.h>
+#include <windows.h>
+
+static const char* const REGION_NAME = "sprite uv check";
+static const unsigned int REGION_SIZE = 128;
+static const float REGION[4] = { 0.25f, 0.5f, 0.75f, 1.0f };   // u0, v0, u1, v1
+static const float TOLERANCE = 1e-6f;
+
+// Corners in Draw's order: bottom left, bottom right, top right, top left
+struct UVCase {
+    unsigned int columns, rows;
+    unsigned int frame;
+    float uvs[8];
+};
+static const UVCase CASES[] = {
+    { 4, 4, 0,  { 0.25f, 0.625f, 0.375f, 0.625f, 0.375f, 0.5f, 0.25f, 0.5f } },
+    { 4, 4, 5,  { 0.375f, 0.75f, 0.5f, 0.75f, 0.5f, 0.625f, 0.375f, 0.625f } },
+    { 4, 4, 6,  { 0.5f, 0.75f, 0.625f, 0.75f, 0.625f, 0.625f, 0.5f, 0.625f } },
+    { 4, 4, 15, { 0.625f, 1.0f, 0.75f, 1.0f, 0.75f, 0.875f, 0.625f, 0.875f } },
+    // The region's bottom right quarter
+    { 2, 2, 3,  { 0.5f, 1.0f, 0.75f, 1.0f, 0.75f, 0.75f, 0.5f, 0.75f } },
+};
+
+static bool CheckCase(FILE* out, const UVCase& expected) {
+    CSimpleSprite sprite(REGION_NAME, expected.columns, expected.rows);
+    sprite.SetFrame(expected.frame);
+    const float* uvs = sprite.GetUVs();
+    bool match = true;
+    for (int c = 0; c < 8; c++) {
+        match = match && fabsf(uvs[c] - expected.uvs[c]) <= TOLERANCE;
+    }
+
+    fprintf(out, "%ux%u frame %-3u", expected.columns, expected.rows, expected.frame);
+    for (int c = 0; c < 8; c++) {
+        fprintf(out, " %.4f", uvs[c]);
+    }
+    fprintf(out, "  %s\n", match ? "ok" : "MISMATCH");
+    return match;
+}
+
+bool SpriteUVCheck::Run(const char* reportPath, const HeadlessRun::Context& context) {
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    CSimpleSprite::AddTextureRegion(REGION_NAME, texture, REGION_SIZE, REGION_SIZE, REGION[0], REGION[1], REGION[2], REGION[3]);
+
+    FILE* out = HeadlessRun::OpenReport(reportPath);
+    if (!out) {
+        CTextureManager::GetInstance().RetireTexture(texture, 0);
+        return false;
+    }
+
+    fprintf(out, "region=%g %g %g %g\n\n", REGION[0], REGION[1], REGION[2], REGION[3]);
+    int mismatches = 0;
+    for (const UVCase& expected : CASES) {
+        if (!CheckCase(out, expected)) mismatches++;
+    }
+
+    // Same texture and grid, so the same frame is the same table entry
+    bool shared;
+    {
+        CSimpleSprite first(REGION_NAME, 4, 4);
+        CSimpleSprite second(REGION_NAME, 4, 4);
+        first.SetFrame(5);
+        second.SetFrame(5);
+        shared = first.GetUVs() == second.GetUVs();
+    }
+    if (!shared) mismatches++;
+
+    fprintf(out, "\nshared_table=%s\n", shared ? "yes" : "no");
+    fprintf(out, "mismatches=%d\n", mismatches);
+    fprintf(out, "passed=%s\n", mismatches == 0 ? "yes" : "no");
+    fclose(out);
+
+    // Every sprite is gone, so the region goes with the texture
+    CTextureManager::GetInstance().RetireTexture(texture, 0);
+    return mismatches == 0;
+}
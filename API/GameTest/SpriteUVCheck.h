@@ -0,0 +1,21 @@
+//------------------------------------------------------------------------
+// SpriteUVCheck.h
+//------------------------------------------------------------------------
+#ifndef SPRITE_UV_CHECK_H
+#define SPRITE_UV_CHECK_H
+
+#include "HeadlessRun.h"
+
+// Registers a texture region like a sheet packed into a CSpriteAtlas and
+// checks CSimpleSprite frames in it against UVs worked out by hand, and
+// that sprites of the same texture and grid share one sheet table. Writes
+// each frame's UVs and fails the run on any mismatch. Nothing is drawn.
+// A headless run, see HeadlessRun.h:
+//   GAMETEST_SPRITE_UV_CHECK_REPORT  report file, enables the check
+class SpriteUVCheck {
+public:
+    // Returns false on a mismatch or if the report can't be written
+    static bool Run(const char* reportPath, const HeadlessRun::Context& context);
+};
+
+#endif
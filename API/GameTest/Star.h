@@ -0,0 +1,74 @@
+//------------------------------------------------------------------------
+// Star.h
+//------------------------------------------------------------------------
+#ifndef STAR_H
+#define STAR_H
+
+#include <cstdint>
+
+// Full precision star, only used while generating a chunk
+struct Star {
+    float x, y, z;
+    float brightness;
+    float size;
+    float r, g, b;
+};
+
+// Chunk storage format, 10 bytes instead of 32. Positions are 16 bit fixed
+// point relative to the chunk origin, which keeps them within about
+// chunkSize / 131070 of the generated position (under 0.001 units for 100
+// unit chunks). Colour is RGB565, brightness and size are bytes.
+struct PackedStar {
+    static constexpr float MAX_SIZE = 4.0f;
+
+    uint16_t x, y, z;
+    uint16_t rgb565;
+    uint8_t brightness;
+    uint8_t size;
+
+    static PackedStar Pack(const Star& star, float originX, float originY, float originZ, float chunkSize) {
+        PackedStar packed;
+        packed.x = PackPosition(star.x - originX, chunkSize);
+        packed.y = PackPosition(star.y - originY, chunkSize);
+        packed.z = PackPosition(star.z - originZ, chunkSize);
+        packed.rgb565 = (uint16_t)((PackUnit(star.r, 31) << 11) | (PackUnit(star.g, 63) << 5) | PackUnit(star.b, 31));
+        packed.brightness = (uint8_t)PackUnit(star.brightness, 255);
+        packed.size = (uint8_t)PackUnit(star.size / MAX_SIZE, 255);
+        return packed;
+    }
+
+    // Colour expanded to 8 bits per channel, low bits filled from the high ones
+    uint8_t GetR8() const { uint8_t r = (uint8_t)(rgb565 >> 11); return (uint8_t)((r << 3) | (r >> 2)); }
+    uint8_t GetG8() const { uint8_t g = (uint8_t)((rgb565 >> 5) & 63); return (uint8_t)((g << 2) | (g >> 4)); }
+    uint8_t GetB8() const { uint8_t b = (uint8_t)(rgb565 & 31); return (uint8_t)((b << 3) | (b >> 2)); }
+
+    float GetBrightness() const { return brightness / 255.0f; }
+    float GetSize() const { return size * (MAX_SIZE / 255.0f); }
+
+    static float PositionScale(float chunkSize) { return chunkSize / 65535.0f; }
+
+private:
+    static uint16_t PackPosition(float offset, float chunkSize) {
+        float t = offset / chunkSize;
+        if (t <= 0.0f) return 0;
+        if (t >= 1.0f) return 65535;
+        return (uint16_t)(t * 65535.0f + 0.5f);
+    }
+
+    static unsigned PackUnit(float value, unsigned maxValue) {
+        if (value <= 0.0f) return 0;
+        if (value >= 1.0f) return maxValue;
+        return (unsigned)(value * maxValue + 0.5f);
+    }
+};
+
+struct ChunkKey {
+    int x, y, z;
+    bool operator<(const ChunkKey& other) const {
+        if (x != other.x) return x < other.x;
+        if (y != other.y) return y < other.y;
+        return z < other.z;
+    }
+};
+
+#endif
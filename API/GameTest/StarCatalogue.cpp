@@ -0,0 +1,189 @@
+//------------------------------------------------------------------------
+// StarCatalogue.cpp
+//------------------------------------------------------------------------
+#include "stdafx.h"
+#include "StarCatalogue.h"
+#include <stdio.h>
+#include <algorithm>
+#include <DebugUtils.h>
+
+static bool EntryLess(const StarCatalogueEntry& entry, const ChunkKey& key) {
+    if (entry.x != key.x) return entry.x < key.x;
+    if (entry.y != key.y) return entry.y < key.y;
+    return entry.z < key.z;
+}
+
+StarCatalogue::StarCatalogue()
+    : file(INVALID_HANDLE_VALUE),
+    mapping(nullptr),
+    view(nullptr),
+    viewSize(0),
+    header(nullptr),
+    directory(nullptr)
+{
+}
+
+StarCatalogue::~StarCatalogue() {
+    Close();
+}
+
+bool StarCatalogue::Open(const char* path) {
+    Close();
+
+    file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        DebugPrint("StarCatalogue: can't open %s\n", path);
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart < (long long)sizeof(StarCatalogueHeader)) {
+        DebugPrint("StarCatalogue: %s is too small\n", path);
+        Close();
+        return false;
+    }
+
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping) {
+        view = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    }
+    if (!view) {
+        DebugPrint("StarCatalogue: can't map %s\n", path);
+        Close();
+        return false;
+    }
+    viewSize = (uint64_t)size.QuadPart;
+
+    header = reinterpret_cast<const StarCatalogueHeader*>(view);
+    uint64_t directoryEnd = header->directoryOffset + (uint64_t)header->chunkCount * sizeof(StarCatalogueEntry);
+    if (memcmp(header->magic, "STAR", 4) != 0 || header->version != VERSION ||
+        header->chunkSize <= 0.0f || directoryEnd > viewSize) {
+        DebugPrint("StarCatalogue: %s is not a version %u catalogue\n", path, VERSION);
+        Close();
+        return false;
+    }
+
+    directory = reinterpret_cast<const StarCatalogueEntry*>(view + header->directoryOffset);
+    return true;
+}
+
+void StarCatalogue::Close() {
+    if (view) {
+        UnmapViewOfFile(view);
+        view = nullptr;
+    }
+    if (mapping) {
+        CloseHandle(mapping);
+        mapping = nullptr;
+    }
+    if (file != INVALID_HANDLE_VALUE) {
+        CloseHandle(file);
+        file = INVALID_HANDLE_VALUE;
+    }
+    viewSize = 0;
+    header = nullptr;
+    directory = nullptr;
+}
+
+bool StarCatalogue::ReadChunk(const ChunkKey& key, std::vector<PackedStar>& stars) const {
+    if (!IsOpen()) return false;
+
+    const StarCatalogueEntry* end = directory + header->chunkCount;
+    const StarCatalogueEntry* entry = std::lower_bound(directory, end, key, EntryLess);
+    if (entry == end || entry->x != key.x || entry->y != key.y || entry->z != key.z) {
+        return false;
+    }
+
+    uint32_t n = entry->starCount;
+    if (entry->dataOffset + (uint64_t)n * BYTES_PER_STAR > viewSize) return false;
+
+    const uint16_t* px = reinterpret_cast<const uint16_t*>(view + entry->dataOffset);
+    const uint16_t* py = px + n;
+    const uint16_t* pz = py + n;
+    const uint16_t* rgb565 = pz + n;
+    const uint8_t* brightness = reinterpret_cast<const uint8_t*>(rgb565 + n);
+    const uint8_t* size = brightness + n;
+
+    stars.resize(n);
+    for (uint32_t i = 0; i < n; i++) {
+        PackedStar& star = stars[i];
+        star.x = px[i];
+        star.y = py[i];
+        star.z = pz[i];
+        star.rgb565 = rgb565[i];
+        star.brightness = brightness[i];
+        star.size = size[i];
+    }
+    return true;
+}
+
+bool StarCatalogue::Bake(const char* path, float chunkSize, const std::vector<BakedChunk>& chunks) {
+    FILE* out = nullptr;
+    if (fopen_s(&out, path, "wb") != 0 || !out) {
+        DebugPrint("StarCatalogue: can't write %s\n", path);
+        return false;
+    }
+
+    std::vector<const BakedChunk*> sorted;
+    for (const BakedChunk& chunk : chunks) {
+        sorted.push_back(&chunk);
+    }
+    std::sort(sorted.begin(), sorted.end(),
+        [](const BakedChunk* a, const BakedChunk* b) { return a->key < b->key; });
+
+    // Star data first, the directory goes at the end once offsets are known
+    std::vector<StarCatalogueEntry> entries;
+    std::vector<uint8_t> data;
+    uint64_t offset = sizeof(StarCatalogueHeader);
+
+    for (const BakedChunk* chunk : sorted) {
+        uint32_t n = (uint32_t)chunk->stars.size();
+
+        data.assign((size_t)n * BYTES_PER_STAR, 0);
+        uint16_t* px = reinterpret_cast<uint16_t*>(data.data());
+        uint16_t* py = px + n;
+        uint16_t* pz = py + n;
+        uint16_t* rgb565 = pz + n;
+        uint8_t* brightness = reinterpret_cast<uint8_t*>(rgb565 + n);
+        uint8_t* size = brightness + n;
+
+        for (uint32_t i = 0; i < n; i++) {
+            const PackedStar& star = chunk->stars[i];
+            px[i] = star.x;
+            py[i] = star.y;
+            pz[i] = star.z;
+            rgb565[i] = star.rgb565;
+            brightness[i] = star.brightness;
+            size[i] = star.size;
+        }
+
+        // Keep every chunk's uint16 arrays aligned
+        data.resize((data.size() + 7) & ~(size_t)7, 0);
+
+        StarCatalogueEntry entry = { chunk->key.x, chunk->key.y, chunk->key.z, n, offset };
+        entries.push_back(entry);
+
+        _fseeki64(out, (__int64)offset, SEEK_SET);
+        fwrite(data.data(), 1, data.size(), out);
+        offset += data.size();
+    }
+
+    StarCatalogueHeader header = {};
+    memcpy(header.magic, "STAR", 4);
+    header.version = VERSION;
+    header.chunkSize = chunkSize;
+    header.chunkCount = (uint32_t)entries.size();
+    header.directoryOffset = offset;
+
+    _fseeki64(out, (__int64)offset, SEEK_SET);
+    fwrite(entries.data(), sizeof(StarCatalogueEntry), entries.size(), out);
+    _fseeki64(out, 0, SEEK_SET);
+    fwrite(&header, sizeof(header), 1, out);
+
+    bool ok = ferror(out) == 0;
+    fclose(out);
+    if (!ok) {
+        DebugPrint("StarCatalogue: error writing %s\n", path);
+    }
+    return ok;
+}
@@ -0,0 +1,73 @@
+//------------------------------------------------------------------------
+// StarCatalogue.h
+//------------------------------------------------------------------------
+#ifndef STAR_CATALOGUE_H
+#define STAR_CATALOGUE_H
+
+#include <windows.h>
+#include <vector>
+#include <cstdint>
+#include "Star.h"
+
+// Pre-baked galaxy region on disk. Layout:
+//   Header
+//   Directory, one entry per chunk, sorted by chunk key
+//   Star data, per chunk as structure of arrays of the PackedStar fields:
+//     uint16 x[n], y[n], z[n]    position relative to the chunk origin
+//     uint16 rgb565[n]
+//     uint8  brightness[n], size[n]
+// The file is mapped read only, chunks are gathered straight from the view.
+struct StarCatalogueHeader {
+    char magic[4];          // "STAR"
+    uint32_t version;
+    float chunkSize;
+    uint32_t chunkCount;
+    uint64_t directoryOffset;
+};
+
+struct StarCatalogueEntry {
+    int32_t x, y, z;
+    uint32_t starCount;
+    uint64_t dataOffset;
+};
+
+class StarCatalogue {
+public:
+    static const uint32_t VERSION = 2;
+    static const int BYTES_PER_STAR = 4 * sizeof(uint16_t) + 2;
+
+    struct BakedChunk {
+        ChunkKey key;
+        std::vector<PackedStar> stars;
+    };
+
+    StarCatalogue();
+    ~StarCatalogue();
+
+    bool Open(const char* path);
+    void Close();
+    bool IsOpen() const { return view != nullptr; }
+
+    float GetChunkSize() const { return header ? header->chunkSize : 0.0f; }
+    int GetChunkCount() const { return header ? (int)header->chunkCount : 0; }
+
+    // Returns false if the chunk is not in the catalogue
+    bool ReadChunk(const ChunkKey& key, std::vector<PackedStar>& stars) const;
+
+    // Offline baker, chunkSize is the one the stars were packed with
+    static bool Bake(const char* path, float chunkSize, const std::vector<BakedChunk>& chunks);
+
+private:
+    StarCatalogue(const StarCatalogue&) = delete;
+    StarCatalogue& operator=(const StarCatalogue&) = delete;
+
+    HANDLE file;
+    HANDLE mapping;
+    const uint8_t* view;
+    uint64_t viewSize;
+
+    const StarCatalogueHeader* header;
+    const StarCatalogueEntry* directory;
+};
+
+#endif
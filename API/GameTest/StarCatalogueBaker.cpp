@@ -0,0 +1,32 @@
+//------------------------------------------------------------------------
+// StarCatalogueBaker.cpp
+//------------------------------------------------------------------------
+#include "stdafx.h"
+#include "StarCatalogueBaker.h"
+#include "Galaxy.h"
+#include <DebugUtils.h>
+#include <stdlib.h>
+#include <chrono>
+#include <windows.h>
+
+static int bakeRadius = -1;    // Negative means the galaxy's render distance
+
+void StarCatalogueBaker::ConfigureFromEnvironment() {
+    bakeRadius = HeadlessRun::GetInt("GAMETEST_CATALOGUE_BAKE_RADIUS", bakeRadius);
+}
+
+bool StarCatalogueBaker::Run(const char* bakePath, const HeadlessRun::Context& context) {
+    Galaxy* galaxy = context.galaxy;
+
+    int radius = bakeRadius >= 0 ? bakeRadius : galaxy->GetSettings().renderDistance;
+    ChunkKey center = { 0, 0, 0 };
+
+    auto start = std::chrono::steady_clock::now();
+    bool ok = galaxy->BakeCatalogue(bakePath, center, radius);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    int side = 2 * radius + 1;
+    DebugPrint("StarCatalogueBaker: %s %d chunks to %s in %.1f ms\n",
+        ok ? "baked" : "failed to bake", side * side * side, bakePath, ms);
+    return ok;
+}
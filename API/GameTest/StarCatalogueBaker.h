@@ -0,0 +1,23 @@
+//------------------------------------------------------------------------
+// StarCatalogueBaker.h
+//------------------------------------------------------------------------
+#ifndef STAR_CATALOGUE_BAKER_H
+#define STAR_CATALOGUE_BAKER_H
+
+#include "HeadlessRun.h"
+
+// Offline star catalogue baker. Generates every chunk in a cube around
+// the origin chunk with the game's galaxy settings, including galaxy.ini,
+// and writes them to a catalogue the galaxy can stream from instead.
+// A headless run (see HeadlessRun.h) failing if the bake does. It runs
+// once Init has made the game's galaxy:
+//   GAMETEST_CATALOGUE_BAKE_PATH    catalogue file to write, enables the baker
+//   GAMETEST_CATALOGUE_BAKE_RADIUS  chunks in each direction, default the render distance
+class StarCatalogueBaker {
+public:
+    // Settings besides GAMETEST_CATALOGUE_BAKE_PATH
+    static void ConfigureFromEnvironment();
+    static bool Run(const char* bakePath, const HeadlessRun::Context& context);
+};
+
+#endif
@@ -0,0 +1,26 @@
+//------------------------------------------------------------------------
+// TextBenchmark.h
+//------------------------------------------------------------------------
+#ifndef TEXT_BENCHMARK_H
+#define TEXT_BENCHMARK_H
+
+#include "HeadlessRun.h"
+
+// Renders the HUD with the debug lines shown through two UI systems, one
+// drawing with glutBitmapCharacter and one with its fonts baked into the
+// glyph atlas, and writes the glyphs and text draw calls of each. The FPS
+// line changes every frame so the layer is rebuilt instead of replayed.
+// A headless run, see HeadlessRun.h:
+//   GAMETEST_TEXT_BENCH_REPORT  report file, enables the benchmark
+//   GAMETEST_TEXT_BENCH_FRAMES  frames rendered per mode, default 100
+class TextBenchmark {
+public:
+    // Settings besides GAMETEST_TEXT_BENCH_REPORT
+    static void ConfigureFromEnvironment();
+
+    // False if the atlas couldn't be baked or the two modes drew different
+    // glyphs. Call it before the first frame is cleared, like BakeFonts.
+    static bool Run(const char* reportPath, const HeadlessRun::Context& context);
+};
+
+#endif
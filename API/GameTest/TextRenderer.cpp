@@ -0,0 +1,242 @@
+//------------------------------------------------------------------------
+// TextRenderer.cpp
+//------------------------------------------------------------------------
+#include "stdafx.h"
+#include "TextRenderer.h"
+#include "GLStateCache.h"
+#include "Viewport.h"
+#include <glut/include/GL/freeglut.h>
+#include <algorithm>
+
+TextRenderer::TextRenderer() : texture(0), pixelScale(1.0f) {
+}
+
+TextRenderer::~TextRenderer() {
+    if (texture) {
+        glDeleteTextures(1, &texture);
+    }
+}
+
+const TextRenderer::Font* TextRenderer::FindFont(void* font) const {
+    for (const Font& candidate : fonts) {
+        if (candidate.font == font) return &candidate;
+    }
+    return nullptr;
+}
+
+bool TextRenderer::Bake(void* const* fontList, int fontCount, GLStateCache& gl) {
+    if (texture) {
+        glDeleteTextures(1, &texture);
+        texture = 0;
+    }
+    fonts.clear();
+
+    // Shelf pack the glyph cells, u0/v0 hold the cell's pixel position
+    // until the atlas size is known
+    int penX = 0, penY = 0, rowHeight = 0;
+    fonts.resize(fontCount);
+    for (int f = 0; f < fontCount; f++) {
+        Font& font = fonts[f];
+        int lineHeight = glutBitmapHeight(fontList[f]);
+        font.font = fontList[f];
+        font.height = lineHeight + 2 * GLYPH_PADDING;
+        font.descent = lineHeight / 4 + GLYPH_PADDING;
+
+        for (int i = 0; i < GLYPH_COUNT; i++) {
+            Glyph& glyph = font.glyphs[i];
+            glyph.advance = glutBitmapWidth(font.font, FIRST_GLYPH + i);
+            glyph.width = glyph.advance + 2 * GLYPH_PADDING;
+            if (penX + glyph.width > ATLAS_WIDTH) {
+                penX = 0;
+                penY += rowHeight;
+                rowHeight = 0;
+            }
+            glyph.u0 = (float)penX;
+            glyph.v0 = (float)penY;
+            penX += glyph.width;
+            rowHeight = std::max(rowHeight, font.height);
+        }
+    }
+    int usedHeight = penY + rowHeight;
+    int atlasHeight = 1;
+    while (atlasHeight < usedHeight) atlasHeight *= 2;
+
+    const Viewport& viewport = Viewport::GetInstance();
+    int windowWidth = viewport.GetWindowWidth();
+    int windowHeight = viewport.GetWindowHeight();
+    if (ATLAS_WIDTH > windowWidth || atlasHeight > windowHeight) {
+        fonts.clear();
+        return false;
+    }
+
+    // Draw every glyph white on black in window pixels
+    GLfloat clearColor[4];
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+
+    glViewport(0, 0, windowWidth, windowHeight);
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadIdentity();
+    glOrtho(0, windowWidth, 0, windowHeight, -1, 1);
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glLoadIdentity();
+
+    gl.Disable(GL_DEPTH_TEST);
+    gl.Disable(GL_LIGHTING);
+    gl.Disable(GL_TEXTURE_2D);
+    gl.Disable(GL_BLEND);
+    gl.Color(1.0f, 1.0f, 1.0f);
+
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    for (const Font& font : fonts) {
+        for (int i = 0; i < GLYPH_COUNT; i++) {
+            const Glyph& glyph = font.glyphs[i];
+            glRasterPos2i((int)glyph.u0 + GLYPH_PADDING, (int)glyph.v0 + font.descent);
+            glutBitmapCharacter(font.font, FIRST_GLYPH + i);
+        }
+    }
+
+    std::vector<uint8_t> pixels(ATLAS_WIDTH * atlasHeight, 0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadBuffer(GL_BACK);
+    glReadPixels(0, 0, ATLAS_WIDTH, usedHeight, GL_RED, GL_UNSIGNED_BYTE, pixels.data());
+
+    glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+    glPopMatrix();
+    viewport.Apply();
+
+    // Rows come back bottom up, which is also how GL addresses textures
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA, ATLAS_WIDTH, atlasHeight, 0, GL_ALPHA, GL_UNSIGNED_BYTE, pixels.data());
+
+    for (Font& font : fonts) {
+        for (Glyph& glyph : font.glyphs) {
+            float x = glyph.u0;
+            float y = glyph.v0;
+            glyph.u0 = x / ATLAS_WIDTH;
+            glyph.u1 = (x + glyph.width) / ATLAS_WIDTH;
+            glyph.v0 = y / atlasHeight;
+            glyph.v1 = (y + font.height) / atlasHeight;
+        }
+    }
+    return true;
+}
+
+void TextRenderer::Begin() {
+    vertices.clear();
+    bitmapTexts.clear();
+    frameStats = Stats();
+}
+
+void TextRenderer::AddText(const std::string& text, float x, float y, float r, float g, float b, void* font) {
+    size_t start = vertices.size();
+    if (!BuildText(text, x, y, r, g, b, font, vertices)) {
+        bitmapTexts.push_back({ text, x, y, r, g, b, font });
+        return;
+    }
+    frameStats.glyphs += (int)(vertices.size() - start) / 4;
+}
+
+void TextRenderer::AddVertices(const std::vector<TextVertex>& quads) {
+    vertices.insert(vertices.end(), quads.begin(), quads.end());
+    frameStats.glyphs += (int)quads.size() / 4;
+}
+
+bool TextRenderer::BuildText(const std::string& text, float x, float y, float r, float g, float b, void* font,
+    std::vector<TextVertex>& out) const {
+    const Font* baked = FindFont(font);
+    if (!baked) return false;
+
+    uint8_t red = (uint8_t)(std::min(std::max(r, 0.0f), 1.0f) * 255.0f + 0.5f);
+    uint8_t green = (uint8_t)(std::min(std::max(g, 0.0f), 1.0f) * 255.0f + 0.5f);
+    uint8_t blue = (uint8_t)(std::min(std::max(b, 0.0f), 1.0f) * 255.0f + 0.5f);
+
+    // Cell edges relative to the pen, in UI units
+    float top = y - (baked->height - baked->descent) * pixelScale;
+    float bottom = y + baked->descent * pixelScale;
+    float penX = x;
+    for (char c : text) {
+        int index = (unsigned char)c - FIRST_GLYPH;
+        if (index < 0 || index >= GLYPH_COUNT) continue;
+
+        const Glyph& glyph = baked->glyphs[index];
+        if (c != ' ') {
+            float left = penX - GLYPH_PADDING * pixelScale;
+            float right = left + glyph.width * pixelScale;
+            out.push_back({ left, top, glyph.u0, glyph.v1, red, green, blue, 255 });
+            out.push_back({ right, top, glyph.u1, glyph.v1, red, green, blue, 255 });
+            out.push_back({ right, bottom, glyph.u1, glyph.v0, red, green, blue, 255 });
+            out.push_back({ left, bottom, glyph.u0, glyph.v0, red, green, blue, 255 });
+        }
+        penX += glyph.advance * pixelScale;
+    }
+    return true;
+}
+
+float TextRenderer::GetTextWidth(const std::string& text, void* font) const {
+    const Font* baked = FindFont(font);
+    float width = 0.0f;
+    for (char c : text) {
+        int index = (unsigned char)c - FIRST_GLYPH;
+        if (index < 0 || index >= GLYPH_COUNT) continue;
+        width += baked ? baked->glyphs[index].advance : glutBitmapWidth(font, c);
+    }
+    return width * pixelScale;
+}
+
+void TextRenderer::Flush(GLStateCache& gl) {
+    gl.Disable(GL_DEPTH_TEST);
+    gl.Disable(GL_LIGHTING);
+
+    if (!vertices.empty()) {
+        gl.Enable(GL_TEXTURE_2D);
+        gl.Enable(GL_BLEND);
+        gl.BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glBindTexture(GL_TEXTURE_2D, texture);
+
+        const TextVertex* data = vertices.data();
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        glEnableClientState(GL_COLOR_ARRAY);
+        glVertexPointer(2, GL_FLOAT, sizeof(TextVertex), &data->x);
+        glTexCoordPointer(2, GL_FLOAT, sizeof(TextVertex), &data->u);
+        glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(TextVertex), &data->r);
+
+        glDrawArrays(GL_QUADS, 0, (GLsizei)vertices.size());
+        frameStats.drawCalls++;
+
+        glDisableClientState(GL_COLOR_ARRAY);
+        glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+        glDisableClientState(GL_VERTEX_ARRAY);
+
+        // The current colour is undefined after drawing with a colour array
+        gl.InvalidateColor();
+        gl.Disable(GL_TEXTURE_2D);
+    }
+
+    // Fonts missing from the atlas, one glBitmap per character
+    for (const BitmapText& text : bitmapTexts) {
+        gl.Color(text.r, text.g, text.b);
+        glRasterPos2f(text.x, text.y);
+        for (char c : text.text) {
+            glutBitmapCharacter(text.font, c);
+            frameStats.drawCalls++;
+            if (c != ' ') frameStats.glyphs++;   // Counted like the atlas, which has no quad for spaces
+        }
+    }
+
+    stats = frameStats;
+}
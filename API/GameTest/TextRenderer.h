@@ -0,0 +1,102 @@
+//------------------------------------------------------------------------
+// TextRenderer.h
+//------------------------------------------------------------------------
+#ifndef TEXT_RENDERER_H
+#define TEXT_RENDERER_H
+
+#include <windows.h>
+#include <GL/gl.h>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+class GLStateCache;
+
+// Draws text from a glyph atlas. GLUT bitmap fonts are rasterised once into
+// an alpha texture, after which each frame's text is a single batch of
+// textured quads instead of one glBitmap per character.
+class TextRenderer {
+public:
+    struct Stats {
+        int glyphs = 0;
+        int drawCalls = 0;      // One per flush, or one per glyph without an atlas
+    };
+
+    struct TextVertex {
+        float x, y;
+        float u, v;
+        uint8_t r, g, b, a;
+    };
+
+    TextRenderer();
+    ~TextRenderer();
+
+    // Renders the printable ASCII glyphs of each font into the back buffer,
+    // reads them back and uploads them as one texture. Call it before the
+    // frame is cleared. Fonts not baked, or everything if the window is
+    // smaller than the atlas, fall back to glutBitmapCharacter.
+    bool Bake(void* const* fonts, int fontCount, GLStateCache& gl);
+    bool IsBaked() const { return texture != 0; }
+
+    // Virtual units per window pixel, so glyphs stay pixel sized like
+    // glutBitmapCharacter draws them
+    void SetPixelScale(float scale) { pixelScale = scale; }
+    float GetPixelScale() const { return pixelScale; }
+
+    // x, y is the start of the baseline in UI coordinates, y down
+    void Begin();
+    void AddText(const std::string& text, float x, float y, float r, float g, float b, void* font);
+    // Appends the quads for text to out so callers can keep them between
+    // frames. Returns false, adding nothing, if the font isn't in the atlas.
+    bool BuildText(const std::string& text, float x, float y, float r, float g, float b, void* font,
+        std::vector<TextVertex>& out) const;
+    // Queues quads made by BuildText at the current pixel scale
+    void AddVertices(const std::vector<TextVertex>& quads);
+    float GetTextWidth(const std::string& text, void* font) const;
+    void Flush(GLStateCache& gl);
+
+    // Counts for the last flushed frame
+    const Stats& GetStats() const { return stats; }
+
+private:
+    TextRenderer(const TextRenderer&) = delete;
+    TextRenderer& operator=(const TextRenderer&) = delete;
+
+    static const int FIRST_GLYPH = 32;
+    static const int GLYPH_COUNT = 95;      // ' ' to '~'
+    static const int GLYPH_PADDING = 1;     // Pixels around each glyph for overhangs
+    static const int ATLAS_WIDTH = 512;
+
+    struct Glyph {
+        float u0, v0, u1, v1;
+        int width;          // Cell width in pixels, padding included
+        int advance;        // Pen movement in pixels
+    };
+
+    struct Font {
+        void* font;
+        int height;         // Cell height in pixels
+        int descent;        // Pixels of the cell below the baseline
+        Glyph glyphs[GLYPH_COUNT];
+    };
+
+    // Text whose font isn't in the atlas, drawn with glutBitmapCharacter
+    struct BitmapText {
+        std::string text;
+        float x, y;
+        float r, g, b;
+        void* font;
+    };
+
+    const Font* FindFont(void* font) const;
+
+    std::vector<Font> fonts;
+    std::vector<TextVertex> vertices;
+    std::vector<BitmapText> bitmapTexts;
+    GLuint texture;
+    float pixelScale;
+    Stats frameStats;
+    Stats stats;
+};
+
+#endif
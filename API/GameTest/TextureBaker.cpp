@@ -0,0 +1,77 @@
+//------------------------------------------------------------------------
+// TextureBaker.cpp
+//------------------------------------------------------------------------
+#include "stdafx.h"
+#include "TextureBaker.h"
+#include <App/TextureLoader.h>
+#include <DebugUtils.h>
+#include <string.h>
+#include <chrono>
+#include <windows.h>
+
+static CTextureContainer::eFormat bakeFormat = CTextureContainer::FORMAT_BC3;
+
+static const int BAKE_THREADS = 4;
+static const char* const IMAGE_PATTERNS[] = { "*.png", "*.jpg", "*.bmp", "*.tga" };
+
+void TextureBaker::ConfigureFromEnvironment() {
+    char value[32];
+    if (HeadlessRun::GetString("GAMETEST_TEXTURE_BAKE_FORMAT", value, sizeof(value))) {
+        if (_stricmp(value, "rgba") == 0) bakeFormat = CTextureContainer::FORMAT_RGBA8;
+        else if (_stricmp(value, "bc1") == 0) bakeFormat = CTextureContainer::FORMAT_BC1;
+        else bakeFormat = CTextureContainer::FORMAT_BC3;
+    }
+}
+
+std::vector<std::string> TextureBaker::FindImages(const std::string& directory) {
+    std::vector<std::string> files;
+    for (const char* pattern : IMAGE_PATTERNS) {
+        WIN32_FIND_DATAA found;
+        HANDLE search = FindFirstFileA((directory + "\\" + pattern).c_str(), &found);
+        if (search == INVALID_HANDLE_VALUE) continue;
+        do {
+            if (!(found.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+                files.push_back(directory + "\\" + found.cFileName);
+            }
+        } while (FindNextFileA(search, &found));
+        FindClose(search);
+    }
+    return files;
+}
+
+int TextureBaker::BakeDirectory(const std::string& directory, const std::string& targetDirectory,
+    CTextureContainer::eFormat format, int threads) {
+    CTextureLoader loader;
+    loader.Initialize(threads);
+    for (const std::string& file : FindImages(directory)) {
+        loader.QueueDecode(file);
+    }
+    loader.WaitForDecodes();
+    std::vector<CTextureLoader::sDecodedImage> images;
+    loader.TakeDecoded(images);
+    loader.Shutdown();
+
+    int written = 0;
+    for (const CTextureLoader::sDecodedImage& image : images) {
+        std::string target = CTextureContainer::GetContainerName(image.m_fileName);
+        if (!targetDirectory.empty()) {
+            target = targetDirectory + target.substr(target.find_last_of("\\/"));
+        }
+        if (CTextureContainer::Write(target.c_str(), image, format)) {
+            written++;
+        }
+        else {
+            DebugPrint("TextureBaker: can't bake %s\n", image.m_fileName.c_str());
+        }
+    }
+    return written;
+}
+
+bool TextureBaker::Run(const char* bakeDirectory, const HeadlessRun::Context& context) {
+    auto start = std::chrono::steady_clock::now();
+    int images = (int)FindImages(bakeDirectory).size();
+    int written = BakeDirectory(bakeDirectory, "", bakeFormat, BAKE_THREADS);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    DebugPrint("TextureBaker: baked %d of %d containers from %s in %.1f ms\n", written, images, bakeDirectory, ms);
+    return written > 0 && written == images;
+}
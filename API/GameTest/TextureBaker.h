@@ -0,0 +1,33 @@
+//------------------------------------------------------------------------
+// TextureBaker.h
+//------------------------------------------------------------------------
+#ifndef TEXTURE_BAKER_H
+#define TEXTURE_BAKER_H
+
+#include "HeadlessRun.h"
+#include <App/TextureContainer.h>
+#include <string>
+#include <vector>
+
+// Offline converter from source images to .stex containers. Every image in
+// a directory is decoded and mipmapped on CTextureLoader workers, then
+// written beside its source, which CTextureManager then loads instead.
+// A headless run (see HeadlessRun.h) failing if any image isn't baked:
+//   GAMETEST_TEXTURE_BAKE_DIR      directory to convert, enables the baker
+//   GAMETEST_TEXTURE_BAKE_FORMAT   rgba, bc1 or bc3, default bc3
+class TextureBaker {
+public:
+    // Settings besides GAMETEST_TEXTURE_BAKE_DIR
+    static void ConfigureFromEnvironment();
+    static bool Run(const char* bakeDirectory, const HeadlessRun::Context& context);
+
+    // Bakes the images into targetDirectory, or beside them if it's empty.
+    // Returns how many containers were written.
+    static int BakeDirectory(const std::string& directory, const std::string& targetDirectory,
+        CTextureContainer::eFormat format, int threads);
+
+    // Full paths of the .png, .jpg, .bmp and .tga files in a directory
+    static std::vector<std::string> FindImages(const std::string& directory);
+};
+
+#endif
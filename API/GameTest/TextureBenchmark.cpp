@@ -0,0 +1,207 @@
+//------------------------------------------------------------------------
+// TextureBenchmark.cpp
+//------------------------------------------------------------------------
+#include "stdafx.h"
+#include "TextureBenchmark.h"
+#include "TextureBaker.h"
+#include <App/TextureLoader.h>
+#include <App/TextureContainer.h>
+#include <stb_image/stb_image.h>
+#include <glut/include/GL/freeglut.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <windows.h>
+
+static char imageDirectory[MAX_PATH] = ".\\TestData";
+static int maxThreads = 8;
+
+void TextureBenchmark::ConfigureFromEnvironment() {
+    if (!HeadlessRun::GetString("GAMETEST_TEXTURE_BENCH_DIR", imageDirectory, sizeof(imageDirectory))) {
+        strcpy_s(imageDirectory, ".\\TestData");
+    }
+    maxThreads = HeadlessRun::GetInt("GAMETEST_TEXTURE_BENCH_THREADS", maxThreads);
+    if (maxThreads < 1) maxThreads = 1;
+}
+
+struct TextureResult {
+    int threads;
+    double ms;          // Queueing the first file to the last decode finishing
+    int decoded;
+    int failed;
+    double megabytes;   // Mip chains produced
+    double megapixels;  // Source pixels decoded
+};
+
+static TextureResult DecodeAll(const std::vector<std::string>& files, int threads) {
+    TextureResult result = { threads, 0.0, 0, 0, 0.0, 0.0 };
+    CTextureLoader loader;
+    loader.Initialize(threads);
+
+    auto start = std::chrono::steady_clock::now();
+    for (const std::string& file : files) {
+        loader.QueueDecode(file);
+    }
+    loader.WaitForDecodes();
+    result.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<CTextureLoader::sDecodedImage> images;
+    loader.TakeDecoded(images);
+    loader.Shutdown();
+    for (const CTextureLoader::sDecodedImage& image : images) {
+        if (!image.m_ok) {
+            result.failed++;
+            continue;
+        }
+        result.decoded++;
+        result.megabytes += image.m_pixels.size() / (1024.0 * 1024.0);
+        result.megapixels += (double)image.m_width * image.m_height / 1e6;
+    }
+    return result;
+}
+
+struct StartupResult {
+    const char* method;
+    double ms;          // Loading every image into a mipmapped texture
+    int loaded;
+    double diskMegabytes;
+};
+
+static GLuint NewTexture() {
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    return texture;
+}
+
+static double FileMegabytes(const std::string& file) {
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesExA(file.c_str(), GetFileExInfoStandard, &data)) return 0.0;
+    return (((uint64_t)data.nFileSizeHigh << 32) | data.nFileSizeLow) / (1024.0 * 1024.0);
+}
+
+// What CSimpleSprite used to do on the GL thread: decode, then let GLU
+// resample and mipmap
+static StartupResult LoadSources(const std::vector<std::string>& files) {
+    StartupResult result = { "source", 0.0, 0, 0.0 };
+    std::vector<GLuint> textures;
+    auto start = std::chrono::steady_clock::now();
+    for (const std::string& file : files) {
+        int width, height, channels;
+        unsigned char* pixels = stbi_load(file.c_str(), &width, &height, &channels, 4);
+        if (!pixels) continue;
+        textures.push_back(NewTexture());
+        gluBuild2DMipmaps(GL_TEXTURE_2D, 4, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+        stbi_image_free(pixels);
+        result.loaded++;
+    }
+    glFinish();
+    result.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    glDeleteTextures((GLsizei)textures.size(), textures.data());
+    for (const std::string& file : files) {
+        result.diskMegabytes += FileMegabytes(file);
+    }
+    return result;
+}
+
+static StartupResult LoadContainers(const char* method, const std::vector<std::string>& files,
+    const std::string& directory) {
+    StartupResult result = { method, 0.0, 0, 0.0 };
+    std::vector<std::string> containers;
+    for (const std::string& file : files) {
+        std::string name = CTextureContainer::GetContainerName(file);
+        containers.push_back(directory + name.substr(name.find_last_of("\\/")));
+    }
+
+    std::vector<GLuint> textures;
+    auto start = std::chrono::steady_clock::now();
+    for (const std::string& file : containers) {
+        CTextureContainer container;
+        if (!container.Open(file.c_str())) continue;
+        textures.push_back(NewTexture());
+        container.Upload();
+        result.loaded++;
+    }
+    glFinish();
+    result.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    glDeleteTextures((GLsizei)textures.size(), textures.data());
+    for (const std::string& file : containers) {
+        result.diskMegabytes += FileMegabytes(file);
+        DeleteFileA(file.c_str());
+    }
+    return result;
+}
+
+// Source images against containers baked from them in each format, baked
+// into the temp directory beforehand so only loading is timed
+static std::vector<StartupResult> TimeStartup(const std::vector<std::string>& files) {
+    std::vector<StartupResult> results;
+    results.push_back(LoadSources(files));
+
+    char tempPath[MAX_PATH];
+    DWORD length = GetTempPathA(sizeof(tempPath), tempPath);
+    std::string directory = length ? std::string(tempPath, length - 1) : std::string(".");
+    static const struct {
+        const char* method;
+        CTextureContainer::eFormat format;
+    } formats[] = {
+        { "stex rgba", CTextureContainer::FORMAT_RGBA8 },
+        { "stex bc1", CTextureContainer::FORMAT_BC1 },
+        { "stex bc3", CTextureContainer::FORMAT_BC3 },
+    };
+    for (const auto& format : formats) {
+        TextureBaker::BakeDirectory(imageDirectory, directory, format.format, maxThreads);
+        results.push_back(LoadContainers(format.method, files, directory));
+    }
+    return results;
+}
+
+bool TextureBenchmark::Run(const char* reportPath, const HeadlessRun::Context& context) {
+    std::vector<std::string> files = TextureBaker::FindImages(imageDirectory);
+    std::vector<TextureResult> results;
+    if (!files.empty()) {
+        for (int threads = 1; ; threads *= 2) {
+            if (threads > maxThreads) threads = maxThreads;
+            results.push_back(DecodeAll(files, threads));
+            if (threads == maxThreads) break;
+        }
+    }
+    std::vector<StartupResult> startup;
+    if (!files.empty()) {
+        startup = TimeStartup(files);
+    }
+
+    FILE* out = HeadlessRun::OpenReport(reportPath);
+    if (!out) return false;
+
+    fprintf(out, "directory=%s\n", imageDirectory);
+    fprintf(out, "images=%d\n", (int)files.size());
+    if (!results.empty()) {
+        fprintf(out, "decoded=%d failed=%d\n", results[0].decoded, results[0].failed);
+        fprintf(out, "source=%.2f MP, mip chains=%.2f MB\n", results[0].megapixels, results[0].megabytes);
+    }
+
+    fprintf(out, "\n%8s %12s %12s %12s %10s\n", "threads", "total ms", "images/s", "MP/s", "speedup");
+    for (const TextureResult& result : results) {
+        double seconds = result.ms / 1000.0;
+        fprintf(out, "%8d %12.3f %12.1f %12.2f %10.2f\n", result.threads, result.ms,
+            seconds > 0.0 ? result.decoded / seconds : 0.0,
+            seconds > 0.0 ? result.megapixels / seconds : 0.0,
+            result.ms > 0.0 ? results[0].ms / result.ms : 0.0);
+    }
+
+    fprintf(out, "\nstartup, s3tc %s\n", CTextureContainer::IsCompressionSupported() ? "uploaded compressed" : "unpacked on load");
+    fprintf(out, "%-12s %12s %12s %12s %10s\n", "method", "total ms", "ms/image", "disk MB", "speedup");
+    for (const StartupResult& result : startup) {
+        fprintf(out, "%-12s %12.3f %12.3f %12.2f %10.2f\n", result.method, result.ms,
+            result.loaded ? result.ms / result.loaded : 0.0, result.diskMegabytes,
+            result.ms > 0.0 ? startup[0].ms / result.ms : 0.0);
+    }
+    fclose(out);
+    return true;
+}
@@ -0,0 +1,24 @@
+//------------------------------------------------------------------------
+// TextureBenchmark.h
+//------------------------------------------------------------------------
+#ifndef TEXTURE_BENCHMARK_H
+#define TEXTURE_BENCHMARK_H
+
+#include "HeadlessRun.h"
+// Decodes every image in a directory with CTextureLoader's workers, mip
+// chains included, at 1, 2, 4... threads up to a maximum and writes the
+// throughput of each. That part doesn't touch GL, so the numbers are the CPU
+// side of loading alone. Then it times loading the images into textures the
+// old way, decode plus gluBuild2DMipmaps, against .stex containers baked from
+// them in each format. A headless run, see HeadlessRun.h:
+//   GAMETEST_TEXTURE_BENCH_REPORT    report file, enables the benchmark
+//   GAMETEST_TEXTURE_BENCH_DIR       image directory, default .\TestData
+//   GAMETEST_TEXTURE_BENCH_THREADS   most worker threads, default 8
+class TextureBenchmark {
+public:
+    // Settings besides GAMETEST_TEXTURE_BENCH_REPORT
+    static void ConfigureFromEnvironment();
+    static bool Run(const char* reportPath, const HeadlessRun::Context& context);
+};
+
+#endif
@@ -0,0 +1,147 @@
+//------------------------------------------------------------------------
+// UIBenchmark.cpp
+//------------------------------------------------------------------------
+#include "stdafx.h"
+#include "UIBenchmark.h"
+#include "UISystem.h"
+#include <App/AppSettings.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <chrono>
+#include <algorithm>
+#include <windows.h>
+
+static int buttonCount = 10000;
+static int queryCount = 100000;
+
+static const unsigned int SEED = 1234;
+static const float BUTTON_GAP = 0.2f;   // Fraction of each layout cell left empty
+
+void UIBenchmark::ConfigureFromEnvironment() {
+    buttonCount = HeadlessRun::GetInt("GAMETEST_UI_BENCH_BUTTONS", buttonCount);
+    queryCount = HeadlessRun::GetInt("GAMETEST_UI_BENCH_QUERIES", queryCount);
+    if (buttonCount < 1) buttonCount = 1;
+    if (queryCount < 1) queryCount = 1;
+}
+
+static double MillisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool UIBenchmark::Run(const char* reportPath, const HeadlessRun::Context& context) {
+    Renderer3D* renderer = context.renderer;
+
+    // A grid of buttons filling the virtual screen, like an inventory page
+    UISystem ui(renderer);
+    int columns = (int)ceilf(sqrtf((float)buttonCount * APP_VIRTUAL_WIDTH / APP_VIRTUAL_HEIGHT));
+    int rows = (buttonCount + columns - 1) / columns;
+    float cellWidth = (float)APP_VIRTUAL_WIDTH / columns;
+    float cellHeight = (float)APP_VIRTUAL_HEIGHT / rows;
+
+    // Buttons also note their position in handles while a click is being
+    // checked, not while clicks are timed
+    int clicks = 0;
+    std::vector<int>* clickedButtons = nullptr;
+    std::vector<UIButtonHandle> handles;
+    handles.reserve(buttonCount);
+    for (int i = 0; i < buttonCount; i++) {
+        float x = (i % columns) * cellWidth;
+        float y = (i / columns) * cellHeight;
+        handles.push_back(ui.AddButton("", x, y, cellWidth * (1.0f - BUTTON_GAP), cellHeight * (1.0f - BUTTON_GAP),
+            [&clicks, &clickedButtons, i]() {
+                clicks++;
+                if (clickedButtons) clickedButtons->push_back(i);
+            }));
+    }
+
+    srand(SEED);
+    std::vector<float> points(queryCount * 2);
+    for (float& point : points) {
+        point = (float)rand() / RAND_MAX;
+    }
+    for (int i = 0; i < queryCount; i++) {
+        points[i * 2] *= APP_VIRTUAL_WIDTH;
+        points[i * 2 + 1] *= APP_VIRTUAL_HEIGHT;
+    }
+
+    // The first event builds the index
+    auto start = std::chrono::steady_clock::now();
+    ui.HandleMouseMove(-1.0f, -1.0f);
+    double buildMs = MillisecondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < queryCount; i++) {
+        ui.HandleMouseMove(points[i * 2], points[i * 2 + 1]);
+    }
+    double moveMs = MillisecondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < queryCount; i++) {
+        ui.HandleMouseClick(points[i * 2], points[i * 2 + 1]);
+    }
+    double clickMs = MillisecondsSince(start);
+
+    // What every event used to cost, a test against each button
+    int linearHits = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < queryCount; i++) {
+        for (UIButtonHandle handle : handles) {
+            if (ui.Get(handle)->IsPointInside(points[i * 2], points[i * 2 + 1])) linearHits++;
+        }
+    }
+    double linearMs = MillisecondsSince(start);
+
+    // Every query has to click and hover exactly the buttons the scan finds
+    int mismatchedQueries = 0;
+    std::vector<int> clicked, expected;
+    clickedButtons = &clicked;
+    for (int i = 0; i < queryCount; i++) {
+        float x = points[i * 2];
+        float y = points[i * 2 + 1];
+        clicked.clear();
+        expected.clear();
+        ui.HandleMouseMove(x, y);
+        ui.HandleMouseClick(x, y);
+
+        bool hoverMatches = true;
+        for (int j = 0; j < buttonCount; j++) {
+            const UIButton* button = ui.Get(handles[j]);
+            bool inside = button->IsPointInside(x, y);
+            if (inside) expected.push_back(j);
+            if (button->isHovered != inside) hoverMatches = false;
+        }
+        std::sort(clicked.begin(), clicked.end());
+        if (!hoverMatches || clicked != expected) mismatchedQueries++;
+    }
+    clickedButtons = nullptr;
+
+    const UIHitIndex& index = ui.GetHitIndex();
+    std::vector<int> hits;
+    long long visited = 0;
+    for (int i = 0; i < queryCount; i++) {
+        hits.clear();
+        visited += index.Query(points[i * 2], points[i * 2 + 1], hits);
+    }
+
+    FILE* out = HeadlessRun::OpenReport(reportPath);
+    if (!out) return false;
+
+    double toMicroseconds = 1000.0 / queryCount;
+    fprintf(out, "buttons=%d\n", buttonCount);
+    fprintf(out, "queries=%d\n", queryCount);
+    fprintf(out, "index_nodes=%d\n", index.GetNodeCount());
+    fprintf(out, "index_depth=%d\n", index.GetDepth());
+    fprintf(out, "index_build_ms=%.3f\n", buildMs);
+    fprintf(out, "nodes_visited_avg=%.1f\n", (double)visited / queryCount);
+    fprintf(out, "hits=%d\n", linearHits);
+    fprintf(out, "mismatched_queries=%d\n", mismatchedQueries);
+    fprintf(out, "consistent=%s\n", mismatchedQueries == 0 ? "yes" : "no");
+
+    fprintf(out, "\n%-16s %12s %10s\n", "method", "us/event", "speedup");
+    fprintf(out, "%-16s %12.3f %10.2f\n", "linear scan", linearMs * toMicroseconds, 1.0);
+    fprintf(out, "%-16s %12.3f %10.2f\n", "index hover", moveMs * toMicroseconds, moveMs > 0.0 ? linearMs / moveMs : 0.0);
+    fprintf(out, "%-16s %12.3f %10.2f\n", "index click", clickMs * toMicroseconds, clickMs > 0.0 ? linearMs / clickMs : 0.0);
+    fclose(out);
+    return mismatchedQueries == 0;
+}
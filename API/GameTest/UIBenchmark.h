@@ -0,0 +1,25 @@
+//------------------------------------------------------------------------
+// UIBenchmark.h
+//------------------------------------------------------------------------
+#ifndef UI_BENCHMARK_H
+#define UI_BENCHMARK_H
+
+#include "HeadlessRun.h"
+
+// Lays out a screen full of buttons and times hover and click resolution
+// through the UISystem hit index against a linear scan of every button,
+// checking that every query hovers and clicks exactly the buttons the scan
+// finds. Nothing is drawn. A headless run, see HeadlessRun.h:
+//   GAMETEST_UI_BENCH_REPORT   report file, enables the benchmark
+//   GAMETEST_UI_BENCH_BUTTONS  buttons on screen, default 10000
+//   GAMETEST_UI_BENCH_QUERIES  cursor positions tested, default 100000
+class UIBenchmark {
+public:
+    // Settings besides GAMETEST_UI_BENCH_REPORT
+    static void ConfigureFromEnvironment();
+
+    // False if any query's hovered or clicked buttons differ from the scan
+    static bool Run(const char* reportPath, const HeadlessRun::Context& context);
+};
+
+#endif
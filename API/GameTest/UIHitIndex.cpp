@@ -0,0 +1,100 @@
+//------------------------------------------------------------------------
+// UIHitIndex.cpp
+//------------------------------------------------------------------------
+#include "stdafx.h"
+#include "UIHitIndex.h"
+#include <algorithm>
+
+static inline bool Contains(const UIHitIndex::Rect& rect, float x, float y) {
+    return x >= rect.minX && x <= rect.maxX && y >= rect.minY && y <= rect.maxY;
+}
+
+void UIHitIndex::Build(const std::vector<Rect>& newRects) {
+    rects = newRects;
+    order.resize(rects.size());
+    for (int i = 0; i < (int)order.size(); i++) {
+        order[i] = i;
+    }
+
+    nodes.clear();
+    depth = 0;
+    if (rects.empty()) return;
+
+    // Median splits leave at least LEAF_SIZE / 2 rectangles per leaf, so
+    // there are fewer than 4n / LEAF_SIZE nodes
+    nodes.reserve(4 * rects.size() / LEAF_SIZE + 1);
+    nodes.push_back(Node());
+    BuildNode(0, 0, (int)rects.size(), 1);
+}
+
+void UIHitIndex::Clear() {
+    rects.clear();
+    order.clear();
+    nodes.clear();
+    depth = 0;
+}
+
+// Fills in nodes[index] for order[begin, end), splitting at the median
+// centre along the longer side of the bounds
+void UIHitIndex::BuildNode(int index, int begin, int end, int level) {
+    depth = std::max(depth, level);
+
+    Rect bounds = rects[order[begin]];
+    for (int i = begin + 1; i < end; i++) {
+        const Rect& rect = rects[order[i]];
+        bounds.minX = std::min(bounds.minX, rect.minX);
+        bounds.minY = std::min(bounds.minY, rect.minY);
+        bounds.maxX = std::max(bounds.maxX, rect.maxX);
+        bounds.maxY = std::max(bounds.maxY, rect.maxY);
+    }
+    nodes[index].bounds = bounds;
+
+    if (end - begin <= LEAF_SIZE || level >= MAX_DEPTH) {
+        nodes[index].first = begin;
+        nodes[index].count = end - begin;
+        return;
+    }
+
+    bool splitX = bounds.maxX - bounds.minX >= bounds.maxY - bounds.minY;
+    int middle = begin + (end - begin) / 2;
+    std::nth_element(order.begin() + begin, order.begin() + middle, order.begin() + end,
+        [&](int a, int b) {
+            const Rect& ra = rects[a];
+            const Rect& rb = rects[b];
+            return splitX ? ra.minX + ra.maxX < rb.minX + rb.maxX : ra.minY + ra.maxY < rb.minY + rb.maxY;
+        });
+
+    // Children sit next to each other so an inner node only stores the first
+    int children = (int)nodes.size();
+    nodes[index].first = children;
+    nodes[index].count = 0;
+    nodes.push_back(Node());
+    nodes.push_back(Node());
+    BuildNode(children, begin, middle, level + 1);
+    BuildNode(children + 1, middle, end, level + 1);
+}
+
+int UIHitIndex::Query(float x, float y, std::vector<int>& hits) const {
+    if (nodes.empty()) return 0;
+
+    int stack[MAX_DEPTH + 1];
+    int stackSize = 0;
+    int visited = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0) {
+        const Node& node = nodes[stack[--stackSize]];
+        visited++;
+        if (!Contains(node.bounds, x, y)) continue;
+
+        if (node.count > 0) {
+            for (int i = node.first; i < node.first + node.count; i++) {
+                if (Contains(rects[order[i]], x, y)) hits.push_back(order[i]);
+            }
+        }
+        else {
+            stack[stackSize++] = node.first;
+            stack[stackSize++] = node.first + 1;
+        }
+    }
+    return visited;
+}
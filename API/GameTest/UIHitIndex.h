@@ -0,0 +1,51 @@
+//------------------------------------------------------------------------
+// UIHitIndex.h
+//------------------------------------------------------------------------
+#ifndef UI_HIT_INDEX_H
+#define UI_HIT_INDEX_H
+
+#include <vector>
+
+// Bounding volume hierarchy over screen rectangles for hover and click
+// tests. It's built once from the current layout and then answers point
+// queries by descending only into boxes that contain the point, so a query
+// touches O(log n) nodes when the rectangles don't pile up on each other.
+class UIHitIndex {
+public:
+    struct Rect {
+        float minX, minY, maxX, maxY;
+    };
+
+    // Replaces the index. Query reports rectangles by their position here.
+    void Build(const std::vector<Rect>& rects);
+    void Clear();
+
+    // Appends the ids of every rectangle containing the point, edges
+    // included. Returns how many nodes were visited.
+    int Query(float x, float y, std::vector<int>& hits) const;
+
+    int GetRectCount() const { return (int)rects.size(); }
+    int GetNodeCount() const { return (int)nodes.size(); }
+    int GetDepth() const { return depth; }
+
+private:
+    static const int LEAF_SIZE = 4;
+    static const int MAX_DEPTH = 64;    // Query stack size, median splits stay far below
+
+    // Children of an inner node are nodes[first] and nodes[first + 1].
+    // A leaf's rectangles are order[first .. first + count).
+    struct Node {
+        Rect bounds;
+        int first;
+        int count;      // 0 for inner nodes
+    };
+
+    void BuildNode(int index, int begin, int end, int level);
+
+    std::vector<Rect> rects;
+    std::vector<int> order;
+    std::vector<Node> nodes;
+    int depth = 0;
+};
+
+#endif
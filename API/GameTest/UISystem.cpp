@@ -6,6 +6,10 @@
 #include "Renderer3D.h"
 #include <glut/include/GL/glut.h>
 #include <App/AppSettings.h>
+#include "Viewport.h"
+#include <chrono>
+#include <algorithm>
+#include <stdarg.h>
 
 UIText::UIText(const std::string& txt, float xPos, float yPos, float red, float green, float blue) {
     text = txt;
@@ -18,35 +22,88 @@ UIText::UIText(const std::string& txt, float xPos, float yPos, float red, float
     font = GLUT_BITMAP_HELVETICA_12;
 }
 
-void UIText::Render() {
-    if (!visible) return;
+void UIText::SetText(const char* newText) {
+    if (text == newText) return;
+    text = newText;
+    quadsValid = false;
+    MarkDirty();
+}
+
+void UIText::SetColor(float red, float green, float blue) {
+    if (r == red && g == green && b == blue) return;
+    r = red;
+    g = green;
+    b = blue;
+    quadsValid = false;
+    MarkDirty();
+}
 
-    // Save current GL states
-    glPushAttrib(GL_ALL_ATTRIB_BITS);
+void UIText::SetFont(void* newFont) {
+    if (font == newFont) return;
+    font = newFont;
+    quadsValid = false;
+    MarkDirty();
+}
+
+void UIText::InvalidateQuads() {
+    quadsValid = false;
+    MarkDirty();
+}
+
+void UIText::BeginText() {
+    pendingText.clear();
+}
+
+void UIText::AppendText(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(nullptr, 0, format, args);
+    va_end(args);
+    if (length <= 0) return;
+
+    // resize keeps room for the terminator vsnprintf writes
+    size_t start = pendingText.size();
+    pendingText.resize(start + length);
+    va_start(args, format);
+    vsnprintf(&pendingText[start], (size_t)length + 1, format, args);
+    va_end(args);
+}
 
-    // Disable depth test and lighting for consistent text rendering
-    glDisable(GL_DEPTH_TEST);
-    glDisable(GL_LIGHTING);
-    glDisable(GL_TEXTURE_2D);
+void UIText::EndText() {
+    boundFormat = nullptr;
+    if (pendingText == text) return;
+    text.swap(pendingText);
+    quadsValid = false;
+    MarkDirty();
+}
 
-    // Set blending for text
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+void UIText::Render(TextRenderer& textRenderer) {
+    if (!visible) return;
 
     // For bold effect, render the text multiple times with slight offsets
     const int BOLD_OFFSET = 2;
-    for (int i = 0; i < BOLD_OFFSET; i++) {
-        // Set color and position with slight offset for bold effect
-        glColor3f(r, g, b);
-        glRasterPos2f(x + i, y);
 
-        for (char c : text) {
-            glutBitmapCharacter(font, c);
+    // Rebuild the quads only when the text, position or scale moved on
+    float scale = textRenderer.GetPixelScale();
+    if (!quadsValid || quadsX != x || quadsY != y || quadsScale != scale) {
+        quads.clear();
+        quadsInAtlas = true;
+        for (int i = 0; i < BOLD_OFFSET && quadsInAtlas; i++) {
+            quadsInAtlas = textRenderer.BuildText(text, x + i, y, r, g, b, font, quads);
         }
+        quadsValid = true;
+        quadsX = x;
+        quadsY = y;
+        quadsScale = scale;
     }
 
-    // Restore previous GL states
-    glPopAttrib();
+    if (quadsInAtlas) {
+        textRenderer.AddVertices(quads);
+        return;
+    }
+    for (int i = 0; i < BOLD_OFFSET; i++) {
+        textRenderer.AddText(text, x + i, y, r, g, b, font);
+    }
 }
 
 UIButton::UIButton(const std::string& txt, float xPos, float yPos, float w, float h, std::function<void()> callback) {
@@ -63,82 +120,68 @@ UIButton::UIButton(const std::string& txt, float xPos, float yPos, float w, floa
     b = 0.7f;
 }
 
-void UIButton::Render() {
-    if (!visible) return;
-
-    // Draw button background
-    glColor3f(r, g, b);
-    glBegin(GL_QUADS);
-    glVertex2f(x, y);
-    glVertex2f(x + width, y);
-    glVertex2f(x + width, y + height);
-    glVertex2f(x, y + height);
-    glEnd();
-
-    // Draw button border
-    if (isHovered) {
-        glColor3f(1.0f, 1.0f, 1.0f);
-    }
-    else {
-        glColor3f(0.5f, 0.5f, 0.5f);
-    }
-    glBegin(GL_LINE_LOOP);
-    glVertex2f(x, y);
-    glVertex2f(x + width, y);
-    glVertex2f(x + width, y + height);
-    glVertex2f(x, y + height);
-    glEnd();
-
-    // Draw text
-    glColor3f(0.0f, 0.0f, 0.0f);
-    float textX = x + (width - text.length() * 8) / 2;  // Center text
-    float textY = y + (height - 12) / 2;  // Center text
-    glRasterPos2f(textX, textY);
-    for (char c : text) {
-        glutBitmapCharacter(GLUT_BITMAP_HELVETICA_12, c);
-    }
+bool UIButton::IsPointInside(float px, float py) const {
+    return (px >= x && px <= x + width && py >= y && py <= y + height);
 }
 
-bool UIButton::IsPointInside(float px, float py) {
-    return (px >= x && px <= x + width && py >= y && py <= y + height);
+UIPanel::UIPanel(float xPos, float yPos, float w, float h, float red, float green, float blue, float alpha) {
+    x = xPos;
+    y = yPos;
+    width = w;
+    height = h;
+    r = red;
+    g = green;
+    b = blue;
+    a = alpha;
+    visible = true;
 }
 
 UISystem::UISystem(Renderer3D* renderer) : renderer3D(renderer) {
 }
 
 UISystem::~UISystem() {
-    for (auto element : elements) {
-        delete element;
+    if (layerList) {
+        glDeleteLists(layerList, 1);
     }
-    elements.clear();
 }
 
-UIText* UISystem::AddText(const std::string& text, float x, float y, float r, float g, float b) {
-    UIText* textElement = new UIText(text, x, y, r, g, b);
-    elements.push_back(textElement);
-    return textElement;
+UITextHandle UISystem::AddText(const std::string& text, float x, float y, float r, float g, float b) {
+    return texts.Add(UIText(text, x, y, r, g, b));
 }
 
-UIText* UISystem::AddBoldText(const std::string& text, float x, float y, float r, float g, float b, void* font) {
-    UIText* textElement = new UIText(text, x, y, r, g, b);
-    textElement->font = font;
-    elements.push_back(textElement);
-    return textElement;
+UITextHandle UISystem::AddBoldText(const std::string& text, float x, float y, float r, float g, float b, void* font) {
+    UIText textElement(text, x, y, r, g, b);
+    textElement.SetFont(font);
+    return texts.Add(std::move(textElement));
 }
 
-UIButton* UISystem::AddButton(const std::string& text, float x, float y,
+UIButtonHandle UISystem::AddButton(const std::string& text, float x, float y,
     float width, float height, std::function<void()> callback) {
-    UIButton* button = new UIButton(text, x, y, width, height, callback);
-    elements.push_back(button);
-    return button;
+    hitIndexStale = true;
+    return buttons.Add(UIButton(text, x, y, width, height, callback));
 }
 
-void UISystem::RemoveElement(UIElement* element) {
-    auto it = std::find(elements.begin(), elements.end(), element);
-    if (it != elements.end()) {
-        delete* it;
-        elements.erase(it);
-    }
+UIPanelHandle UISystem::AddPanel(float x, float y, float width, float height, float r, float g, float b, float a) {
+    return panels.Add(UIPanel(x, y, width, height, r, g, b, a));
+}
+
+void UISystem::Remove(UITextHandle handle) {
+    if (!texts.Has(handle)) return;
+    texts.Remove(handle);
+    layerStale = true;
+}
+
+void UISystem::Remove(UIButtonHandle handle) {
+    if (!buttons.Has(handle)) return;
+    buttons.Remove(handle);
+    layerStale = true;
+    hitIndexStale = true;
+}
+
+void UISystem::Remove(UIPanelHandle handle) {
+    if (!panels.Has(handle)) return;
+    panels.Remove(handle);
+    layerStale = true;
 }
 
 void UISystem::SetupOrthoProjection() {
@@ -146,33 +189,9 @@ void UISystem::SetupOrthoProjection() {
     glPushMatrix();
     glLoadIdentity();
 
-    // Always use virtual resolution for UI
-    const float FIXED_ASPECT = (float)APP_VIRTUAL_WIDTH / (float)APP_VIRTUAL_HEIGHT;
-    float scale = 1.0f;
-
-    // Calculate viewport size and position
-    int windowWidth, windowHeight;
-    windowWidth = glutGet(GLUT_WINDOW_WIDTH);
-    windowHeight = glutGet(GLUT_WINDOW_HEIGHT);
-    float currentAspect = (float)windowWidth / (float)windowHeight;
-
-    int viewportX = 0;
-    int viewportY = 0;
-    int viewportWidth = windowWidth;
-    int viewportHeight = windowHeight;
-
-    if (currentAspect > FIXED_ASPECT) {
-        viewportWidth = (int)(windowHeight * FIXED_ASPECT);
-        viewportX = (windowWidth - viewportWidth) / 2;
-        scale = (float)viewportHeight / APP_VIRTUAL_HEIGHT;
-    }
-    else {
-        viewportHeight = (int)(windowWidth / FIXED_ASPECT);
-        viewportY = (windowHeight - viewportHeight) / 2;
-        scale = (float)viewportWidth / APP_VIRTUAL_WIDTH;
-    }
-
-    glViewport(viewportX, viewportY, viewportWidth, viewportHeight);
+    // Always use virtual resolution for UI. The reshape callback has already
+    // pointed GL at the letterbox.
+    textRenderer.SetPixelScale(1.0f / Viewport::GetInstance().GetScale());
     glOrtho(0, APP_VIRTUAL_WIDTH, APP_VIRTUAL_HEIGHT, 0, -1, 1);
 
     glMatrixMode(GL_MODELVIEW);
@@ -188,45 +207,252 @@ void UISystem::RestorePerspectiveProjection() {
 }
 
 void UISystem::BeginUI() {
-    glDisable(GL_DEPTH_TEST);
+    renderer3D->GetStateCache().Disable(GL_DEPTH_TEST);
     SetupOrthoProjection();
 }
 
 void UISystem::EndUI() {
     RestorePerspectiveProjection();
-    glEnable(GL_DEPTH_TEST);
+    renderer3D->GetStateCache().Enable(GL_DEPTH_TEST);
+}
+
+void UISystem::BakeFonts() {
+    if (fontsBaked) return;
+    const Viewport& viewport = Viewport::GetInstance();
+    if (viewport.GetWindowWidth() == failedBakeWidth && viewport.GetWindowHeight() == failedBakeHeight) return;
+
+    std::vector<void*> fonts = { GLUT_BITMAP_HELVETICA_12 };
+    for (int i = 0; i < texts.Size(); i++) {
+        if (std::find(fonts.begin(), fonts.end(), texts[i].GetFont()) == fonts.end()) {
+            fonts.push_back(texts[i].GetFont());
+        }
+    }
+    fontsBaked = textRenderer.Bake(fonts.data(), (int)fonts.size(), renderer3D->GetStateCache());
+    if (!fontsBaked) {
+        failedBakeWidth = viewport.GetWindowWidth();
+        failedBakeHeight = viewport.GetWindowHeight();
+        return;
+    }
+
+    // Text drawn before the bake kept its per character fallback
+    for (int i = 0; i < texts.Size(); i++) {
+        texts[i].InvalidateQuads();
+    }
+}
+
+// One batch of quads for every visible panel
+void UISystem::RenderPanels(GLStateCache& gl) {
+    if (panels.Size() == 0) return;
+
+    gl.Enable(GL_BLEND);
+    gl.BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glBegin(GL_QUADS);
+    for (int i = 0; i < panels.Size(); i++) {
+        const UIPanel& panel = panels[i];
+        if (!panel.visible) continue;
+
+        gl.Color(panel.r, panel.g, panel.b, panel.a);
+        glVertex2f(panel.x, panel.y);
+        glVertex2f(panel.x + panel.width, panel.y);
+        glVertex2f(panel.x + panel.width, panel.y + panel.height);
+        glVertex2f(panel.x, panel.y + panel.height);
+    }
+    glEnd();
+}
+
+// Backgrounds in one batch of quads, borders in one batch of lines, labels
+// into the text batch
+void UISystem::RenderButtons(GLStateCache& gl) {
+    if (buttons.Size() == 0) return;
+
+    glBegin(GL_QUADS);
+    for (int i = 0; i < buttons.Size(); i++) {
+        const UIButton& button = buttons[i];
+        if (!button.visible) continue;
+
+        gl.Color(button.r, button.g, button.b);
+        glVertex2f(button.x, button.y);
+        glVertex2f(button.x + button.width, button.y);
+        glVertex2f(button.x + button.width, button.y + button.height);
+        glVertex2f(button.x, button.y + button.height);
+    }
+    glEnd();
+
+    glBegin(GL_LINES);
+    for (int i = 0; i < buttons.Size(); i++) {
+        const UIButton& button = buttons[i];
+        if (!button.visible) continue;
+
+        if (button.isHovered) {
+            gl.Color(1.0f, 1.0f, 1.0f);
+        }
+        else {
+            gl.Color(0.5f, 0.5f, 0.5f);
+        }
+        float right = button.x + button.width;
+        float bottom = button.y + button.height;
+        glVertex2f(button.x, button.y);
+        glVertex2f(right, button.y);
+        glVertex2f(right, button.y);
+        glVertex2f(right, bottom);
+        glVertex2f(right, bottom);
+        glVertex2f(button.x, bottom);
+        glVertex2f(button.x, bottom);
+        glVertex2f(button.x, button.y);
+    }
+    glEnd();
+
+    for (int i = 0; i < buttons.Size(); i++) {
+        const UIButton& button = buttons[i];
+        if (!button.visible) continue;
+
+        float textX = button.x + (button.width - textRenderer.GetTextWidth(button.text, GLUT_BITMAP_HELVETICA_12)) / 2;  // Center text
+        float textY = button.y + (button.height - 12) / 2;  // Center text
+        textRenderer.AddText(button.text, textX, textY, 0.0f, 0.0f, 0.0f, GLUT_BITMAP_HELVETICA_12);
+    }
+}
+
+void UISystem::RenderTexts() {
+    for (int i = 0; i < texts.Size(); i++) {
+        texts[i].Render(textRenderer);
+    }
+}
+
+// Calls fn on every element of every pool
+template <typename Fn>
+static void ForEachElement(UIPool<UIText>& texts, UIPool<UIButton>& buttons, UIPool<UIPanel>& panels, Fn fn) {
+    for (int i = 0; i < texts.Size(); i++) fn(texts[i]);
+    for (int i = 0; i < buttons.Size(); i++) fn(buttons[i]);
+    for (int i = 0; i < panels.Size(); i++) fn(panels[i]);
 }
 
 void UISystem::Render() {
+    auto start = std::chrono::steady_clock::now();
     BeginUI();
 
-    for (auto element : elements) {
-        element->Render();
+    GLStateCache& gl = renderer3D->GetStateCache();
+    stats.elements = texts.Size() + buttons.Size() + panels.Size();
+    stats.changedElements = 0;
+    ForEachElement(texts, buttons, panels, [&](UIElement& element) {
+        if (element.HasChanged()) stats.changedElements++;
+    });
+
+    CheckHitLayout();
+
+    // Replay last frame's layer unless an element or the pixel scale changed
+    float scale = textRenderer.GetPixelScale();
+    stats.cached = layerList && !layerStale && stats.changedElements == 0 && layerScale == scale;
+    if (stats.cached) {
+        glCallList(layerList);
+    }
+    else {
+        if (!layerList) layerList = glGenLists(1);
+        layerScale = scale;
+        layerStale = false;
+
+        // Every state call has to reach the list, so the cache can't skip any
+        gl.Invalidate();
+        glNewList(layerList, GL_COMPILE_AND_EXECUTE);
+        gl.Disable(GL_TEXTURE_2D);
+        gl.Disable(GL_LIGHTING);
+        textRenderer.Begin();
+        RenderPanels(gl);
+        RenderButtons(gl);
+        RenderTexts();
+        textRenderer.Flush(gl);
+        glEndList();
+
+        ForEachElement(texts, buttons, panels, [](UIElement& element) {
+            element.ClearChanges();
+        });
     }
+    // The list leaves GL in whatever state its last calls set
+    gl.Invalidate();
 
     EndUI();
+    stats.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Hidden buttons get an inverted rect, which no point is inside
+static UIHitIndex::Rect GetHitRect(const UIButton& button) {
+    if (!button.visible) return { 1.0f, 1.0f, 0.0f, 0.0f };
+    return { button.x, button.y, button.x + button.width, button.y + button.height };
+}
+
+// Marks the hit index stale if any button moved, resized, appeared or
+// disappeared since it was built
+void UISystem::CheckHitLayout() {
+    if (hitIndexStale) return;
+    for (int i = 0; i < buttons.Size(); i++) {
+        UIHitIndex::Rect rect = GetHitRect(buttons[i]);
+        const UIHitIndex::Rect& indexed = hitLayout[i];
+        if (rect.minX != indexed.minX || rect.minY != indexed.minY ||
+            rect.maxX != indexed.maxX || rect.maxY != indexed.maxY) {
+            hitIndexStale = true;
+            return;
+        }
+    }
+}
+
+void UISystem::RebuildHitIndex() {
+    hitIndexStale = false;
+    hitLayout.resize(buttons.Size());
+    hitHandles.clear();
+
+    std::vector<UIHitIndex::Rect> rects;
+    rects.reserve(buttons.Size());
+    for (int i = 0; i < buttons.Size(); i++) {
+        hitLayout[i] = GetHitRect(buttons[i]);
+        if (!buttons[i].visible) continue;
+        rects.push_back(hitLayout[i]);
+        hitHandles.push_back(buttons.HandleAt(i));
+    }
+    hitIndex.Build(rects);
+}
+
+// Fills hitCandidates with the visible buttons containing the point
+void UISystem::FindButtonsAt(float x, float y) {
+    if (hitIndexStale) RebuildHitIndex();
+
+    hitCandidates.clear();
+    hitIds.clear();
+    hitIndex.Query(x, y, hitIds);
+    for (int id : hitIds) {
+        hitCandidates.push_back(hitHandles[id]);
+    }
 }
 
 void UISystem::HandleMouseMove(float x, float y) {
-    for (auto element : elements) {
-        UIButton* button = dynamic_cast<UIButton*>(element);
-        if (button) {
-            button->isHovered = button->IsPointInside(x, y);
+    FindButtonsAt(x, y);
+
+    // Only the buttons hovered last time and the ones under the cursor can change
+    for (UIButtonHandle handle : hoveredButtons) {
+        UIButton* button = buttons.Get(handle);
+        if (button && std::find(hitCandidates.begin(), hitCandidates.end(), handle) == hitCandidates.end()) {
+            button->isHovered = false;
+            button->MarkDirty();
         }
     }
+    for (UIButtonHandle handle : hitCandidates) {
+        UIButton* button = buttons.Get(handle);
+        if (!button->isHovered) {
+            button->isHovered = true;
+            button->MarkDirty();
+        }
+    }
+    hoveredButtons = hitCandidates;
 }
 
-void UISystem::HandleMouseClick(float x, float y) 
-{
-    for (auto element : elements)
-    {
-        UIButton* button = dynamic_cast<UIButton*>(element);
-        if (button->IsPointInside(x, y))
-        {
-            if (button->onClick)
-            {
-                button->onClick();
-            }
+void UISystem::HandleMouseClick(float x, float y) {
+    // Callbacks may add or remove buttons, so work from a copy and look
+    // each one up again
+    FindButtonsAt(x, y);
+    std::vector<UIButtonHandle> clicked = hitCandidates;
+    for (UIButtonHandle handle : clicked) {
+        UIButton* button = buttons.Get(handle);
+        if (button && button->onClick) {
+            std::function<void()> onClick = button->onClick;
+            onClick();
         }
     }
-}
\ No newline at end of file
+}
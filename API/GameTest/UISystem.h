@@ -7,26 +7,121 @@
 #include <string>
 #include <vector>
 #include <functional>
+#include <utility>
+#include <type_traits>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <include/GL/freeglut_std.h>
+#include "TextRenderer.h"
+#include "UIHitIndex.h"
 
 // Forward declarations
 class Renderer3D;
+class GLStateCache;
 
+// Fields every element type shares. Elements live by value in per type
+// pools, so there is no virtual interface, UISystem draws each type in its
+// own pass.
 struct UIElement {
     float x, y;
     bool visible;
-    virtual void Render() = 0;
-    virtual ~UIElement() {}
+
+    // Change tracking for the cached UI layer. Position and visibility are
+    // compared with what was last drawn, anything else calls MarkDirty.
+    // Hidden elements only count as changed when they're shown or hidden.
+    void MarkDirty() { dirty = true; }
+    bool HasChanged() const {
+        return visible != drawnVisible || (visible && (dirty || x != drawnX || y != drawnY));
+    }
+    void ClearChanges() { dirty = false; drawnX = x; drawnY = y; drawnVisible = visible; }
+
+private:
+    bool dirty = true;
+    float drawnX = 0.0f, drawnY = 0.0f;
+    bool drawnVisible = false;
 };
 
 struct UIText : public UIElement {
     UIText(const std::string& txt, float xPos, float yPos,
         float red = 1.0f, float green = 1.0f, float blue = 1.0f);
-    virtual void Render() override;
-    
-    std::string text;
+    // Adds the text to the shared batch, which is drawn after every element
+    void Render(TextRenderer& textRenderer);
+
+    const std::string& GetText() const { return text; }
+    void SetText(const char* newText);
+    void SetText(const std::string& newText) { SetText(newText.c_str()); }
+
+    // Formats the values into the text. Nothing is formatted if the format
+    // and values are the same as last call, and the element is only marked
+    // changed if the resulting text is different. Values must be numbers
+    // or pointers, strings are compared by address.
+    template <typename... Args>
+    void SetValues(const char* format, Args... args) {
+        uint8_t packed[MAX_BOUND_BYTES];
+        size_t size = 0;
+        bool fits = true;
+        int unpack[] = { 0, (PackValue(packed, size, fits, args), 0)... };
+        (void)unpack;
+
+        if (fits && format == boundFormat && size == boundSize && memcmp(packed, boundValues, size) == 0) {
+            return;
+        }
+        boundFormat = fits ? format : nullptr;
+        boundSize = size;
+        memcpy(boundValues, packed, size);
+
+        char buffer[MAX_FORMATTED_LENGTH];
+        snprintf(buffer, sizeof(buffer), format, args...);
+        SetText(buffer);
+    }
+
+    // Builds the text from a varying number of formatted pieces. They are
+    // formatted straight into a second buffer the element keeps, which is
+    // swapped in by EndText if it differs from the current text. Both
+    // buffers keep their capacity, so a steady HUD line doesn't allocate.
+    void BeginText();
+    void AppendText(const char* format, ...);
+    void EndText();
+
+    // Colour and font are baked into the cached quads, so they're only
+    // changed through these
+    void SetColor(float red, float green, float blue);
+    void SetFont(void* newFont);
+    void* GetFont() const { return font; }
+    // For when the glyph atlas is baked after the quads were built
+    void InvalidateQuads();
+
+private:
+    static const size_t MAX_BOUND_BYTES = 64;
+    static const size_t MAX_FORMATTED_LENGTH = 512;
+
+    template <typename T>
+    static void PackValue(uint8_t* packed, size_t& size, bool& fits, const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "UIText values must be plain data");
+        if (!fits || size + sizeof(T) > MAX_BOUND_BYTES) {
+            fits = false;
+            return;
+        }
+        memcpy(packed + size, &value, sizeof(T));
+        size += sizeof(T);
+    }
+
     float r, g, b;
     void* font;  // GLUT font
+    std::string text;
+    std::string pendingText;   // Filled between BeginText and EndText
+
+    // Last values given to SetValues, a null format means none
+    const char* boundFormat = nullptr;
+    uint8_t boundValues[MAX_BOUND_BYTES];
+    size_t boundSize = 0;
+
+    // Glyph quads for the current text, position and pixel scale
+    std::vector<TextRenderer::TextVertex> quads;
+    bool quadsValid = false;
+    bool quadsInAtlas = false;
+    float quadsX = 0.0f, quadsY = 0.0f, quadsScale = 0.0f;
 };
 
 struct UIButton : public UIElement {
@@ -38,35 +133,194 @@ struct UIButton : public UIElement {
 
     UIButton(const std::string& txt, float xPos, float yPos,
         float w, float h, std::function<void()> callback);
-    virtual void Render() override;
-    bool IsPointInside(float px, float py);
+    bool IsPointInside(float px, float py) const;
+};
+
+// Filled rectangle, drawn underneath buttons and text
+struct UIPanel : public UIElement {
+    float width, height;
+    float r, g, b, a;
+
+    UIPanel(float xPos, float yPos, float w, float h,
+        float red, float green, float blue, float alpha);
+};
+
+//------------------------------------------------------------------------
+// Handle to an element in a UIPool. Slots are reused with a new generation,
+// so a handle to a removed element resolves to null instead of to whatever
+// took its place. The type parameter keeps text and button handles apart.
+//------------------------------------------------------------------------
+template <typename T>
+struct UIHandle {
+    static const uint32_t INVALID_SLOT = 0xFFFFFFFF;
+
+    uint32_t slot = INVALID_SLOT;
+    uint32_t generation = 0;
+
+    explicit operator bool() const { return slot != INVALID_SLOT; }
+    bool operator==(const UIHandle& other) const { return slot == other.slot && generation == other.generation; }
+};
+
+typedef UIHandle<UIText> UITextHandle;
+typedef UIHandle<UIButton> UIButtonHandle;
+typedef UIHandle<UIPanel> UIPanelHandle;
+
+// Elements of one type packed in a contiguous array that render passes walk
+// linearly, with a slot table from handles to array positions. Same scheme
+// as ComponentArray: removing swaps the last element into the hole, which
+// moves it but keeps its handle.
+template <typename T>
+class UIPool {
+public:
+    typedef UIHandle<T> Handle;
+
+    Handle Add(T&& element) {
+        Handle handle;
+        if (!freeSlots.empty()) {
+            handle.slot = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        else {
+            handle.slot = (uint32_t)slots.size();
+            slots.push_back({ INVALID_INDEX, 0 });
+        }
+        handle.generation = slots[handle.slot].generation;
+        slots[handle.slot].index = (uint32_t)dense.size();
+        dense.push_back(std::move(element));
+        denseSlots.push_back(handle.slot);
+        return handle;
+    }
+
+    void Remove(Handle handle) {
+        if (!Has(handle)) return;
+
+        uint32_t index = slots[handle.slot].index;
+        uint32_t last = (uint32_t)dense.size() - 1;
+        if (index != last) {
+            dense[index] = std::move(dense[last]);
+            denseSlots[index] = denseSlots[last];
+            slots[denseSlots[index]].index = index;
+        }
+        dense.pop_back();
+        denseSlots.pop_back();
+
+        slots[handle.slot].index = INVALID_INDEX;
+        slots[handle.slot].generation++;
+        freeSlots.push_back(handle.slot);
+    }
+
+    bool Has(Handle handle) const {
+        return handle.slot < slots.size() && slots[handle.slot].generation == handle.generation &&
+            slots[handle.slot].index != INVALID_INDEX;
+    }
+
+    // Null for stale handles. Adding or removing elements of the same type
+    // can move the rest, so don't keep the pointer.
+    T* Get(Handle handle) { return Has(handle) ? &dense[slots[handle.slot].index] : nullptr; }
+    const T* Get(Handle handle) const { return Has(handle) ? &dense[slots[handle.slot].index] : nullptr; }
+
+    // Linear access for render passes
+    int Size() const { return (int)dense.size(); }
+    T& operator[](int index) { return dense[index]; }
+    const T& operator[](int index) const { return dense[index]; }
+    Handle HandleAt(int index) const { return { denseSlots[index], slots[denseSlots[index]].generation }; }
+
+private:
+    static const uint32_t INVALID_INDEX = 0xFFFFFFFF;
+
+    struct Slot {
+        uint32_t index;         // Position in dense, INVALID_INDEX while free
+        uint32_t generation;
+    };
+
+    std::vector<T> dense;
+    std::vector<uint32_t> denseSlots;
+    std::vector<Slot> slots;
+    std::vector<uint32_t> freeSlots;
 };
 
 class UISystem {
 public:
+    struct Stats {
+        double ms = 0.0;            // CPU time of the last Render
+        int elements = 0;
+        int changedElements = 0;
+        bool cached = false;        // Replayed the layer without rebuilding it
+    };
+
     UISystem(Renderer3D* renderer);
     ~UISystem();
 
     // UI Element Management
-    UIText* AddText(const std::string& text, float x, float y,
+    UITextHandle AddText(const std::string& text, float x, float y,
         float r = 1.0f, float g = 1.0f, float b = 1.0f);
-    UIText* AddBoldText(const std::string& text, float x, float y, float r = 1.0f, float g = 1.0f, float b = 1.0f, void* font = GLUT_BITMAP_HELVETICA_12);
-    UIButton* AddButton(const std::string& text, float x, float y,
+    UITextHandle AddBoldText(const std::string& text, float x, float y, float r = 1.0f, float g = 1.0f, float b = 1.0f, void* font = GLUT_BITMAP_HELVETICA_12);
+    UIButtonHandle AddButton(const std::string& text, float x, float y,
         float width, float height, std::function<void()> callback);
-    void RemoveElement(UIElement* element);
+    UIPanelHandle AddPanel(float x, float y, float width, float height,
+        float r, float g, float b, float a = 1.0f);
+    void Remove(UITextHandle handle);
+    void Remove(UIButtonHandle handle);
+    void Remove(UIPanelHandle handle);
+
+    // Null once the element is removed. The pointer is only good until the
+    // next element of that type is added or removed.
+    UIText* Get(UITextHandle handle) { return texts.Get(handle); }
+    UIButton* Get(UIButtonHandle handle) { return buttons.Get(handle); }
+    UIPanel* Get(UIPanelHandle handle) { return panels.Get(handle); }
 
     // Rendering
+    // Bakes the fonts of the current text elements into the glyph atlas the
+    // first time it's called. A window too small for the atlas is retried
+    // once its size changes. Call it before the frame is cleared.
+    void BakeFonts();
     void Render();
+    const TextRenderer::Stats& GetTextStats() const { return textRenderer.GetStats(); }
+    const Stats& GetStats() const { return stats; }
     void BeginUI();
     void EndUI();
 
     // Input handling
     void HandleMouseMove(float x, float y);
     void HandleMouseClick(float x, float y);
+    const UIHitIndex& GetHitIndex() const { return hitIndex; }
 
 private:
-    std::vector<UIElement*> elements;
+    UIPool<UIText> texts;
+    UIPool<UIButton> buttons;
+    UIPool<UIPanel> panels;
     Renderer3D* renderer3D;
+    TextRenderer textRenderer;
+    bool fontsBaked = false;
+    int failedBakeWidth = -1;   // Window size of the last failed bake
+    int failedBakeHeight = -1;
+
+    // Display list holding the whole layer as last drawn, replayed while no
+    // element changes
+    GLuint layerList = 0;
+    float layerScale = 0.0f;
+    bool layerStale = true;     // An element was removed
+    Stats stats;
+
+    // Hit index over the visible buttons, so mouse events only test the
+    // buttons under the cursor. It's rebuilt when a button is added,
+    // removed, moved, resized, shown or hidden, not when one is hovered.
+    // Layout changes are picked up once per Render.
+    UIHitIndex hitIndex;
+    std::vector<UIButtonHandle> hitHandles;         // Index ids to buttons
+    std::vector<UIHitIndex::Rect> hitLayout;        // Every button's rect when indexed, in pool order
+    bool hitIndexStale = true;
+    std::vector<int> hitIds;
+    std::vector<UIButtonHandle> hoveredButtons;
+    std::vector<UIButtonHandle> hitCandidates;
+
+    void CheckHitLayout();
+    void RebuildHitIndex();
+    void FindButtonsAt(float x, float y);
+
+    void RenderPanels(GLStateCache& gl);
+    void RenderButtons(GLStateCache& gl);
+    void RenderTexts();
 
     void SetupOrthoProjection();
     void RestorePerspectiveProjection();
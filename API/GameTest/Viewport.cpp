@@ -0,0 +1,60 @@
+//------------------------------------------------------------------------
+// Viewport.cpp
+//------------------------------------------------------------------------
+#include "stdafx.h"
+#include "Viewport.h"
+#include <windows.h>
+#include <GL/gl.h>
+#include <App/AppSettings.h>
+#include <algorithm>
+
+Viewport& Viewport::GetInstance() {
+    static Viewport instance;
+    return instance;
+}
+
+Viewport::Viewport() {
+    Resize(APP_INIT_WINDOW_WIDTH, APP_INIT_WINDOW_HEIGHT);
+}
+
+void Viewport::Resize(int newWidth, int newHeight) {
+    // Minimised windows report zero
+    windowWidth = newWidth > 0 ? newWidth : 1;
+    windowHeight = newHeight > 0 ? newHeight : 1;
+
+    // Largest rectangle with the virtual aspect, centred, bars on the long side
+    const float FIXED_ASPECT = (float)APP_VIRTUAL_WIDTH / (float)APP_VIRTUAL_HEIGHT;
+    float currentAspect = (float)windowWidth / (float)windowHeight;
+
+    x = 0;
+    y = 0;
+    width = windowWidth;
+    height = windowHeight;
+    // A very thin window can round the short side down to zero, which
+    // every conversion below divides by
+    if (currentAspect > FIXED_ASPECT) {
+        width = std::max((int)(windowHeight * FIXED_ASPECT), 1);
+        x = (windowWidth - width) / 2;
+        scale = (float)height / APP_VIRTUAL_HEIGHT;
+    }
+    else {
+        height = std::max((int)(windowWidth / FIXED_ASPECT), 1);
+        y = (windowHeight - height) / 2;
+        scale = (float)width / APP_VIRTUAL_WIDTH;
+    }
+}
+
+void Viewport::Apply() const {
+    glViewport(x, y, width, height);
+}
+
+void Viewport::WindowToVirtual(float windowX, float windowY, float& virtualX, float& virtualY) const {
+    float glY = windowHeight - windowY;
+    virtualX = (windowX - x) * APP_VIRTUAL_WIDTH / width;
+    virtualY = (glY - y) * APP_VIRTUAL_HEIGHT / height;
+}
+
+void Viewport::GLToVirtual(float glX, float glY, float& virtualX, float& virtualY) const {
+    virtualX = (glX - x) * APP_VIRTUAL_WIDTH / width;
+    virtualY = APP_VIRTUAL_HEIGHT - (glY - y) * APP_VIRTUAL_HEIGHT / height;
+}
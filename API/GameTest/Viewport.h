@@ -0,0 +1,47 @@
+//------------------------------------------------------------------------
+// Viewport.h
+//------------------------------------------------------------------------
+#ifndef VIEWPORT_H
+#define VIEWPORT_H
+
+// Window size and the letterboxed rectangle the virtual resolution is drawn
+// into. It's updated from the GLUT reshape callback only; everything that
+// maps between window pixels and virtual coordinates reads it instead of
+// asking the window every frame.
+class Viewport {
+public:
+    static Viewport& GetInstance();
+
+    // Recomputes the letterbox for a new window size
+    void Resize(int windowWidth, int windowHeight);
+    // Points GL at the letterbox
+    void Apply() const;
+
+    int GetWindowWidth() const { return windowWidth; }
+    int GetWindowHeight() const { return windowHeight; }
+
+    // Letterbox in window pixels, from the bottom left like glViewport
+    int GetX() const { return x; }
+    int GetY() const { return y; }
+    int GetWidth() const { return width; }
+    int GetHeight() const { return height; }
+
+    // Window pixels per virtual unit
+    float GetScale() const { return scale; }
+
+    // Client area pixel, y down, to virtual coordinates with y up like
+    // App::GetMousePos. Points in the bars land outside 0..APP_VIRTUAL_*.
+    void WindowToVirtual(float windowX, float windowY, float& virtualX, float& virtualY) const;
+    // GL window coordinates, y up as gluProject returns them, to virtual
+    // coordinates with y down like the UI
+    void GLToVirtual(float glX, float glY, float& virtualX, float& virtualY) const;
+
+private:
+    Viewport();
+
+    int windowWidth, windowHeight;
+    int x, y, width, height;
+    float scale;
+};
+
+#endif